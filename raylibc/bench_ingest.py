@@ -0,0 +1,89 @@
+"""Command server ingest benchmark: voxels/sec for JSON lines vs binary frames.
+
+Spawns ./mini3d_host, streams the same terrain as 16x64x16 `chunk` ops in each
+encoding (JSON raw8/rle8 with base64, binary raw8/rle8) and times each run from
+the first byte sent to the `ack` of the trailing `flush`.
+
+    python3 bench_ingest.py [chunks_per_side]    # default 16 -> 256 chunks
+"""
+import base64, json, math, os, struct, subprocess, sys, time
+
+HOST = os.path.abspath("./mini3d_host" + (".exe" if sys.platform.startswith("win") else ""))
+DX, DY, DZ = 16, 64, 16
+
+# binary frame op codes (see cmdserver.c)
+OP_INIT, OP_CHUNK, OP_CLEAR, OP_FLUSH = 1, 5, 7, 8
+
+def frame(op, payload=b""):
+    return struct.pack("<BBI", 0xFF, op, len(payload)) + payload
+
+def chunk_voxels(cx, cz):
+    """Rolling hills: stone, 3 layers of dirt, grass on top (ids 5/3/1), air above."""
+    out = bytearray()
+    for z in range(DZ):
+        hs = [int(24 + 8*math.sin((cx*DX + x)*0.07) + 6*math.cos((cz*DZ + z)*0.05)) for x in range(DX)]
+        for y in range(DY):
+            out += bytes(0 if y >= h else 5 if y < h-4 else 3 if y < h-1 else 1 for h in hs)
+    return bytes(out)
+
+def rle8(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        j = i
+        while j < len(data) and j-i < 255 and data[j] == data[i]:
+            j += 1
+        out += bytes((j-i, data[i]))
+        i = j
+    return bytes(out)
+
+def build_stream(chunks, binary, rle):
+    parts = [frame(OP_CLEAR) if binary else b'{"op":"clear"}\n']
+    for (cx, cz), vox in chunks:
+        data = rle8(vox) if rle else vox
+        if binary:
+            parts.append(frame(OP_CHUNK, struct.pack("<iiiHHHB", cx, cz, 0, DX, DY, DZ, 1 if rle else 0) + data))
+        else:
+            msg = {"op": "chunk", "cx": cx, "cz": cz, "y0": 0, "dims": [DX, DY, DZ],
+                   "encoding": "rle8" if rle else "raw8", "data": base64.b64encode(data).decode()}
+            parts.append(json.dumps(msg, separators=(",", ":")).encode() + b"\n")
+    parts.append(frame(OP_FLUSH) if binary else b'{"op":"flush"}\n')
+    return b"".join(parts)
+
+def wait_for(proc, event):
+    while True:
+        line = proc.stdout.readline()
+        if not line:
+            raise RuntimeError("mini3d_host exited")
+        msg = json.loads(line)
+        if msg.get("event") == "error":
+            print("  host error:", msg.get("msg"))
+        if msg.get("event") == event:
+            return
+
+def main():
+    side = int(sys.argv[1]) if len(sys.argv) > 1 else 16
+    chunks = [((cx, cz), chunk_voxels(cx, cz)) for cz in range(side) for cx in range(side)]
+    nvox = len(chunks)*DX*DY*DZ
+
+    proc = subprocess.Popen([HOST], stdin=subprocess.PIPE, stdout=subprocess.PIPE, bufsize=0)
+    proc.stdin.write(frame(OP_INIT, struct.pack("<iii", side*DX, DY, side*DZ)))
+    wait_for(proc, "ready")
+
+    print(f"{len(chunks)} chunks, {nvox/1e6:.1f}M voxels per run")
+    for binary in (False, True):
+        for rle in (False, True):
+            stream = build_stream(chunks, binary, rle)
+            t0 = time.perf_counter()
+            proc.stdin.write(stream)
+            wait_for(proc, "ack")
+            dt = time.perf_counter() - t0
+            print(f"{'binary' if binary else 'json  '} {'rle8' if rle else 'raw8'}: "
+                  f"{len(stream)/1e6:7.2f} MB  {dt*1000:8.1f} ms  {nvox/dt/1e6:8.1f} Mvox/s")
+
+    proc.stdin.close()
+    proc.terminate()   # the host keeps its window open after the stream ends
+    proc.wait()
+
+if __name__ == "__main__":
+    main()
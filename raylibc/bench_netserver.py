@@ -0,0 +1,209 @@
+"""Dedicated server load test: N simulated clients over TCP loopback.
+
+Spawns ./mini3d_server, connects N clients that subscribe to world replication,
+plus one editor that sends random block writes every tick. Two clients take the
+whole world; the rest send a view (radius in chunks) and walk around, so they
+only get the chunks near them. Every client parses the frame stream; the first
+few also decode it into their own copy of the world (decoding in Python for all
+of them would measure Python, not the server). Reports time to a full snapshot
+(whole world, or the first full interest), bandwidth per client, tick frames
+received, whether the decoded copies match the editor's writes in the chunks
+they hold, and the server's own metrics lines.
+
+    python3 bench_netserver.py [clients] [seconds] [edits_per_tick] [radius]   # default 128 10 200 6
+"""
+import math, os, random, selectors, socket, struct, subprocess, sys, time
+
+SERVER = os.path.abspath("./mini3d_server")
+PORT = 7790
+SX, SY, SZ, HZ = 256, 64, 256, 60
+CS = 16
+VERIFIERS = 4
+WHOLE_WORLD = 2                                       # clients 0..1 take everything
+FRAME_WORLD, FRAME_CHUNK, FRAME_TICK, FRAME_UNLOAD, FRAME_ENTITIES = 0x81, 0x82, 0x83, 0x84, 0x85
+OP_SET = 2
+
+class Client:
+    def __init__(self, sel, decode, radius, rng):
+        self.sock = socket.create_connection(("127.0.0.1", PORT))
+        self.sock.setblocking(False)
+        self.sock.sendall(b'{"op":"subscribe","events":["world"]}\n')
+        self.radius = radius
+        if radius:
+            self.pos = [rng.uniform(0, SX), SY*0.5, rng.uniform(0, SZ)]
+            a = rng.uniform(0, 6.283)
+            self.vel = [6*math.cos(a), 0, 6*math.sin(a)]     # walking speed, voxels/s
+            self.send_view()
+        self.buf = bytearray()
+        self.decode = decode
+        self.world = None
+        self.held = set()
+        self.ticks = 0
+        self.bytes = 0
+        self.entities = 0
+        self.t_start = time.perf_counter()
+        self.t_snapshot = None
+        sel.register(self.sock, selectors.EVENT_READ, self)
+
+    def send_view(self):
+        self.sock.sendall(b'{"op":"view","pos":[%.2f,%.2f,%.2f],"radius":%d}\n' % (*self.pos, self.radius))
+
+    def walk(self, dt):
+        for i in (0, 2):
+            self.pos[i] += self.vel[i]*dt
+            lim = SX if i == 0 else SZ
+            if not 0 <= self.pos[i] < lim:
+                self.vel[i] = -self.vel[i]
+                self.pos[i] = min(max(self.pos[i], 0), lim - 1)
+        self.send_view()
+
+    def interest(self):
+        """Chunks this client should hold once caught up."""
+        ncx, ncy, ncz = -(-SX//CS), -(-SY//CS), -(-SZ//CS)
+        if not self.radius:
+            return {(x, y, z) for x in range(ncx) for y in range(ncy) for z in range(ncz)}
+        ccx, ccz = int(self.pos[0]//CS), int(self.pos[2]//CS)
+        return {(x, y, z) for x in range(ncx) for y in range(ncy) for z in range(ncz)
+                if (x-ccx)**2 + (z-ccz)**2 <= self.radius**2}
+
+    def feed(self, data):
+        self.bytes += len(data)
+        self.buf += data
+        i = 0
+        while len(self.buf) - i >= 6:
+            if self.buf[i] != 0xFF:                      # a JSON line (error replies)
+                j = self.buf.find(b"\n", i)
+                if j < 0: break
+                i = j + 1
+                continue
+            op, n = self.buf[i+1], struct.unpack_from("<I", self.buf, i+2)[0]
+            if len(self.buf) - i < 6 + n: break
+            self.frame(op, memoryview(self.buf)[i+6 : i+6+n])
+            i += 6 + n
+        del self.buf[:i]
+
+    def frame(self, op, p):
+        if op == FRAME_WORLD:
+            self.sx, self.sy, self.sz = struct.unpack_from("<3i", p)
+            self.world = bytearray(2*self.sx*self.sy*self.sz) if self.decode else None
+            self.held = set()
+            self.want = len(self.interest())
+        elif op == FRAME_CHUNK:
+            cx, cy, cz = struct.unpack_from("<3i", p)
+            self.held.add((cx, cy, cz))
+            if self.t_snapshot is None and len(self.held) >= self.want:
+                self.t_snapshot = time.perf_counter() - self.t_start
+            if not self.decode:
+                return
+            x0, y0, z0 = cx*CS, cy*CS, cz*CS
+            dx, dy, dz = min(CS, self.sx-x0), min(CS, self.sy-y0), min(CS, self.sz-z0)
+            vox = bytearray()
+            for k in range(12, len(p), 4):
+                cnt, vid = struct.unpack_from("<HH", p, k)
+                vox += struct.pack("<H", vid) * cnt
+            for z in range(dz):
+                for y in range(dy):
+                    at = 2*(x0 + (y0+y)*self.sx + (z0+z)*self.sx*self.sy)
+                    row = 2*dx*(y + z*dy)
+                    self.world[at : at + 2*dx] = vox[row : row + 2*dx]
+        elif op == FRAME_TICK:
+            self.ticks += 1
+            if not self.decode:
+                return
+            n = struct.unpack_from("<I", p, 8)[0]
+            for k in range(n):
+                x, y, z, vid = struct.unpack_from("<iiiH", p, 12 + 14*k)
+                struct.pack_into("<H", self.world, 2*(x + y*self.sx + z*self.sx*self.sy), vid)
+        elif op == FRAME_UNLOAD:
+            n = struct.unpack_from("<I", p)[0]
+            for k in range(n):
+                self.held.discard(struct.unpack_from("<3i", p, 4 + 12*k))
+        elif op == FRAME_ENTITIES:
+            self.entities = struct.unpack_from("<I", p, 8)[0]
+
+    def get(self, x, y, z):
+        return struct.unpack_from("<H", self.world, 2*(x + y*self.sx + z*self.sx*self.sy))[0]
+
+def pct(xs, p):
+    xs = sorted(xs)
+    return xs[min(len(xs)-1, int(len(xs)*p))] if xs else float("nan")
+
+def main():
+    nclients = int(sys.argv[1]) if len(sys.argv) > 1 else 128
+    seconds = float(sys.argv[2]) if len(sys.argv) > 2 else 10
+    edits = int(sys.argv[3]) if len(sys.argv) > 3 else 200
+    radius = int(sys.argv[4]) if len(sys.argv) > 4 else 6
+
+    srv = subprocess.Popen([SERVER, str(PORT), str(SX), str(SY), str(SZ), str(HZ)],
+                           stderr=subprocess.PIPE, text=True)
+    print(srv.stderr.readline().strip())
+    os.set_blocking(srv.stderr.fileno(), False)
+
+    sel = selectors.DefaultSelector()
+    rng = random.Random(1)
+    clients = [Client(sel, i < VERIFIERS, 0 if i < WHOLE_WORLD else radius, rng) for i in range(nclients)]
+    editor = socket.create_connection(("127.0.0.1", PORT))
+    written = {}
+    t_end = time.perf_counter() + seconds
+    next_edit = next_walk = time.perf_counter()
+    while time.perf_counter() < t_end:
+        if time.perf_counter() >= next_walk:                 # views move 5 times a second
+            for c in clients:
+                if c.radius: c.walk(0.2)
+            next_walk += 0.2
+        if time.perf_counter() >= next_edit:
+            batch = []
+            for _ in range(edits):
+                x, y, z, vid = rng.randrange(SX), rng.randrange(SY), rng.randrange(SZ), rng.randrange(1, 9)
+                written[(x, y, z)] = vid
+                batch.append(struct.pack("<BBIiiiH", 0xFF, OP_SET, 14, x, y, z, vid))
+            editor.sendall(b"".join(batch))
+            next_edit += 1.0/HZ
+        for key, _ in sel.select(timeout=0.001):
+            try:
+                data = key.fileobj.recv(1 << 20)
+            except BlockingIOError:
+                continue
+            if data:
+                key.data.feed(data)
+
+    editor.sendall(b'{"op":"flush"}\n')
+    editor.recv(256)                                  # ack: every edit applied
+    settle = time.perf_counter() + 1.0                # ...and replicated on the next ticks
+    while time.perf_counter() < settle:
+        for key, _ in sel.select(timeout=0.01):
+            data = key.fileobj.recv(1 << 20)
+            if data:
+                key.data.feed(data)
+
+    def matches(c):
+        return c.world is not None and all(c.get(*p) == v for p, v in written.items()
+                                           if (p[0]//CS, p[1]//CS, p[2]//CS) in c.held)
+    snap = [c.t_snapshot for c in clients if c.t_snapshot is not None]
+    verifiers = clients[:VERIFIERS]
+    whole, viewers = [c for c in clients if not c.radius], [c for c in clients if c.radius]
+    print(f"{nclients} clients ({len(viewers)} with a view radius of {radius} chunks), {seconds:.0f} s, "
+          f"{edits} edits/tick ({len(written)} voxels written)")
+    print(f"first full interest: {len(snap)}/{nclients}, p50 {pct(snap,.5)*1000:.0f} ms, p95 {pct(snap,.95)*1000:.0f} ms")
+    for name, group in (("whole world", whole), ("view", viewers)):
+        if group:
+            print(f"received per {name} client: {sum(c.bytes for c in group)/len(group)/1e6:.2f} MB, "
+                  f"{sum(c.ticks for c in group)/len(group):.0f} tick frames, "
+                  f"{sum(len(c.held) for c in group)/len(group):.0f} chunks held")
+    if viewers:
+        caught_up = sum(1 for c in viewers if c.interest() <= c.held)
+        print(f"view clients holding their whole interest: {caught_up}/{len(viewers)}, "
+              f"{sum(c.entities for c in viewers)/len(viewers):.1f} other clients in range on average")
+    print(f"decoded copies matching the editor's writes in held chunks: "
+          f"{sum(1 for c in verifiers if matches(c))}/{len(verifiers)}")
+    print("server:")
+    for line in (srv.stderr.read() or "").strip().splitlines()[-3:]:
+        print("  " + line)
+
+    for c in clients: c.sock.close()
+    editor.close()
+    srv.terminate()
+    srv.wait()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+"""Python binding benchmark: ctypes (libmini3d) vs the mini3d extension module.
+
+Measures calls/sec for fine-grained calls (get_block/set_block) and voxels/sec
+for bulk region reads/writes through each path. Run from the directory holding
+libmini3d.* and the built mini3d extension:
+
+    python3 bench_python.py
+"""
+import array, ctypes as C, os, sys, time
+
+import mini3d
+
+if sys.platform == "darwin":
+    LIB = "./libmini3d.dylib"
+elif sys.platform.startswith("win"):
+    LIB = "./mini3d.dll"
+else:
+    LIB = "./libmini3d.so"
+
+N_CALLS = 200_000
+SX, SY, SZ = 128, 64, 128
+REGION = (0, 0, 0, SX, SY, SZ)
+REPEAT = 20
+
+def rate(fn, count):
+    t0 = time.perf_counter()
+    fn()
+    return count / (time.perf_counter() - t0)
+
+def bench_ctypes():
+    lib = C.CDLL(os.path.abspath(LIB))
+    lib.engine_create.restype = C.c_void_p
+    lib.engine_create.argtypes = [C.c_int, C.c_int, C.c_char_p, C.c_int]
+    lib.engine_destroy.argtypes = [C.c_void_p]
+    lib.engine_create_world.argtypes = [C.c_void_p, C.c_int, C.c_int, C.c_int]
+    lib.engine_create_world.restype = C.c_bool
+    lib.engine_set_block.argtypes = [C.c_void_p, C.c_int, C.c_int, C.c_int, C.c_uint16]
+    lib.engine_set_block.restype = C.c_bool
+    lib.engine_get_block.argtypes = [C.c_void_p, C.c_int, C.c_int, C.c_int]
+    lib.engine_get_block.restype = C.c_uint16
+    region_args = [C.c_void_p] + [C.c_int]*6 + [C.POINTER(C.c_uint16)]
+    lib.engine_read_region.argtypes = region_args
+    lib.engine_write_region.argtypes = region_args
+
+    e = lib.engine_create(320, 240, b"bench ctypes", 0)
+    lib.engine_create_world(e, SX, SY, SZ)
+    get, put = lib.engine_get_block, lib.engine_set_block
+    def gets():
+        for i in range(N_CALLS): get(e, i & 127, 5, 7)
+    def sets():
+        for i in range(N_CALLS): put(e, i & 127, 5, 7, i & 7)
+    buf = (C.c_uint16 * (SX*SY*SZ))()
+    def reads():
+        for _ in range(REPEAT): lib.engine_read_region(e, *REGION, buf)
+    def writes():
+        for _ in range(REPEAT): lib.engine_write_region(e, *REGION, buf)
+    out = (rate(gets, N_CALLS), rate(sets, N_CALLS),
+           rate(reads, REPEAT*SX*SY*SZ), rate(writes, REPEAT*SX*SY*SZ))
+    lib.engine_destroy(e)
+    return out
+
+def bench_extension():
+    eng = mini3d.Engine(320, 240, "bench extension", 0)
+    eng.create_world(SX, SY, SZ)
+    get, put = eng.get_block, eng.set_block
+    def gets():
+        for i in range(N_CALLS): get(i & 127, 5, 7)
+    def sets():
+        for i in range(N_CALLS): put(i & 127, 5, 7, i & 7)
+    buf = array.array("H", bytes(2*SX*SY*SZ))
+    def reads():
+        for _ in range(REPEAT): eng.read_region(*REGION, buf)
+    def writes():
+        for _ in range(REPEAT): eng.write_region(*REGION, buf)
+    out = (rate(gets, N_CALLS), rate(sets, N_CALLS),
+           rate(reads, REPEAT*SX*SY*SZ), rate(writes, REPEAT*SX*SY*SZ))
+    eng.close()
+    return out
+
+def main():
+    rows = [("ctypes", bench_ctypes()), ("extension", bench_extension())]
+    print(f"{'':10} {'get_block/s':>14} {'set_block/s':>14} {'read Mvox/s':>12} {'write Mvox/s':>13}")
+    for name, (g, s, r, w) in rows:
+        print(f"{name:10} {g:14,.0f} {s:14,.0f} {r/1e6:12.0f} {w/1e6:13.0f}")
+
+if __name__ == "__main__":
+    main()
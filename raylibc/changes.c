@@ -0,0 +1,65 @@
+// changes.c — block change feed: a ring of every world mutation, read by cursor.
+//
+// Single voxel writes become BLOCK records with the old and new id; box writes
+// (engine_fill_box, engine_clear_world, chunk payloads) become one BOX record,
+// so a subscriber pays per change, not per voxel. Each record has a sequence
+// number; readers keep their own cursor, so any number of them can follow.
+// A session recording (replay.c) taps the same two calls.
+#include "engine_internal.h"
+
+static EngineChange* change_slot(Engine* e) {
+    EngineChange* c = &e->changes[e->change_seq % CHANGE_RING];
+    memset(c, 0, sizeof(*c));
+    c->seq  = e->change_seq++;
+    c->tick = e->ticks;
+    return c;
+}
+
+void changes_block(Engine* e, int x,int y,int z, uint16_t old_id, uint16_t new_id) {
+    if (e->rec) replay_record_change(e, ENGINE_CHANGE_BLOCK, x,y,z, x,y,z, new_id);
+    if (!e->changes) return;
+    EngineChange* c = change_slot(e);
+    c->kind = ENGINE_CHANGE_BLOCK;
+    c->x0 = c->x1 = x; c->y0 = c->y1 = y; c->z0 = c->z1 = z;
+    c->old_id = old_id; c->new_id = new_id;
+}
+
+void changes_box(Engine* e, int kind, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t new_id) {
+    if (e->rec) replay_record_change(e, kind, x0,y0,z0, x1,y1,z1, new_id);
+    if (!e->changes) return;
+    EngineChange* c = change_slot(e);
+    c->kind = (uint8_t)kind;
+    c->x0 = x0; c->y0 = y0; c->z0 = z0;
+    c->x1 = x1; c->y1 = y1; c->z1 = z1;
+    c->old_id = ENGINE_CHANGE_MIXED;
+    c->new_id = new_id;
+}
+
+void engine_set_change_feed(Engine* e, bool enabled) {
+    if (!e) return;
+    if (enabled && !e->changes) {
+        e->changes = (EngineChange*)malloc(CHANGE_RING*sizeof(EngineChange));
+        // Edits made while the feed was off were never recorded. Skip one seq, so every
+        // cursor taken before now reads as stale (-1) instead of silently missing them.
+        e->change_base = ++e->change_seq;
+    } else if (!enabled) {
+        free(e->changes);
+        e->changes = NULL;
+    }
+}
+
+uint64_t engine_change_cursor(Engine* e) {
+    return e ? e->change_seq : 0;
+}
+
+int engine_read_changes(Engine* e, uint64_t* cursor, EngineChange* out, int max) {
+    if (!e || !cursor || !out || max <= 0 || !e->changes) return 0;
+    uint64_t oldest = e->change_seq > CHANGE_RING ? e->change_seq - CHANGE_RING : 0;
+    if (oldest < e->change_base) oldest = e->change_base;
+    if (*cursor < oldest) { *cursor = oldest; return -1; }   // lost records: resync
+    uint64_t avail = e->change_seq - *cursor;
+    int n = avail < (uint64_t)max ? (int)avail : max;
+    for (int i=0;i<n;i++) out[i] = e->changes[(*cursor + (uint64_t)i) % CHANGE_RING];
+    *cursor += (uint64_t)n;
+    return n;
+}
@@ -0,0 +1,720 @@
+// cmdserver.c — command server for the wire protocol of notes/high-level-wrapper.md.
+//
+// A reader thread parses each message into a WireCmd (resolving palette names,
+// un-base64ing chunk payloads) and pushes it onto a bounded queue. engine_tick
+// drains the queue at the start of the frame within a time budget, so a fast
+// controller never stalls rendering; when the queue is full the reader stops
+// reading and the pipe applies back-pressure. Chunk payloads stay encoded in the
+// queue and are expanded straight into the world array when applied.
+//
+// Two message forms can be mixed freely on the same stream:
+//   - one JSON object per line (protocol v0)
+//   - binary frames: 0xFF, op (OP_* below), u32 payload length, payload.
+//     All fields little-endian:
+//       init        i32 sx, sy, sz
+//       set         i32 x, y, z; u16 id
+//       fill        i32 x0, y0, z0, x1, y1, z1; u16 id
+//       column      i32 x, z, h; u16 id
+//       chunk       i32 cx, cz, y0; u16 dx, dy, dz; u8 encoding (0 raw8, 1 rle8); data
+//       camera_set  f32 x, y, z, yaw, pitch
+//       clear, flush (empty)
+//       subscribe   u32 mask (WIRE_SUB_*)
+//       view        f32 x, y, z; i32 radius (chunks, 0 = whole world)
+//       input       u32 seq; u8 keys (INPUT_*); f32 yaw, pitch, dt
+//     0xFF never starts a JSON text, so the first byte tells the forms apart.
+//
+// Events go out as JSON lines on out_fd: ready, ack, error, quit, and the event
+// ring classes the stream subscribed to (key_down/key_up, mouse_button, player;
+// all three by default). They are queued and written without blocking, so a
+// controller that stops reading loses lines (engine_command_events_dropped)
+// instead of stalling engine_tick. The parser and apply step (wire_*) are shared
+// with the multi-client socket server in sockserver.c.
+#define _POSIX_C_SOURCE 200809L
+#include "engine_internal.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+
+#define CMDQ_CAP       8192     // queued commands before the reader blocks
+#define APPLY_BATCH    256      // commands moved out of the queue per lock
+#define FRAME_MAGIC    0xFF
+#define FRAME_HEADER   6
+#define FRAME_MAX      (64u<<20) // larger frames are treated as a corrupt stream
+#define JSON_LINE_MAX  (FRAME_MAX/3*4 + 4096)   // the same for lines: a frame-sized chunk in base64
+#define OUT_CAP        (1u<<20) // bytes waiting for out_fd; lines past it are dropped
+
+struct CmdServer {
+    int in_fd, out_fd;
+    pthread_t thread;
+    volatile int stop;
+    volatile uint32_t subs;   // WIRE_SUB_* forwarded to out_fd
+
+    pthread_mutex_t qlock;
+    pthread_cond_t  qnot_full;
+    WireCmd* q;          // ring [CMDQ_CAP]
+    int qhead, qcount;
+
+    pthread_mutex_t outlock;
+    char* out;           // [OUT_CAP] lines not yet taken by out_fd (non-blocking)
+    size_t out_len;
+    int out_flags;       // out_fd's file status flags before we started, restored at stop
+    uint32_t out_dropped;
+
+    WireParser parser;   // reader-thread only
+};
+
+// Write what out_fd takes without blocking. Caller holds outlock.
+static void flush_out(CmdServer* s) {
+    size_t done = 0;
+    while (done < s->out_len) {
+        ssize_t w = write(s->out_fd, s->out + done, s->out_len - done);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) done = s->out_len;   // gone: discard
+            break;
+        }
+        done += (size_t)w;
+    }
+    memmove(s->out, s->out + done, s->out_len - done);
+    s->out_len -= done;
+}
+
+// Queue a line for out_fd. Called from engine_tick (replies, events), so it never
+// waits for the controller: a line that does not fit is dropped and counted.
+static void emit(CmdServer* s, const char* line) {
+    size_t n = strlen(line);
+    pthread_mutex_lock(&s->outlock);
+    if (s->out_len + n > OUT_CAP) flush_out(s);
+    if (s->out_len + n > OUT_CAP) s->out_dropped++;
+    else {
+        memcpy(s->out + s->out_len, line, n);
+        s->out_len += n;
+        flush_out(s);
+    }
+    pthread_mutex_unlock(&s->outlock);
+}
+
+static void emit_error(CmdServer* s, const char* msg) {
+    char buf[256];
+    snprintf(buf, sizeof buf, "{\"event\":\"error\",\"msg\":\"%s\"}\n", msg);
+    emit(s, buf);
+}
+
+// ---- tiny JSON reader: just enough for the flat v0 messages ----
+
+typedef struct { const char* p; const char* end; } JP;
+
+static void jp_ws(JP* j) { while (j->p < j->end && (*j->p==' '||*j->p=='\t'||*j->p=='\r'||*j->p=='\n')) j->p++; }
+static bool jp_eat(JP* j, char c) { jp_ws(j); if (j->p < j->end && *j->p == c) { j->p++; return true; } return false; }
+
+// String body as a slice (escapes are skipped over, not decoded: names and base64 never need them).
+static bool jp_slice(JP* j, const char** s, int* n) {
+    if (!jp_eat(j, '"')) return false;
+    const char* b = j->p;
+    while (j->p < j->end && *j->p != '"') { if (*j->p == '\\') j->p++; j->p++; }
+    if (j->p >= j->end) return false;
+    *s = b; *n = (int)(j->p - b);
+    j->p++;
+    return true;
+}
+
+// The token is copied out first: strtod would read past j->end into the next line.
+static bool jp_number(JP* j, double* out) {
+    jp_ws(j);
+    char buf[48];
+    int n = 0;
+    while (j->p + n < j->end && n < (int)sizeof buf - 1 && strchr("+-.0123456789eE", j->p[n]) && j->p[n]) n++;
+    if (!n || n == (int)sizeof buf - 1) return false;
+    memcpy(buf, j->p, n);
+    buf[n] = 0;
+    char* endp;
+    *out = strtod(buf, &endp);
+    if (endp != buf + n || !isfinite(*out)) return false;
+    j->p += n;
+    return true;
+}
+
+static int jp_numbers(JP* j, double* out, int max) {
+    if (!jp_eat(j, '[')) return -1;
+    int n = 0;
+    if (jp_eat(j, ']')) return 0;
+    do {
+        double v;
+        if (!jp_number(j, &v)) return -1;
+        if (n < max) out[n] = v;
+        n++;
+    } while (jp_eat(j, ','));
+    return jp_eat(j, ']') ? n : -1;
+}
+
+static bool jp_skip(JP* j) {
+    jp_ws(j);
+    if (j->p >= j->end) return false;
+    char c = *j->p;
+    if (c == '"') { const char* s; int n; return jp_slice(j, &s, &n); }
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        j->p++;
+        if (jp_eat(j, close)) return true;
+        do {
+            if (c == '{') { const char* s; int n; if (!jp_slice(j, &s, &n) || !jp_eat(j, ':')) return false; }
+            if (!jp_skip(j)) return false;
+        } while (jp_eat(j, ','));
+        return jp_eat(j, close);
+    }
+    while (j->p < j->end && *j->p!=',' && *j->p!='}' && *j->p!=']') j->p++;  // number/true/false/null
+    return true;
+}
+
+static bool key_is(const char* s, int n, const char* k) { return (int)strlen(k) == n && memcmp(s, k, n) == 0; }
+
+static int palette_find(const WireParser* s, const char* name, int n) {
+    for (int i=0;i<s->npalette;i++) if (key_is(name, n, s->palette[i].name)) return s->palette[i].id;
+    return -1;
+}
+
+static void palette_set(WireParser* s, const char* name, int n, uint16_t id) {
+    if (n >= (int)sizeof(s->palette[0].name)) return;
+    for (int i=0;i<s->npalette;i++)
+        if (key_is(name, n, s->palette[i].name)) { s->palette[i].id = id; return; }
+    if (s->npalette == WIRE_PALETTE_MAX) return;
+    memcpy(s->palette[s->npalette].name, name, n);
+    s->palette[s->npalette].name[n] = 0;
+    s->palette[s->npalette++].id = id;
+}
+
+static int b64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+// Base64 -> bytes; returns length or -1.
+static int b64_decode(const char* s, int n, uint8_t* out, int cap) {
+    int len = 0, bits = 0; unsigned acc = 0;
+    for (int i=0;i<n;i++) {
+        if (s[i] == '=') break;
+        int v = b64_value(s[i]);
+        if (v < 0) return -1;
+        acc = (acc << 6) | (unsigned)v; bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (len == cap) return -1;
+            out[len++] = (uint8_t)(acc >> bits);
+        }
+    }
+    return len;
+}
+
+// Casting a double outside the target range is undefined: check first.
+static bool in_range(double v, double lo, double hi) { return v >= lo && v <= hi; }
+static bool all_int(const double* v, int n) {
+    for (int i=0;i<n;i++) if (!in_range(v[i], INT_MIN, INT_MAX)) return false;
+    return true;
+}
+
+// Parse one line into *c. Returns false (reason in s->err) on malformed input.
+static bool parse_line(WireParser* s, const char* line, int len, WireCmd* c) {
+    JP j = { line, line + len };
+    memset(c, 0, sizeof(*c));
+    const char* idname = NULL; int idlen = 0; bool have_id = false; double idnum = 0;
+    const char* data = NULL; int datalen = 0; bool rle = false;
+    double x=0,y=0,z=0,h=0,cx=0,cz=0,y0=0, mn[3]={0}, mx[3]={0}, dims[3]={0}, pos[3]={0}, size[3]={0};
+    double yaw=0, pitch=0, radius=0, seq=0, keys=0, dt=0;
+    uint32_t subs = 0;
+
+    if (!jp_eat(&j, '{')) { s->err = "expected object"; return false; }
+    bool empty = jp_eat(&j, '}');
+    if (!empty) do {
+        const char* k; int kn;
+        if (!jp_slice(&j, &k, &kn) || !jp_eat(&j, ':')) { s->err = "bad key"; return false; }
+        bool ok = true;
+        if (key_is(k,kn,"op")) {
+            const char* v; int vn;
+            ok = jp_slice(&j, &v, &vn);
+            if (ok) {
+                c->op = key_is(v,vn,"init") ? WIRE_OP_INIT : key_is(v,vn,"set") ? WIRE_OP_SET : key_is(v,vn,"fill") ? WIRE_OP_FILL :
+                        key_is(v,vn,"column") ? WIRE_OP_COLUMN : key_is(v,vn,"chunk") ? WIRE_OP_CHUNK :
+                        key_is(v,vn,"camera_set") ? WIRE_OP_CAMERA_SET : key_is(v,vn,"clear") ? WIRE_OP_CLEAR :
+                        key_is(v,vn,"flush") ? WIRE_OP_FLUSH : key_is(v,vn,"subscribe") ? WIRE_OP_SUBSCRIBE :
+                        key_is(v,vn,"view") ? WIRE_OP_VIEW : key_is(v,vn,"input") ? WIRE_OP_INPUT : WIRE_OP_NONE;
+            }
+        }
+        else if (key_is(k,kn,"id")) {
+            jp_ws(&j);
+            have_id = true;
+            ok = (j.p < j.end && *j.p == '"') ? jp_slice(&j, &idname, &idlen) : jp_number(&j, &idnum);
+        }
+        else if (key_is(k,kn,"x"))  ok = jp_number(&j, &x);
+        else if (key_is(k,kn,"y"))  ok = jp_number(&j, &y);
+        else if (key_is(k,kn,"z"))  ok = jp_number(&j, &z);
+        else if (key_is(k,kn,"h"))  ok = jp_number(&j, &h);
+        else if (key_is(k,kn,"cx")) ok = jp_number(&j, &cx);
+        else if (key_is(k,kn,"cz")) ok = jp_number(&j, &cz);
+        else if (key_is(k,kn,"y0")) ok = jp_number(&j, &y0);
+        else if (key_is(k,kn,"yaw"))   ok = jp_number(&j, &yaw);
+        else if (key_is(k,kn,"pitch")) ok = jp_number(&j, &pitch);
+        else if (key_is(k,kn,"radius")) ok = jp_number(&j, &radius);
+        else if (key_is(k,kn,"seq"))  ok = jp_number(&j, &seq);
+        else if (key_is(k,kn,"keys")) ok = jp_number(&j, &keys);
+        else if (key_is(k,kn,"dt"))   ok = jp_number(&j, &dt);
+        else if (key_is(k,kn,"min"))  ok = jp_numbers(&j, mn, 3) == 3;
+        else if (key_is(k,kn,"max"))  ok = jp_numbers(&j, mx, 3) == 3;
+        else if (key_is(k,kn,"dims")) ok = jp_numbers(&j, dims, 3) == 3;
+        else if (key_is(k,kn,"pos"))  ok = jp_numbers(&j, pos, 3) == 3;
+        else if (key_is(k,kn,"data")) ok = jp_slice(&j, &data, &datalen);
+        else if (key_is(k,kn,"events")) {        // ["key","mouse","player","change","world"]
+            ok = jp_eat(&j, '[');
+            if (ok && !jp_eat(&j, ']')) {
+                do {
+                    const char* v; int vn;
+                    ok = jp_slice(&j, &v, &vn);
+                    if (ok) subs |= key_is(v,vn,"key") ? WIRE_SUB_KEY : key_is(v,vn,"mouse") ? WIRE_SUB_MOUSE :
+                                    key_is(v,vn,"player") ? WIRE_SUB_PLAYER : key_is(v,vn,"change") ? WIRE_SUB_CHANGE :
+                                    key_is(v,vn,"world") ? WIRE_SUB_WORLD : 0;
+                } while (ok && jp_eat(&j, ','));
+                if (ok) ok = jp_eat(&j, ']');
+            }
+        }
+        else if (key_is(k,kn,"encoding")) {
+            const char* v; int vn;
+            ok = jp_slice(&j, &v, &vn);
+            if (ok) { rle = key_is(v,vn,"rle8"); ok = rle || key_is(v,vn,"raw8"); }
+        }
+        else if (key_is(k,kn,"world")) {         // {"size":[x,y,z]}
+            ok = jp_eat(&j, '{');
+            if (ok && !jp_eat(&j, '}')) {
+                do {
+                    const char* wk; int wkn;
+                    ok = jp_slice(&j, &wk, &wkn) && jp_eat(&j, ':');
+                    if (ok) ok = key_is(wk,wkn,"size") ? jp_numbers(&j, size, 3) == 3 : jp_skip(&j);
+                } while (ok && jp_eat(&j, ','));
+                if (ok) ok = jp_eat(&j, '}');
+            }
+        }
+        else if (key_is(k,kn,"palette")) {       // {"NAME":id,...}: replaces the palette for later lines
+            s->npalette = 0;
+            ok = jp_eat(&j, '{');
+            if (ok && !jp_eat(&j, '}')) {
+                do {
+                    const char* pk; int pkn; double pv;
+                    ok = jp_slice(&j, &pk, &pkn) && jp_eat(&j, ':') && jp_number(&j, &pv) && in_range(pv, 0, 65535);
+                    if (ok) palette_set(s, pk, pkn, (uint16_t)pv);
+                } while (ok && jp_eat(&j, ','));
+                if (ok) ok = jp_eat(&j, '}');
+            }
+        }
+        else ok = jp_skip(&j);
+        if (!ok) { s->err = "bad value"; return false; }
+    } while (jp_eat(&j, ','));
+    if (!empty && !jp_eat(&j, '}')) { s->err = "expected }"; return false; }
+    jp_ws(&j);
+    if (j.p != j.end) { s->err = "trailing data"; return false; }
+
+    if (c->op == WIRE_OP_NONE) { s->err = "unknown op"; return false; }
+    if (have_id) {
+        if (idname) {
+            int id = palette_find(s, idname, idlen);
+            if (id < 0) { s->err = "unknown palette id"; return false; }
+            c->id = (uint16_t)id;
+        } else {
+            if (!in_range(idnum, 0, 65535)) { s->err = "id out of range"; return false; }
+            c->id = (uint16_t)idnum;
+        }
+    }
+    double ints[] = { x, y, z, h, cx, cz, y0, radius, keys, mn[0], mn[1], mn[2], mx[0], mx[1], mx[2],
+                      dims[0], dims[1], dims[2], size[0], size[1], size[2] };
+    if (!all_int(ints, (int)(sizeof ints/sizeof ints[0])) || !in_range(seq, 0, UINT32_MAX)) {
+        s->err = "value out of range"; return false;
+    }
+
+    switch (c->op) {
+        case WIRE_OP_INIT:
+            c->a[0] = (int)size[0]; c->a[1] = (int)size[1]; c->a[2] = (int)size[2];
+            break;
+        case WIRE_OP_SET:
+            c->a[0] = (int)x; c->a[1] = (int)y; c->a[2] = (int)z;
+            break;
+        case WIRE_OP_FILL:
+            for (int i=0;i<3;i++) { c->a[i] = (int)mn[i]; c->a[3+i] = (int)mx[i]; }
+            break;
+        case WIRE_OP_COLUMN:
+            c->a[0] = (int)x; c->a[1] = (int)z; c->a[2] = (int)h;
+            break;
+        case WIRE_OP_CHUNK: {
+            int dx = (int)dims[0], dy = (int)dims[1], dz = (int)dims[2];
+            if (dx<=0 || dy<=0 || dz<=0 || !data) { s->err = "chunk needs dims and data"; return false; }
+            if (!in_range((double)(int)cx*dx, INT_MIN, INT_MAX) || !in_range((double)(int)cz*dz, INT_MIN, INT_MAX)) {
+                s->err = "value out of range"; return false;
+            }
+            int cap = datalen*3/4 + 3;
+            c->data = (uint8_t*)malloc(cap);
+            if (!c->data) { s->err = "out of memory"; return false; }
+            c->data_len = b64_decode(data, datalen, c->data, cap);
+            c->rle = rle;
+            if (c->data_len < 0) { free(c->data); c->data = NULL; s->err = "bad base64"; return false; }
+            c->a[0] = (int)cx*dx; c->a[1] = (int)y0; c->a[2] = (int)cz*dz;
+            c->a[3] = dx; c->a[4] = dy; c->a[5] = dz;
+            break;
+        }
+        case WIRE_OP_CAMERA_SET:
+            c->f[0] = (float)pos[0]; c->f[1] = (float)pos[1]; c->f[2] = (float)pos[2];
+            c->f[3] = (float)yaw; c->f[4] = (float)pitch;
+            break;
+        case WIRE_OP_SUBSCRIBE:
+            c->a[0] = (int)subs;
+            break;
+        case WIRE_OP_VIEW:
+            c->f[0] = (float)pos[0]; c->f[1] = (float)pos[1]; c->f[2] = (float)pos[2];
+            c->a[0] = (int)radius;
+            break;
+        case WIRE_OP_INPUT:
+            c->a[0] = (int)(uint32_t)seq; c->a[1] = (int)keys;
+            c->f[0] = (float)yaw; c->f[1] = (float)pitch; c->f[2] = (float)dt;
+            break;
+        default: break;
+    }
+    return true;
+}
+
+static inline int32_t rd_i32(const uint8_t* p) { return (int32_t)((uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24); }
+static inline uint16_t rd_u16(const uint8_t* p) { return (uint16_t)(p[0] | p[1]<<8); }
+static inline float rd_f32(const uint8_t* p) { int32_t i = rd_i32(p); float f; memcpy(&f, &i, 4); return f; }
+
+// Parse one binary frame payload into *c.
+static bool parse_frame(WireParser* s, uint8_t op, const uint8_t* p, uint32_t len, WireCmd* c) {
+    static const uint32_t kMinLen[] = { 0, 12, 14, 26, 14, 19, 20, 0, 0, 4, 16, 17 };  // by WIRE_OP_*
+    memset(c, 0, sizeof(*c));
+    if (op == WIRE_OP_NONE || op > WIRE_OP_INPUT) { s->err = "unknown frame op"; return false; }
+    if (len < kMinLen[op]) { s->err = "short frame"; return false; }
+    c->op = op;
+    switch (op) {
+        case WIRE_OP_INIT:
+            for (int i=0;i<3;i++) c->a[i] = rd_i32(p + 4*i);
+            break;
+        case WIRE_OP_SET: case WIRE_OP_COLUMN:
+            for (int i=0;i<3;i++) c->a[i] = rd_i32(p + 4*i);
+            c->id = rd_u16(p + 12);
+            break;
+        case WIRE_OP_FILL:
+            for (int i=0;i<6;i++) c->a[i] = rd_i32(p + 4*i);
+            c->id = rd_u16(p + 24);
+            break;
+        case WIRE_OP_CHUNK: {
+            int dx = rd_u16(p + 12), dy = rd_u16(p + 14), dz = rd_u16(p + 16);
+            if (!dx || !dy || !dz || p[18] > 1) { s->err = "bad chunk header"; return false; }
+            int64_t ox = (int64_t)rd_i32(p)*dx, oz = (int64_t)rd_i32(p + 4)*dz;
+            if (ox < INT_MIN || ox > INT_MAX || oz < INT_MIN || oz > INT_MAX) { s->err = "value out of range"; return false; }
+            c->a[0] = (int)ox; c->a[1] = rd_i32(p + 8); c->a[2] = (int)oz;
+            c->a[3] = dx; c->a[4] = dy; c->a[5] = dz;
+            c->rle = p[18] == 1;
+            c->data_len = (int)(len - 19);
+            c->data = (uint8_t*)malloc(c->data_len ? c->data_len : 1);
+            if (!c->data) { s->err = "out of memory"; return false; }
+            memcpy(c->data, p + 19, c->data_len);
+            break;
+        }
+        case WIRE_OP_CAMERA_SET:
+            for (int i=0;i<5;i++) c->f[i] = rd_f32(p + 4*i);
+            break;
+        case WIRE_OP_SUBSCRIBE:
+            c->a[0] = rd_i32(p);
+            break;
+        case WIRE_OP_VIEW:
+            for (int i=0;i<3;i++) c->f[i] = rd_f32(p + 4*i);
+            c->a[0] = rd_i32(p + 12);
+            break;
+        case WIRE_OP_INPUT:
+            c->a[0] = rd_i32(p); c->a[1] = p[4];
+            for (int i=0;i<3;i++) c->f[i] = rd_f32(p + 5 + 4*i);
+            break;
+        default: break;
+    }
+    return true;
+}
+
+// Split the next message off m[0..avail): a binary frame or a JSON line.
+int wire_next(WireParser* p, const uint8_t* m, size_t avail, size_t* used, WireCmd* c) {
+    p->err = NULL;
+    if (avail == 0) return WIRE_NEED_MORE;
+    if (m[0] == FRAME_MAGIC) {
+        if (avail < FRAME_HEADER) return WIRE_NEED_MORE;
+        uint32_t n = (uint32_t)rd_i32(m + 2);
+        if (n > FRAME_MAX) { p->err = "frame too large"; return WIRE_CORRUPT; }
+        if (avail < FRAME_HEADER + n) return WIRE_NEED_MORE;
+        *used = FRAME_HEADER + n;
+        return parse_frame(p, m[1], m + FRAME_HEADER, n, c) ? WIRE_CMD : WIRE_SKIP;
+    }
+    // only the bytes that arrived since the last call are searched
+    const uint8_t* nl = p->scanned < avail ? (const uint8_t*)memchr(m + p->scanned, '\n', avail - p->scanned) : NULL;
+    if (!nl) {
+        p->scanned = avail;
+        if (avail > JSON_LINE_MAX) { p->err = "line too long"; return WIRE_CORRUPT; }
+        return WIRE_NEED_MORE;
+    }
+    p->scanned = 0;
+    size_t n = (size_t)(nl - m);
+    *used = n + 1;
+    if (n > 0 && m[n-1] == '\r') n--;
+    if (n == 0) return WIRE_SKIP;
+    return parse_line(p, (const char*)m, (int)n, c) ? WIRE_CMD : WIRE_SKIP;
+}
+
+const char* wire_apply(Engine* e, WireCmd* c) {
+    const char* reply = NULL;
+    switch (c->op) {
+        case WIRE_OP_INIT:
+            reply = engine_create_world(e, c->a[0], c->a[1], c->a[2]) ? "{\"event\":\"ready\"}\n"
+                  : "{\"event\":\"error\",\"msg\":\"init: bad world size\"}\n";
+            break;
+        case WIRE_OP_SET:
+            engine_set_block(e, c->a[0], c->a[1], c->a[2], c->id);
+            break;
+        case WIRE_OP_FILL:
+            engine_fill_box(e, c->a[0], c->a[1], c->a[2], c->a[3], c->a[4], c->a[5], c->id);
+            break;
+        case WIRE_OP_COLUMN:
+            if (c->a[2] > 0) engine_fill_box(e, c->a[0], 0, c->a[1], c->a[0], c->a[2]-1, c->a[1], c->id);
+            break;
+        case WIRE_OP_CHUNK:
+            if (!world_decode_box(e, c->a[0], c->a[1], c->a[2], c->a[3], c->a[4], c->a[5], c->data, c->data_len, c->rle))
+                reply = "{\"event\":\"error\",\"msg\":\"bad chunk payload\"}\n";
+            break;
+        case WIRE_OP_CAMERA_SET:
+            engine_set_camera_pose(e, c->f[0], c->f[1], c->f[2], c->f[3], c->f[4]);
+            break;
+        case WIRE_OP_CLEAR:
+            engine_clear_world(e, 0);
+            break;
+        case WIRE_OP_FLUSH:
+            reply = "{\"event\":\"ack\",\"op\":\"flush\"}\n";
+            break;
+        default: break;   // subscribe, view and input are per-connection, handled by the server
+    }
+    free(c->data);
+    c->data = NULL;
+    return reply;
+}
+
+// Protocol name of a raylib key code ("W", "SPACE", "F2", ...); NULL = send the number.
+static const char* key_name(int key, char tmp[2]) {
+    if ((key >= 'A' && key <= 'Z') || (key >= '0' && key <= '9')) { tmp[0] = (char)key; tmp[1] = 0; return tmp; }
+    switch (key) {
+        case KEY_SPACE: return "SPACE";   case KEY_ESCAPE: return "ESCAPE";
+        case KEY_ENTER: return "ENTER";   case KEY_TAB: return "TAB";
+        case KEY_BACKSPACE: return "BACKSPACE";
+        case KEY_RIGHT: return "RIGHT";   case KEY_LEFT: return "LEFT";
+        case KEY_DOWN: return "DOWN";     case KEY_UP: return "UP";
+        case KEY_LEFT_SHIFT: return "LEFT_SHIFT";     case KEY_RIGHT_SHIFT: return "RIGHT_SHIFT";
+        case KEY_LEFT_CONTROL: return "LEFT_CONTROL"; case KEY_RIGHT_CONTROL: return "RIGHT_CONTROL";
+        default: break;
+    }
+    if (key >= KEY_F1 && key <= KEY_F12) { static const char* f[] = {"F1","F2","F3","F4","F5","F6","F7","F8","F9","F10","F11","F12"}; return f[key-KEY_F1]; }
+    return NULL;
+}
+
+uint32_t wire_event_json(const EngineEvent* ev, char* buf, int cap) {
+    static const char* kButton[] = { "Left", "Right", "Middle" };
+    char tmp[2];
+    switch (ev->type) {
+        case ENGINE_EVENT_KEY_DOWN:
+        case ENGINE_EVENT_KEY_UP: {
+            const char* type = ev->type == ENGINE_EVENT_KEY_DOWN ? "key_down" : "key_up";
+            const char* name = key_name(ev->code, tmp);
+            if (name) snprintf(buf, cap, "{\"event\":\"%s\",\"key\":\"%s\"}\n", type, name);
+            else      snprintf(buf, cap, "{\"event\":\"%s\",\"key\":%d}\n", type, ev->code);
+            return WIRE_SUB_KEY;
+        }
+        case ENGINE_EVENT_MOUSE_DOWN:
+        case ENGINE_EVENT_MOUSE_UP:
+            snprintf(buf, cap, "{\"event\":\"mouse_button\",\"button\":\"%s\",\"state\":\"%s\",\"x\":%d,\"y\":%d}\n",
+                     ev->code >= 0 && ev->code < 3 ? kButton[ev->code] : "Other",
+                     ev->type == ENGINE_EVENT_MOUSE_DOWN ? "down" : "up", (int)ev->x, (int)ev->y);
+            return WIRE_SUB_MOUSE;
+        case ENGINE_EVENT_PLAYER:
+            snprintf(buf, cap, "{\"event\":\"player\",\"pos\":[%.2f,%.2f,%.2f],\"yaw\":%.3f,\"pitch\":%.3f}\n",
+                     ev->x, ev->y, ev->z, ev->yaw, ev->pitch);
+            return WIRE_SUB_PLAYER;
+        default: return 0;
+    }
+}
+
+int wire_change_json(const EngineChange* c, char* buf, int cap) {
+    static const char* kKind[] = { "block", "box", "reset" };
+    int n = snprintf(buf, cap, "{\"event\":\"change\",\"kind\":\"%s\",\"min\":[%d,%d,%d],\"max\":[%d,%d,%d]",
+                     kKind[c->kind < 3 ? c->kind : 1], c->x0, c->y0, c->z0, c->x1, c->y1, c->z1);
+    if (c->new_id != ENGINE_CHANGE_MIXED) n += snprintf(buf + n, cap - n, ",\"id\":%d", c->new_id);
+    n += snprintf(buf + n, cap - n, "}\n");
+    return n;
+}
+
+// ---- stdin/stdout server ----
+
+static void push_cmd(CmdServer* s, const WireCmd* c) {
+    pthread_mutex_lock(&s->qlock);
+    while (s->qcount == CMDQ_CAP && !s->stop) pthread_cond_wait(&s->qnot_full, &s->qlock);
+    if (!s->stop) {
+        s->q[(s->qhead + s->qcount) % CMDQ_CAP] = *c;
+        s->qcount++;
+    } else free(c->data);
+    pthread_mutex_unlock(&s->qlock);
+}
+
+static void* reader_main(void* arg) {
+    CmdServer* s = (CmdServer*)arg;
+    size_t cap = 1<<16, len = 0;
+    uint8_t* buf = (uint8_t*)malloc(cap);
+    bool corrupt = !buf;
+    if (!buf) emit_error(s, "out of memory");
+    while (!s->stop && !corrupt) {
+        pthread_mutex_lock(&s->outlock);
+        bool pending = s->out_len > 0;
+        pthread_mutex_unlock(&s->outlock);
+        struct pollfd pfd[2] = { { s->in_fd, POLLIN, 0 }, { s->out_fd, POLLOUT, 0 } };
+        int pr = poll(pfd, pending ? 2 : 1, 100);   // wake up regularly to notice stop
+        if (pr < 0 && errno != EINTR) break;
+        if (pr <= 0) continue;
+        if (pending && pfd[1].revents) {   // drain what the ticks left behind
+            pthread_mutex_lock(&s->outlock);
+            flush_out(s);
+            pthread_mutex_unlock(&s->outlock);
+        }
+        if (!pfd[0].revents) continue;
+        if (len == cap) {
+            uint8_t* grown = (uint8_t*)realloc(buf, cap*2);
+            if (!grown) { emit_error(s, "out of memory"); break; }
+            buf = grown; cap *= 2;
+        }
+        ssize_t r = read(s->in_fd, buf + len, cap - len);
+        if (r < 0) { if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue; break; }
+        if (r == 0) break;   // EOF
+        len += (size_t)r;
+
+        // hand every complete line / frame to its parser; partial ones wait for more bytes
+        size_t start = 0, used = 0;
+        WireCmd c;
+        int k;
+        while ((k = wire_next(&s->parser, buf + start, len - start, &used, &c)) != WIRE_NEED_MORE) {
+            if (k == WIRE_CORRUPT) { emit_error(s, s->parser.err); corrupt = true; break; }
+            start += used;
+            if (k == WIRE_CMD && c.op == WIRE_OP_SUBSCRIBE) s->subs = (uint32_t)c.a[0];   // immediate, not queued
+            else if (k == WIRE_CMD) push_cmd(s, &c);
+            else if (s->parser.err) emit_error(s, s->parser.err);
+        }
+        memmove(buf, buf + start, len - start);
+        len -= start;
+    }
+    free(buf);
+    if (!s->stop) emit(s, "{\"event\":\"quit\"}\n");
+    return NULL;
+}
+
+void cmdserver_apply(Engine* e) {
+    CmdServer* s = e->cmd;
+    if (!s) return;
+    double deadline = stats_now() + e->cmd_budget_ms*0.001;
+    pthread_mutex_lock(&s->outlock);   // what the reader thread has not drained yet
+    if (s->out_len) flush_out(s);
+    pthread_mutex_unlock(&s->outlock);
+    WireCmd batch[APPLY_BATCH];
+    for (;;) {
+        pthread_mutex_lock(&s->qlock);
+        int n = s->qcount < APPLY_BATCH ? s->qcount : APPLY_BATCH;
+        for (int i=0;i<n;i++) batch[i] = s->q[(s->qhead + i) % CMDQ_CAP];
+        s->qhead = (s->qhead + n) % CMDQ_CAP;
+        s->qcount -= n;
+        if (n) pthread_cond_signal(&s->qnot_full);
+        pthread_mutex_unlock(&s->qlock);
+        if (!n) break;
+        for (int i=0;i<n;i++) {
+            const char* reply = wire_apply(e, &batch[i]);
+            if (reply) emit(s, reply);
+        }
+        if (stats_now() >= deadline) break;
+    }
+}
+
+void cmdserver_event(Engine* e, const EngineEvent* ev) {
+    char buf[256];
+    if (wire_event_json(ev, buf, sizeof buf) & e->cmd->subs) emit(e->cmd, buf);
+}
+
+bool engine_start_command_server(Engine* e, int in_fd, int out_fd) {
+    if (!e || e->cmd) return false;
+    int flags = fcntl(out_fd, F_GETFL);
+    if (flags < 0) return false;
+    CmdServer* s = (CmdServer*)calloc(1, sizeof(CmdServer));
+    if (!s) return false;
+    s->in_fd = in_fd; s->out_fd = out_fd;
+    s->subs = WIRE_SUB_KEY | WIRE_SUB_MOUSE | WIRE_SUB_PLAYER;
+    s->q = (WireCmd*)calloc(CMDQ_CAP, sizeof(WireCmd));
+    s->out = (char*)malloc(OUT_CAP);
+    s->out_flags = flags;
+    pthread_mutex_init(&s->qlock, NULL);
+    pthread_mutex_init(&s->outlock, NULL);
+    pthread_cond_init(&s->qnot_full, NULL);
+    if (!s->q || !s->out || fcntl(out_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        free(s->q); free(s->out); free(s);
+        return false;
+    }
+    if (pthread_create(&s->thread, NULL, reader_main, s) != 0) {
+        fcntl(out_fd, F_SETFL, flags);
+        free(s->q); free(s->out); free(s);
+        return false;
+    }
+    e->cmd = s;
+    return true;
+}
+
+void engine_stop_command_server(Engine* e) {
+    if (!e || !e->cmd) return;
+    CmdServer* s = e->cmd;
+    pthread_mutex_lock(&s->qlock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->qnot_full);
+    pthread_mutex_unlock(&s->qlock);
+    pthread_join(s->thread, NULL);
+    // give the controller a moment to take the last lines (quit among them)
+    for (int i=0; i<10 && s->out_len; i++) {
+        struct pollfd pfd = { s->out_fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, 10) < 0 && errno != EINTR) break;
+        flush_out(s);
+    }
+    fcntl(s->out_fd, F_SETFL, s->out_flags);
+    for (int i=0;i<s->qcount;i++) free(s->q[(s->qhead + i) % CMDQ_CAP].data);
+    pthread_mutex_destroy(&s->qlock);
+    pthread_mutex_destroy(&s->outlock);
+    pthread_cond_destroy(&s->qnot_full);
+    free(s->q);
+    free(s->out);
+    free(s);
+    e->cmd = NULL;
+}
+
+uint32_t engine_command_events_dropped(Engine* e) {
+    if (!e || !e->cmd) return 0;
+    pthread_mutex_lock(&e->cmd->outlock);
+    uint32_t n = e->cmd->out_dropped;
+    pthread_mutex_unlock(&e->cmd->outlock);
+    return n;
+}
+
+#else  // _WIN32: no poll()/pipes here yet — drive the engine through the C API instead
+
+void cmdserver_apply(Engine* e) { (void)e; }
+void cmdserver_event(Engine* e, const EngineEvent* ev) { (void)e; (void)ev; }
+bool engine_start_command_server(Engine* e, int in_fd, int out_fd) { (void)e; (void)in_fd; (void)out_fd; return false; }
+void engine_stop_command_server(Engine* e) { (void)e; }
+uint32_t engine_command_events_dropped(Engine* e) { (void)e; return 0; }
+
+#endif
@@ -0,0 +1,57 @@
+// editring.c — lock-free single-producer/single-consumer ring of block edits.
+//
+// One controller thread pushes edits with engine_queue_edits while the engine
+// thread renders; engine_tick drains at most edit_budget of them per frame.
+// head is written only by the producer, tail only by the engine; the
+// release/acquire pair on each index publishes the slots in between.
+#include "engine_internal.h"
+
+bool edits_alloc(Engine* e) {
+    e->edits.buf = (EngineEdit*)malloc(EDIT_RING*sizeof(EngineEdit));
+    atomic_init(&e->edits.head, 0);
+    atomic_init(&e->edits.tail, 0);
+    return e->edits.buf != NULL;
+}
+
+void edits_free(Engine* e) {
+    free(e->edits.buf);
+    e->edits.buf = NULL;
+}
+
+int engine_queue_edits(Engine* e, const EngineEdit* edits, int n) {
+    if (!e || !edits || n <= 0 || !e->edits.buf) return 0;
+    EditRing* r = &e->edits;
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t room = EDIT_RING - (head - tail);
+    if ((uint32_t)n > room) n = (int)room;
+    for (int i=0;i<n;i++) r->buf[(head + (uint32_t)i) & (EDIT_RING-1)] = edits[i];
+    atomic_store_explicit(&r->head, head + (uint32_t)n, memory_order_release);
+    return n;
+}
+
+int engine_pending_edits(Engine* e) {
+    if (!e) return 0;
+    uint32_t tail = atomic_load_explicit(&e->edits.tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&e->edits.head, memory_order_acquire);
+    return (int)(head - tail);
+}
+
+void engine_set_edit_budget(Engine* e, int edits_per_frame) {
+    if (!e) return;
+    e->edit_budget = edits_per_frame > 0 ? edits_per_frame : 1;
+}
+
+void edits_apply(Engine* e) {
+    EditRing* r = &e->edits;
+    if (!r->buf) return;
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t n = head - tail;
+    if (n > (uint32_t)e->edit_budget) n = (uint32_t)e->edit_budget;
+    for (uint32_t i=0;i<n;i++) {
+        const EngineEdit* ed = &r->buf[(tail + i) & (EDIT_RING-1)];
+        engine_set_block(e, ed->x, ed->y, ed->z, ed->id);   // bounds check + dirty marking
+    }
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+}
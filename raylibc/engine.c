@@ -1,73 +1,15 @@
-#include "engine.h"
-#include "raylib.h"
-#include "raymath.h"
-#include <stdlib.h>
-#include <string.h>
-
-// color helper for non-textured fallback
-static Color tileColorForIndex(int tile) {
-    switch (tile % 8) {
-        case 0: return (Color){  80, 170,  80, 255 }; // grass green
-        case 1: return (Color){ 255, 180,  60, 255 }; // flowers-ish / warm
-        case 2: return (Color){ 139, 105,  80, 255 }; // dirt brown
-        case 3: return (Color){ 230, 220, 170, 255 }; // sand beige
-        case 4: return (Color){ 150, 150, 150, 255 }; // stone gray
-        case 5: return (Color){  70, 130, 200, 255 }; // water blue
-        case 6: return (Color){ 150, 110,  70, 255 }; // wood brown
-        case 7: return (Color){ 245, 250, 255, 255 }; // snow
-        default: return (Color){255,  64, 255, 255};   // magenta = debug
-    }
-}
-
-typedef struct {
-    int sx, sy, sz;       // world dims
-    uint16_t* v;          // [sx*sy*sz] block ids
-} World;
-
-typedef struct {
-    Texture2D* tiles;     // per-tile textures (sliced from atlas)
-    int tile_count;
-    int tile_px, cols, rows;
-    Texture2D atlas_tex;  // optional: whole atlas
-    Image     atlas_img;  // kept until slicing done
-    bool      atlas_loaded;
-} Atlas;
-
-typedef struct {
-    uint16_t tile_of_block[256]; // block_id -> tile_index (0..tile_count-1), 0xFFFF=undefined
-} BlockDefs;
-
-struct Engine {
-    // window/render
-    int screen_w, screen_h;
-    Camera3D cam;
-    float yaw, pitch;
-    bool  cursor_locked;
-
-    // assets/world
-    Atlas atlas;
-    BlockDefs defs;
-    World world;
+#include "engine_internal.h"
 
-    // Inverted (Minecraft) mouse
-    bool invert_mouse_x;
-    bool invert_mouse_y;
-
-    // movement
-    float move_speed, sprint_mult, eye_height;
-    float velY, gravity, jump_speed;
-};
-
-static inline int idx3D(const World* w, int x,int y,int z) {
-    return x + y*w->sx + z*w->sx*w->sy;
-}
-
-Engine* engine_create(int width, int height, const char* title, int target_fps) {
+static Engine* engine_new(int width, int height, const char* title, int target_fps, bool headless) {
     Engine* e = (Engine*)calloc(1, sizeof(Engine));
     e->screen_w = width; e->screen_h = height;
+    e->headless = headless;
+    e->tick_hz = target_fps > 0 ? target_fps : headless && target_fps == 0 ? 60 : 0;   // 0 = uncapped
 
-    InitWindow(width, height, title ? title : "mini3d");
-    SetTargetFPS(target_fps > 0 ? target_fps : 60);
+    if (!headless) {
+        InitWindow(width, height, title ? title : "mini3d");
+        SetTargetFPS(e->tick_hz);
+    }
 
     e->cam.position   = (Vector3){ 0, 2, 4 };
     e->cam.target     = (Vector3){ 0, 1.6f, 0 };
@@ -78,8 +20,8 @@ Engine* engine_create(int width, int height, const char* title, int target_fps)
     e->yaw = PI;   // look -Z
     e->pitch = -0.15f;
 
-    e->cursor_locked = true;
-    DisableCursor();
+    e->cursor_locked = !headless;
+    if (!headless) DisableCursor();
 
     e->move_speed = 6.0f;
     e->sprint_mult = 1.8f;
@@ -88,13 +30,53 @@ Engine* engine_create(int width, int height, const char* title, int target_fps)
 
     for (int i=0;i<256;i++) e->defs.tile_of_block[i] = 0xFFFF;
 
+    // LOD 1/2/3 (2x/4x/8x merged voxels) beyond these distances, nothing past view_dist
+    e->lod_dist[0] = 32.0f; e->lod_dist[1] = 64.0f; e->lod_dist[2] = 128.0f;
+    e->view_dist = 256.0f;
+    e->mesh_budget = 8;
+    e->occlusion = true;
+    e->cave_culling = true;
+    e->stats_ring = (EngineFrameStats*)calloc(STATS_RING, sizeof(EngineFrameStats));
+    e->cmd_budget_ms = 4.0f;
+    e->edit_budget = 16384;
+    edits_alloc(e);
+
     return e;
 }
 
+Engine* engine_create(int width, int height, const char* title, int target_fps) {
+    return engine_new(width, height, title, target_fps, false);
+}
+
+Engine* engine_create_headless(int tick_hz) {
+    return engine_new(0, 0, NULL, tick_hz, true);
+}
+
 void engine_destroy(Engine* e) {
     if (!e) return;
+    engine_stop_sim_thread(e);         // before anything it ticks goes away
+    engine_stop_command_server(e);   // joins the reader before the world goes away
+    engine_stop_shm(e);
+    engine_stop_socket_server(e);
+    engine_disconnect(e);
+    engine_stop_recording(e);
+    engine_stop_replay(e);
+    softrast_free(e);
     // free world
+    snapshot_retire(e);              // snapshots may outlive the engine: only their copies do
+    atomic_store(&e->world.replacing, true);   // lock-free readers: no new ones, wait out the rest
+    while (atomic_load(&e->world.readers)) stats_sleep_until(stats_now() + 0.0001);
+    chunks_free(e);
+    free(e->draws);
     free(e->world.v);
+    if (e->mesh_mat_loaded) UnloadMaterial(e->mesh_mat);
+    instanced_unload(e);
+    free(e->occ_depth);
+    free(e->occ_corner);
+    free(e->stats_ring);
+    edits_free(e);
+    free(e->edit_chunks);
+    free(e->changes);
 
     // unload tile textures
     if (e->atlas.tiles) {
@@ -106,7 +88,7 @@ void engine_destroy(Engine* e) {
     if (e->atlas.atlas_tex.id) UnloadTexture(e->atlas.atlas_tex);
     if (e->atlas.atlas_loaded) UnloadImage(e->atlas.atlas_img);
 
-    CloseWindow();
+    if (!e->headless) CloseWindow();
     free(e);
 }
 
@@ -114,6 +96,13 @@ bool engine_load_atlas(Engine* e, const char* png_path, int tile_px, int cols, i
     if (!e) return false;
     e->atlas.atlas_img = LoadImage(png_path);
     if (!e->atlas.atlas_img.data) return false;
+    if (e->headless) {   // no GL context to upload to: keep the tile grid (block colours) for the software renderer
+        UnloadImage(e->atlas.atlas_img);
+        e->atlas.atlas_img = (Image){ 0 };
+        e->atlas.tile_px = tile_px; e->atlas.cols = cols; e->atlas.rows = rows;
+        e->atlas.tile_count = cols*rows;
+        return true;
+    }
     e->atlas.atlas_loaded = true;
 
     e->atlas.atlas_tex = LoadTextureFromImage(e->atlas.atlas_img);
@@ -126,6 +115,7 @@ bool engine_load_atlas(Engine* e, const char* png_path, int tile_px, int cols, i
 
     e->atlas.tile_px = tile_px; e->atlas.cols = cols; e->atlas.rows = rows;
     e->atlas.tile_count = cols*rows;
+    free(e->inst_tile_count); e->inst_tile_count = NULL;  // sized by tile_count
     e->atlas.tiles = (Texture2D*)calloc(e->atlas.tile_count, sizeof(Texture2D));
 
     // Slice atlas into per-tile textures (simplest path with raylib)
@@ -142,35 +132,129 @@ bool engine_load_atlas(Engine* e, const char* png_path, int tile_px, int cols, i
 bool engine_define_block_tile(Engine* e, uint16_t block_id, int tile_index) {
     if (!e || tile_index < 0 || tile_index >= e->atlas.tile_count) return false;
     e->defs.tile_of_block[block_id] = (uint16_t)tile_index;
+    chunks_mark_all_dirty(e);   // colours are baked into chunk meshes
     return true;
 }
 
 bool engine_create_world(Engine* e, int sx, int sy, int sz) {
     if (!e || sx<=0 || sy<=0 || sz<=0) return false;
-    free(e->world.v);
-    e->world.sx = sx; e->world.sy = sy; e->world.sz = sz;
+    World* w = &e->world;
+    snapshot_detach_all(e);              // first: a snapshot reader turned away must find its copies
+    atomic_store(&w->replacing, true);   // lock-free readers: no new ones, wait out the rest
+    while (atomic_load(&w->readers)) stats_sleep_until(stats_now() + 0.0001);
+    chunks_free(e);
+    free(w->v);
+    w->sx = sx; w->sy = sy; w->sz = sz;
     size_t N = (size_t)sx*sy*sz;
-    e->world.v = (uint16_t*)calloc(N, sizeof(uint16_t));
-    return e->world.v != NULL;
+    w->v = (uint16_t*)calloc(N, sizeof(uint16_t));
+    bool ok = w->v && chunks_alloc(e);
+    if (!ok) { chunks_free(e); free(w->v); w->v = NULL; }   // no world rather than one without chunks
+    atomic_store(&w->replacing, false);
+    if (ok) changes_box(e, ENGINE_CHANGE_RESET, 0,0,0, sx-1,sy-1,sz-1, 0);
+    return ok;
+}
+
+bool engine_get_world_size(Engine* e, int* sx, int* sy, int* sz) {
+    if (!e || !world_read_enter(&e->world)) return false;
+    bool have = e->world.v != NULL;
+    if (have) {
+        if (sx) *sx = e->world.sx;
+        if (sy) *sy = e->world.sy;
+        if (sz) *sz = e->world.sz;
+    }
+    world_read_leave(&e->world);
+    return have;
 }
 
 void engine_clear_world(Engine* e, uint16_t id) {
     if (!e || !e->world.v) return;
-    size_t N = (size_t)e->world.sx*e->world.sy*e->world.sz;
-    for (size_t i=0;i<N;i++) e->world.v[i] = id;
+    World* w = &e->world;
+    size_t N = (size_t)w->sx*w->sy*w->sz;
+    chunks_write_begin(e, 0,0,0, w->sx-1,w->sy-1,w->sz-1);
+    for (size_t i=0;i<N;i++) w->v[i] = id;
+    chunks_write_end(e, 0,0,0, w->sx-1,w->sy-1,w->sz-1);
+    chunks_mark_all_dirty(e);
+    changes_box(e, ENGINE_CHANGE_BOX, 0,0,0, e->world.sx-1,e->world.sy-1,e->world.sz-1, id);
 }
 
 bool engine_set_block(Engine* e, int x,int y,int z, uint16_t block_id) {
     if (!e || !e->world.v) return false;
     if (x<0||y<0||z<0||x>=e->world.sx||y>=e->world.sy||z>=e->world.sz) return false;
-    e->world.v[idx3D(&e->world,x,y,z)] = block_id;
+    uint16_t* v = &e->world.v[idx3D(&e->world,x,y,z)];
+    if (*v == block_id) return true;   // no-op: nothing to remesh or report
+    changes_block(e, x,y,z, *v, block_id);
+    chunks_write_begin(e, x,y,z, x,y,z);
+    *v = block_id;
+    chunks_write_end(e, x,y,z, x,y,z);
+    chunks_mark_dirty(e, x,y,z, x,y,z);
     return true;
 }
 
+void engine_begin_edit(Engine* e) {
+    if (e) e->edit_depth++;
+}
+
+void engine_commit_edit(Engine* e) {
+    if (!e || !e->edit_depth) return;
+    if (--e->edit_depth == 0) chunks_flush_dirty(e);
+}
+
 uint16_t engine_get_block(Engine* e, int x,int y,int z) {
-    if (!e || !e->world.v) return 0;
-    if (x<0||y<0||z<0||x>=e->world.sx||y>=e->world.sy||z>=e->world.sz) return 0;
-    return e->world.v[idx3D(&e->world,x,y,z)];
+    if (!e || !world_read_enter(&e->world)) return 0;
+    const World* w = &e->world;
+    uint16_t id = 0;   // one voxel cannot tear: no chunk seqlock needed
+    if (w->v && x>=0 && y>=0 && z>=0 && x<w->sx && y<w->sy && z<w->sz) id = w->v[idx3D(w,x,y,z)];
+    world_read_leave(&e->world);
+    return id;
+}
+
+// Voxel by voxel, each read on its own: a concurrent edit is either seen or not.
+static uint16_t raycast_walk(const World* w, float ox,float oy,float oz, float dx,float dy,float dz,
+                             float max_dist, int hit[3], int normal[3]) {
+    float o[3] = { ox, oy, oz }, d[3] = { dx, dy, dz };
+    int v[3], step[3], n[3] = { 0, 0, 0 };
+    float next[3], delta[3];   // ray distance to the next boundary on each axis, and between boundaries
+    for (int a=0; a<3; a++) {
+        v[a] = (int)floorf(o[a]);
+        step[a] = d[a] > 0 ? 1 : d[a] < 0 ? -1 : 0;
+        delta[a] = step[a] ? fabsf(1.0f/d[a]) : INFINITY;
+        next[a] = step[a] > 0 ? (v[a] + 1 - o[a])*delta[a] : step[a] < 0 ? (o[a] - v[a])*delta[a] : INFINITY;
+    }
+    int size[3] = { w->sx, w->sy, w->sz };
+    float t = 0.0f;
+    while (t <= max_dist) {   // voxel walk (Amanatides & Woo): one boundary per step
+        bool inside = true;
+        for (int a=0; a<3; a++) {
+            if (v[a] >= 0 && v[a] < size[a]) continue;
+            inside = false;
+            if ((v[a] < 0 && step[a] <= 0) || (v[a] >= size[a] && step[a] >= 0)) return 0;   // leaving for good
+        }
+        if (inside) {
+            uint16_t id = w->v[idx3D(w, v[0], v[1], v[2])];
+            if (id) {
+                if (hit)    { hit[0] = v[0]; hit[1] = v[1]; hit[2] = v[2]; }
+                if (normal) { normal[0] = n[0]; normal[1] = n[1]; normal[2] = n[2]; }
+                return id;
+            }
+        }
+        int a = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+        t = next[a];
+        next[a] += delta[a];
+        v[a] += step[a];
+        n[0] = n[1] = n[2] = 0;
+        n[a] = -step[a];
+    }
+    return 0;
+}
+
+uint16_t engine_raycast(Engine* e, float ox,float oy,float oz, float dx,float dy,float dz,
+                        float max_dist, int hit[3], int normal[3]) {
+    if (!e) return 0;
+    float len = sqrtf(dx*dx + dy*dy + dz*dz);
+    if (len <= 0.0f || !(max_dist > 0.0f) || !world_read_enter(&e->world)) return 0;
+    uint16_t id = e->world.v ? raycast_walk(&e->world, ox,oy,oz, dx/len,dy/len,dz/len, max_dist, hit, normal) : 0;
+    world_read_leave(&e->world);
+    return id;
 }
 
 void engine_fill_box(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t id) {
@@ -180,17 +264,151 @@ void engine_fill_box(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1, uint
     x1 = x1>=e->world.sx?e->world.sx-1:x1;
     y1 = y1>=e->world.sy?e->world.sy-1:y1;
     z1 = z1>=e->world.sz?e->world.sz-1:z1;
+    if (x0>x1 || y0>y1 || z0>z1) return;   // entirely outside the world
+    chunks_write_begin(e, x0,y0,z0, x1,y1,z1);
     for (int z=z0; z<=z1; z++)
     for (int y=y0; y<=y1; y++) {
         int base = y*e->world.sx + z*e->world.sx*e->world.sy;
         for (int x=x0; x<=x1; x++) e->world.v[base + x] = id;
     }
+    chunks_write_end(e, x0,y0,z0, x1,y1,z1);
+    chunks_mark_dirty(e, x0,y0,z0, x1,y1,z1);
+    changes_box(e, ENGINE_CHANGE_BOX, x0,y0,z0, x1,y1,z1, id);   // one record, not one per voxel
+}
+
+// Lock-free: copied a row of up to READ_SPAN chunks along x at a time under their
+// seqlocks, so no chunk comes out half before and half after an edit.
+#define READ_SPAN 64
+void engine_read_region(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz, uint16_t* out) {
+    if (!e || !out || dx<=0 || dy<=0 || dz<=0) return;
+    World* w = &e->world;
+    size_t total = (size_t)dx*dy*dz;
+    if (!world_read_enter(w)) { memset(out, 0, total*sizeof(uint16_t)); return; }
+    // the part inside the world, [b0, b1); the rest reads as air
+    int64_t ex = (int64_t)x0+dx, ey = (int64_t)y0+dy, ez = (int64_t)z0+dz;
+    int bx0 = x0<0?0:x0, by0 = y0<0?0:y0, bz0 = z0<0?0:z0;
+    int bx1 = ex > w->sx ? w->sx : (int)ex;
+    int by1 = ey > w->sy ? w->sy : (int)ey;
+    int bz1 = ez > w->sz ? w->sz : (int)ez;
+    if (!w->v || bx0>=bx1 || by0>=by1 || bz0>=bz1) {
+        memset(out, 0, total*sizeof(uint16_t));
+        world_read_leave(w);
+        return;
+    }
+    if (bx0 > x0 || by0 > y0 || bz0 > z0 || bx1 < ex || by1 < ey || bz1 < ez) memset(out, 0, total*sizeof(uint16_t));
+
+    for (int cz=bz0/CHUNK_SIZE; cz<=(bz1-1)/CHUNK_SIZE; cz++)
+    for (int cy=by0/CHUNK_SIZE; cy<=(by1-1)/CHUNK_SIZE; cy++)
+    for (int ca=bx0/CHUNK_SIZE; ca<=(bx1-1)/CHUNK_SIZE; ca+=READ_SPAN) {
+        int cb = ca+READ_SPAN-1 < (bx1-1)/CHUNK_SIZE ? ca+READ_SPAN-1 : (bx1-1)/CHUNK_SIZE;
+        int xa = ca*CHUNK_SIZE > bx0 ? ca*CHUNK_SIZE : bx0, xb = (cb+1)*CHUNK_SIZE < bx1 ? (cb+1)*CHUNK_SIZE : bx1;
+        int ya = cy*CHUNK_SIZE > by0 ? cy*CHUNK_SIZE : by0, yb = (cy+1)*CHUNK_SIZE < by1 ? (cy+1)*CHUNK_SIZE : by1;
+        int za = cz*CHUNK_SIZE > bz0 ? cz*CHUNK_SIZE : bz0, zb = (cz+1)*CHUNK_SIZE < bz1 ? (cz+1)*CHUNK_SIZE : bz1;
+        const Chunk* c = &w->chunks[chunkIndex(w, ca,cy,cz)];   // ca..cb are consecutive
+        uint32_t seq[READ_SPAN];
+        bool torn;
+        do {
+            for (int i=0; i<=cb-ca; i++) seq[i] = chunk_read_begin(&c[i]);
+            for (int z=za; z<zb; z++)
+            for (int y=ya; y<yb; y++)
+                memcpy(out + (size_t)(y-y0)*dx + (size_t)(z-z0)*dx*dy + (xa-x0), &w->v[idx3D(w, xa, y, z)], (size_t)(xb-xa)*sizeof(uint16_t));
+            torn = false;
+            for (int i=0; i<=cb-ca; i++) torn |= chunk_read_retry(&c[i], seq[i]);
+        } while (torn);
+    }
+    world_read_leave(w);
+}
+
+void engine_write_region(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz, const uint16_t* in) {
+    if (!e || !e->world.v || !in || dx<=0 || dy<=0 || dz<=0) return;
+    World* w = &e->world;
+    // the part inside the world, [b0, b1), clipped in 64 bits so far-off origins miss
+    int64_t ex = (int64_t)x0+dx, ey = (int64_t)y0+dy, ez = (int64_t)z0+dz;
+    int bx0 = x0<0?0:x0, by0 = y0<0?0:y0, bz0 = z0<0?0:z0;
+    int bx1 = ex > w->sx ? w->sx : (int)ex;
+    int by1 = ey > w->sy ? w->sy : (int)ey;
+    int bz1 = ez > w->sz ? w->sz : (int)ez;
+    if (bx0 >= bx1 || by0 >= by1 || bz0 >= bz1) return;
+    chunks_write_begin(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+    for (int z=bz0; z<bz1; z++)
+    for (int y=by0; y<by1; y++)
+        memcpy(&w->v[idx3D(w, bx0, y, z)], in + (size_t)(y-y0)*dx + (size_t)(z-z0)*dx*dy + (bx0-x0), (size_t)(bx1-bx0)*sizeof(uint16_t));
+    chunks_write_end(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+    chunks_mark_dirty(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+    changes_box(e, ENGINE_CHANGE_BOX, bx0,by0,bz0, bx1-1,by1-1,bz1-1, ENGINE_CHANGE_MIXED);
+}
+
+// True when an RLE payload covers exactly n voxels with no trailing bytes.
+static bool rle_covers(const uint8_t* data, int len, int64_t n) {
+    if (len & 1) return false;
+    int64_t o = 0;
+    for (int i=0; i<len; i+=2) { o += data[i]; if (o > n) return false; }
+    return o == n;
+}
+
+bool world_decode_box(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz,
+                      const uint8_t* data, int len, bool rle) {
+    if (!e || !e->world.v || !data || dx<=0 || dy<=0 || dz<=0) return false;
+    World* w = &e->world;
+    int64_t n = (int64_t)dx*dy*dz;
+    if (!rle && len != n) return false;
+
+    // the part of the box inside the world, [b0, b1), in 64 bits: a far-off origin
+    // plus its size must not wrap back into the world
+    int64_t ex = (int64_t)x0+dx, ey = (int64_t)y0+dy, ez = (int64_t)z0+dz;
+    int bx0 = x0<0?0:x0, by0 = y0<0?0:y0, bz0 = z0<0?0:z0;
+    int bx1 = ex > w->sx ? w->sx : (int)ex;
+    int by1 = ey > w->sy ? w->sy : (int)ey;
+    int bz1 = ez > w->sz ? w->sz : (int)ez;
+    if (bx0>=bx1 || by0>=by1 || bz0>=bz1) return !rle || rle_covers(data, len, n);
+    chunks_write_begin(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+
+    // Walk the box in source order one row span at a time: a raw row or an RLE run
+    // is written directly into the world, clipped to it.
+    int64_t o = 0;
+    int  i = 0;
+    bool ok = true;
+    while (o < n) {
+        int run;
+        uint8_t id = 0;
+        const uint8_t* src = NULL;
+        if (rle) {
+            if (i + 1 >= len) { ok = false; break; }   // payload ended early
+            run = data[i]; id = data[i+1]; i += 2;
+            if (o + run > n) { ok = false; break; }
+        } else {
+            run = (int)(n - o); src = data;   // everything, row by row
+        }
+        while (run > 0) {
+            int lx = (int)(o % dx), ly = (int)((o / dx) % dy), lz = (int)(o / ((int64_t)dx*dy));
+            int span = dx - lx < run ? dx - lx : run;
+            int64_t x = (int64_t)x0+lx, y = (int64_t)y0+ly, z = (int64_t)z0+lz;
+            if (y>=0 && z>=0 && y<w->sy && z<w->sz) {
+                int64_t a = x < 0 ? -x : 0;                       // clip the span to [0, sx)
+                int64_t b = x + span > w->sx ? w->sx - x : span;
+                if (a < b) {
+                    uint16_t* dst = &w->v[idx3D(w, (int)(x+a), (int)y, (int)z)];
+                    if (src) for (int64_t k=a; k<b; k++) dst[k-a] = src[o+k];
+                    else     for (int64_t k=a; k<b; k++) dst[k-a] = id;
+                }
+            }
+            o += span; run -= span;
+        }
+    }
+    if (rle && i != len) ok = false;           // trailing bytes
+
+    // whatever was written (even from a bad payload) must reach the meshes
+    chunks_write_end(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+    chunks_mark_dirty(e, bx0,by0,bz0, bx1-1,by1-1,bz1-1);
+    changes_box(e, ENGINE_CHANGE_BOX, bx0,by0,bz0, bx1-1,by1-1,bz1-1, ENGINE_CHANGE_MIXED);
+    return ok;
 }
 
 void engine_set_camera_pose(Engine* e, float x,float y,float z, float yaw,float pitch) {
     if (!e) return;
     e->cam.position = (Vector3){x,y,z};
     e->yaw = yaw; e->pitch = pitch;
+    if (e->rec) replay_record_camera(e);
 }
 
 void engine_get_camera_pose(Engine* e, float* x,float* y,float* z, float* yaw,float* pitch) {
@@ -202,13 +420,62 @@ void engine_get_camera_pose(Engine* e, float* x,float* y,float* z, float* yaw,fl
     if (pitch) *pitch = e->pitch;
 }
 
-static void process_input(Engine* e, float dt) {
+void engine_set_lod_distances(Engine* e, float lod1, float lod2, float lod3, float view_dist) {
+    if (!e) return;
+    e->lod_dist[0] = lod1; e->lod_dist[1] = lod2; e->lod_dist[2] = lod3;
+    e->view_dist = view_dist;
+}
+
+void engine_set_mesh_budget(Engine* e, int chunks_per_frame) {
+    if (!e) return;
+    e->mesh_budget = chunks_per_frame > 0 ? chunks_per_frame : 1;
+}
+
+void engine_set_render_mode(Engine* e, int mode) {
+    if (!e || mode < ENGINE_RENDER_MESHED || mode > ENGINE_RENDER_SOFTWARE) return;
+    e->render_mode = mode;
+}
+
+int engine_get_render_mode(Engine* e) {
+    return e ? e->render_mode : ENGINE_RENDER_MESHED;
+}
+
+void engine_set_occlusion(Engine* e, bool enabled) {
+    if (!e) return;
+    e->occlusion = enabled;
+}
+
+void engine_set_cave_culling(Engine* e, bool enabled) {
+    if (!e) return;
+    e->cave_culling = enabled;
+}
+
+void engine_set_command_budget(Engine* e, float budget_ms) {
+    if (!e) return;
+    e->cmd_budget_ms = budget_ms > 0 ? budget_ms : 0.1f;
+}
+
+void engine_get_chunk_stats(Engine* e, int* drawn, int* occluded, int* triangles) {
+    if (!e) return;
+    if (drawn) *drawn = e->chunks_drawn;
+    if (occluded) *occluded = e->chunks_occluded;
+    if (triangles) *triangles = e->tris_drawn;
+}
+
+// Read keyboard/mouse once per frame on the window thread. Only window state (the
+// cursor lock) changes here; everything else is left in *s for input_apply.
+void input_sample(Engine* e, InputSample* s) {
+    memset(s, 0, sizeof(*s));
+
     // Toggle cursor lock
     if (IsKeyPressed(KEY_TAB)) {
         e->cursor_locked = !e->cursor_locked;
         if (e->cursor_locked) DisableCursor(); else EnableCursor();
     }
 
+    // Cycle renderer (meshed -> instanced -> cubes -> software)
+    if (IsKeyPressed(KEY_F2)) s->mode_steps = 1;
+
     // Mouse look
     if (e->cursor_locked) {
         Vector2 d = GetMouseDelta();
@@ -217,92 +484,251 @@ static void process_input(Engine* e, float dt) {
         float mx = e->invert_mouse_x ? -d.x : d.x;
         float my = e->invert_mouse_y ? -d.y : d.y;   // invert Y when true (Minecraft-style)
 
-        e->yaw   += mx * sens;    // horizontal: mouse-right -> look-right
-        e->pitch += my * sens;    // vertical: sign controlled by invert_mouse_y
+        s->dyaw   = mx * sens;    // horizontal: mouse-right -> look-right
+        s->dpitch = my * sens;    // vertical: sign controlled by invert_mouse_y
+    }
+
+    uint8_t k = 0;
+    if (IsKeyDown(KEY_W)) k |= INPUT_W;
+    if (IsKeyDown(KEY_A)) k |= INPUT_A;
+    if (IsKeyDown(KEY_S)) k |= INPUT_S;
+    if (IsKeyDown(KEY_D)) k |= INPUT_D;
+    if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) k |= INPUT_SPRINT;
+    if (IsKeyPressed(KEY_SPACE)) k |= INPUT_JUMP;
+    s->keys = k;
 
-        float limit = PI/2.2f;
-        if (e->pitch > limit) e->pitch = limit;
-        if (e->pitch < -limit) e->pitch = -limit;
+    s->nevents = events_sample_input(e, s->events, INPUT_EVENTS_MAX);   // key/mouse transitions for engine_poll_events
+}
+
+// Sampled input -> simulation state: renderer, look angles, movement keys, events.
+void input_apply(Engine* e, const InputSample* s) {
+    if (s->mode_steps) e->render_mode = (e->render_mode + s->mode_steps) % 4;
+    if (s->dyaw != 0 || s->dpitch != 0) {
+        e->yaw  += s->dyaw;
+        e->pitch = look_pitch(e->pitch + s->dpitch);
     }
+    e->in.keys = s->keys;
+    for (int i=0; i<s->nevents; i++) events_push(e, s->events[i]);
+}
 
+void player_step(const Engine* e, PlayerState* p, uint8_t keys, float yaw, float pitch, float dt) {
     // Build forward/right
-    float cp = cosf(e->pitch), sp = sinf(e->pitch);
-    float sy = sinf(e->yaw),   cy = cosf(e->yaw);
+    float cp = cosf(pitch), sp = sinf(pitch);
+    float sy = sinf(yaw),   cy = cosf(yaw);
     Vector3 forward = (Vector3){ cp*sy, sp, -cp*cy };
 
     Vector3 fg = (Vector3){ forward.x, 0, forward.z };
     float len = Vector3Length(fg);
     if (len > 1e-4f) fg = Vector3Scale(fg, 1.0f/len);
-    Vector3 right = Vector3Normalize(Vector3CrossProduct(forward, e->cam.up));
+    Vector3 right = Vector3Normalize(Vector3CrossProduct(forward, (Vector3){ 0, 1, 0 }));
 
     float speed = e->move_speed;
-    if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) speed *= e->sprint_mult;
+    if (keys & INPUT_SPRINT) speed *= e->sprint_mult;
 
     Vector3 move = (Vector3){0,0,0};
-    if (IsKeyDown(KEY_W)) move = Vector3Add(move, fg);
-    if (IsKeyDown(KEY_S)) move = Vector3Subtract(move, fg);
-    if (IsKeyDown(KEY_A)) move = Vector3Subtract(move, right);
-    if (IsKeyDown(KEY_D)) move = Vector3Add(move, right);
+    if (keys & INPUT_W) move = Vector3Add(move, fg);
+    if (keys & INPUT_S) move = Vector3Subtract(move, fg);
+    if (keys & INPUT_A) move = Vector3Subtract(move, right);
+    if (keys & INPUT_D) move = Vector3Add(move, right);
     float m = Vector3Length(move);
     if (m > 1e-4f) move = Vector3Scale(move, 1.0f/m);
 
-    e->cam.position = Vector3Add(e->cam.position, Vector3Scale(move, speed*dt));
+    p->pos = Vector3Add(p->pos, Vector3Scale(move, speed*dt));
 
     // gravity + simple ground (y=0)
-    e->velY += e->gravity*dt;
-    e->cam.position.y += e->velY*dt;
+    p->vel_y += e->gravity*dt;
+    p->pos.y += p->vel_y*dt;
     float minY = 0.0f + e->eye_height;
     bool onGround = false;
-    if (e->cam.position.y <= minY) {
-        e->cam.position.y = minY; e->velY = 0; onGround = true;
+    if (p->pos.y <= minY) {
+        p->pos.y = minY; p->vel_y = 0; onGround = true;
     }
-    if (onGround && IsKeyPressed(KEY_SPACE)) e->velY = e->jump_speed;
-
-    e->cam.target = Vector3Add(e->cam.position, forward);
+    if (onGround && (keys & INPUT_JUMP)) p->vel_y = e->jump_speed;
 }
 
-static void draw_world(Engine* e) {
-    BeginMode3D(e->cam);
-    DrawGrid(32, 1.0f);
+// Movement + gravity from the sampled input; updates the camera.
+static void step_physics(Engine* e, float dt) {
+    if (e->net) dt = player_input_dt(dt);   // what the server will step this input with
+    PlayerState p = { e->cam.position, e->velY };
+    player_step(e, &p, e->in.keys, e->yaw, e->pitch, dt);
+    e->cam.position = p.pos;
+    e->velY = p.vel_y;
 
-    if (!e->world.v || !e->atlas.tiles) {
-        EndMode3D();
-        return;
-    }
+    float cp = cosf(e->pitch);
+    Vector3 forward = (Vector3){ cp*sinf(e->yaw), sinf(e->pitch), -cp*cosf(e->yaw) };
+    e->cam.target = Vector3Add(e->cam.position, forward);
+}
 
-    // VERY NAIVE: draw every nonzero block.
-    // Start small (e.g. 64^3). Optimize later with chunking/meshing.
-    // VERY NAIVE: draw every nonzero block.
+// Reference renderer: one DrawCube per nonzero block. Fine for 64^3, not beyond.
+static void draw_world_cubes(Engine* e) {
+    e->chunks_drawn = 0; e->tris_drawn = 0;
     for (int z=0; z<e->world.sz; z++)
     for (int y=0; y<e->world.sy; y++)
     for (int x=0; x<e->world.sx; x++) {
         uint16_t id = e->world.v[idx3D(&e->world,x,y,z)];
-        if (!id) continue;
+        if (!id || id >= 256) continue;
         uint16_t tile = e->defs.tile_of_block[id];
         if (tile == 0xFFFF || tile >= e->atlas.tile_count) continue;
-        // If we had per-tile textures and DrawCubeTexture is available you can swap back later.
-        // For broad compatibility use colored cubes for now:
         Vector3 pos = (Vector3){ (float)x, (float)y, (float)z };
-        Color c = tileColorForIndex((int)tile);
-        DrawCube(pos, 1.0f, 1.0f, 1.0f, c);
+        DrawCube(pos, 1.0f, 1.0f, 1.0f, tileColorForIndex((int)tile));
         DrawCubeWires(pos, 1.0f, 1.0f, 1.0f, Fade(BLACK, 0.2f));
+        e->tris_drawn += 12;
+        e->cur.draw_calls += 2;
+    }
+}
+
+// One simulation tick: edits from every source, then `in` (NULL: none, or a
+// replay's), physics and whatever is published after it; *physics_ms gets the time
+// from physics on. False when a replay has ended.
+bool simulate_tick(Engine* e, float dt, const InputSample* in, float* physics_ms) {
+    engine_begin_edit(e);   // the tick's edits reach the mesher together
+    if (e->replay && !replay_begin_tick(e, &dt)) { engine_commit_edit(e); return false; }   // end of the log
+    cmdserver_apply(e);   // world edits from the command server, sockets, edit ring and shm ring land before this frame
+    sockserver_poll(e, dt);
+    netclient_poll(e);
+    edits_apply(e);
+    shm_apply(e);
+    engine_commit_edit(e);
+    if (in && !e->replay) input_apply(e, in);   // a replay brings its own input
+    double t1 = stats_now();
+    step_physics(e, dt);
+    replay_end_tick(e, dt);
+    netclient_send_input(e, dt);
+    events_player(e);
+    shm_publish(e);
+    sockserver_publish(e);
+    e->ticks++;
+    *physics_ms = (float)((stats_now()-t1)*1000.0);
+    return true;
+}
+
+void view_capture(Engine* e, RenderView* v) {
+    v->cam = e->cam;
+    v->yaw = e->yaw; v->pitch = e->pitch;
+    v->mode = e->render_mode;
+    v->nplayers = netclient_players(e, v->players, VIEW_PLAYERS);
+}
+
+// Other players (when connected to a server), eye at the top of a 0.6 x 1.8 box.
+static void draw_players(Engine* e) {
+    for (int i=0; i<e->view.nplayers; i++) {
+        const ViewPlayer* p = &e->view.players[i];
+        Vector3 c = { p->pos[0], p->pos[1] - e->eye_height + 0.9f, p->pos[2] };
+        DrawCube(c, 0.6f, 1.8f, 0.6f, tileColorForIndex((int)p->id));
+        DrawCubeWires(c, 0.6f, 1.8f, 0.6f, DARKGRAY);
+    }
+}
+
+// Draws e->view. The meshed renderer culls and meshes without the simulation
+// thread's world lock (chunk seqlocks, mesh.c), so it never waits for a tick;
+// the other renderers read the world under it.
+static void draw_world(Engine* e) {
+    if (e->view.mode == ENGINE_RENDER_SOFTWARE) {   // softrast.c: a 2D blit of the CPU frame
+        simthread_lock(e);
+        softrast_draw(e);
+        simthread_unlock(e);
+        return;
     }
+    bool meshed = e->view.mode == ENGINE_RENDER_MESHED;
+    if (meshed && !chunks_prepare(e)) simthread_stale_frame(e);   // world being replaced: last list again
+    if (!meshed) simthread_lock(e);
+    bool drawable = !meshed && e->world.v && e->atlas.tiles;
 
+    BeginMode3D(e->view.cam);
+    DrawGrid(32, 1.0f);
+    draw_players(e);
+    switch (e->view.mode) {
+        case ENGINE_RENDER_INSTANCED: if (drawable) draw_chunks_instanced(e); break; // instanced.c
+        case ENGINE_RENDER_CUBES:     if (drawable) draw_world_cubes(e);      break;
+        default:                      chunks_submit(e);                       break; // mesh.c, LOD by distance
+    }
     EndMode3D();
+    if (!meshed) simthread_unlock(e);
 }
 
 bool engine_tick(Engine* e, float dt) {
     if (!e) return false;
-    if (WindowShouldClose()) return false;
-
-    process_input(e, dt);
+    if (!e->headless && WindowShouldClose()) return false;
+
+    double t0 = stats_now();
+    float physics_ms;
+    if (e->sim) {   // simthread.c ticks the world: hand it our input, draw its latest view
+        if (!simthread_begin_frame(e, &physics_ms)) return false;   // the replay it played has ended
+    } else {
+        InputSample in;
+        bool live = !e->headless && !e->replay;
+        if (live) input_sample(e, &in);
+        if (!simulate_tick(e, dt, live ? &in : NULL, &physics_ms)) return false;
+        view_capture(e, &e->view);
+    }
+    double t2 = stats_now();
+    float input_ms = (float)((t2-t0)*1000.0) - (e->sim ? 0 : physics_ms);
+
+    if (e->headless) {   // no window: only the software renderer draws; pace to tick_hz ourselves (a replay runs flat out)
+        if (e->view.mode == ENGINE_RENDER_SOFTWARE) {
+            simthread_lock(e);
+            softrast_draw(e);
+            simthread_unlock(e);
+        }
+        double t3 = stats_now();
+        if ((e->sim || !e->replay) && e->tick_hz > 0) stats_sleep_until(t0 + 1.0/e->tick_hz);
+        double t4 = stats_now();
+        e->cur.input_ms   = input_ms;
+        e->cur.physics_ms = physics_ms;
+        e->cur.draw_ms    = (float)((t3-t2)*1000.0) - e->cur.cull_ms - e->cur.mesh_ms - e->cur.upload_ms;
+        e->cur.present_ms = (float)((t4-t3)*1000.0);
+        e->cur.frame_ms   = (float)((t4-t0)*1000.0);
+        stats_end_frame(e);
+        return true;
+    }
 
     BeginDrawing();
     ClearBackground(RAYWHITE);
     draw_world(e);
-    DrawText("WASD move | SPACE jump | SHIFT sprint | TAB cursor", 10, 10, 14, DARKGRAY);
+    DrawText("WASD move | SPACE jump | SHIFT sprint | TAB cursor | F2 renderer", 10, 10, 14, DARKGRAY);
     DrawFPS(10, 30);
-    EndDrawing();
+    static const char* kModeName[] = { "meshed", "instanced", "cubes", "software" };
+    DrawText(TextFormat("%s | chunks %d (occluded %d) | tris %d", kModeName[e->view.mode],
+                        e->chunks_drawn, e->chunks_occluded, e->tris_drawn), 10, 50, 14, DARKGRAY);
+    double t3 = stats_now();
+    EndDrawing();   // swap + frame pacing
+    double t4 = stats_now();
+
+    e->cur.input_ms   = input_ms;
+    e->cur.physics_ms = physics_ms;
+    e->cur.draw_ms    = (float)((t3-t2)*1000.0) - e->cur.cull_ms - e->cur.mesh_ms - e->cur.upload_ms;
+    e->cur.present_ms = (float)((t4-t3)*1000.0);
+    e->cur.frame_ms   = (float)((t4-t0)*1000.0);
+    stats_end_frame(e);
 
     return true;
 }
+
+void engine_run(Engine* e, EngineRunCallback callback, float callback_hz) {
+    if (!e) return;
+    double prev = stats_now();
+    double next_call = prev;
+    for (;;) {
+        double now = stats_now();
+        float dt = (float)(now - prev);
+        prev = now;
+        if (dt > 0.1f) dt = 0.1f;   // a stall must not turn into one huge physics step
+        if (!engine_tick(e, dt)) break;
+        if (!callback) continue;
+
+        bool call = false;
+        if (callback_hz > 0) {
+            now = stats_now();
+            call = now >= next_call;
+            if (call) {
+                next_call += 1.0/callback_hz;
+                if (next_call < now) next_call = now;   // don't burst after a slow frame
+            }
+        }
+        engine_lock(e);   // a simulation thread must not tick under the callback
+        if (callback_hz <= 0) call = e->ev_count > 0;
+        bool go = !call || callback(e);
+        engine_unlock(e);
+        if (!go) break;
+    }
+}
@@ -9,7 +9,13 @@ extern "C" {
 typedef struct Engine Engine;   // opaque
 
 // Create/destroy
-Engine* engine_create(int width, int height, const char* title, int target_fps);
+Engine* engine_create(int width, int height, const char* title, int target_fps);   // target_fps 0 = uncapped
+// Dedicated-server mode: no window, no GL, no keyboard/mouse. engine_tick applies
+// queued edits, runs physics and services servers, then sleeps to hold tick_hz
+// (0 = 60, negative = never sleeps, for benchmarks); it only returns false at the
+// end of a replay. engine_load_atlas only takes the tile grid (block colours);
+// ENGINE_RENDER_SOFTWARE is the one renderer that draws.
+Engine* engine_create_headless(int tick_hz);
 void    engine_destroy(Engine* e);
 
 // Camera control (optional; engine also handles WASD/mouse)
@@ -26,18 +32,321 @@ bool engine_define_block_tile(Engine* e, uint16_t block_id, int tile_index);
 
 // World allocation (simple dense 3D array; start small: 64x64x64)
 bool engine_create_world(Engine* e, int sx, int sy, int sz);
+bool engine_get_world_size(Engine* e, int* sx, int* sy, int* sz); // false when there is no world
 void engine_clear_world(Engine* e, uint16_t block_id); // fill entire world with id (0 = empty)
 
-// Set/Read blocks
+// Set/Read blocks. The readers (engine_get_block, engine_raycast, engine_read_region,
+// engine_get_world_size) take no lock and may run on any thread while another edits:
+// every chunk carries a seqlock, and a region copy is retried chunk by chunk until no
+// edit landed in the middle of it. Writers still go one at a time.
 bool engine_set_block(Engine* e, int x, int y, int z, uint16_t block_id);
 uint16_t engine_get_block(Engine* e, int x, int y, int z);
+// First non-empty voxel along the ray from (ox,oy,oz) in direction (dx,dy,dz), within
+// max_dist: returns its id (0 = nothing hit) and, if not NULL, its coordinates and the
+// face normal it was entered through (all 0 when the ray starts inside a block).
+uint16_t engine_raycast(Engine* e, float ox, float oy, float oz, float dx, float dy, float dz,
+                        float max_dist, int hit[3], int normal[3]);
+
+// Edit batches: between engine_begin_edit and engine_commit_edit, edits (any call
+// that changes voxels) apply as usual but the chunks they dirty are only collected;
+// the commit marks each once, so the renderer remeshes a structure built from
+// hundreds of engine_set_block calls once instead of chasing it frame by frame
+// (frames drawn before the commit keep the old meshes). Batches nest: only the
+// outermost commit marks. Each tick batches the edits it applies.
+void engine_begin_edit(Engine* e);
+void engine_commit_edit(Engine* e);
 
 // Main step: processes input, draws a frame, returns false to request quit
 bool engine_tick(Engine* e, float dt);
 
+// Run the frame loop in C until the window closes or the callback returns false.
+// The callback is invoked after the tick at most callback_hz times per second;
+// with callback_hz <= 0 it runs only after ticks that left events to poll.
+// dt is measured per frame (capped at 0.1 s). The callback runs under engine_lock.
+typedef bool (*EngineRunCallback)(Engine* e);
+void engine_run(Engine* e, EngineRunCallback callback, float callback_hz);
+
+// Profiling. Every tick records one EngineFrameStats into a ring of the last 1024
+// frames; pull it in bulk (e.g. once a second) instead of querying every frame.
+typedef struct {
+    uint64_t frame;               // tick number
+    float input_ms;               // command server queue + edit ring + keyboard/mouse sampling + mouse look
+    float physics_ms;             // movement + gravity (sim thread: its latest whole tick)
+    float cull_ms;                // frustum/cave/occlusion culling
+    float mesh_ms;                // CPU chunk meshing (or instance buffer rebuilds)
+    float upload_ms;              // mesh upload to the GPU
+    float draw_ms;                // draw submission (excl. the stages above)
+    float present_ms;             // EndDrawing: buffer swap + frame pacing wait
+    float frame_ms;               // whole engine_tick
+    int32_t draw_calls, triangles;
+    int32_t chunks_visible;       // chunks left after culling
+    int32_t chunks_drawn;         // ... of which had geometry
+    int32_t chunks_occluded;      // dropped by occlusion culling
+    int32_t chunks_meshed;        // meshes / instance buffers rebuilt this frame
+} EngineFrameStats;
+
+typedef struct {
+    uint64_t world_bytes;         // dense voxel array
+    uint64_t chunk_bytes;         // chunk table + culling scratch
+    uint64_t mesh_bytes;          // chunk mesh vertex data (CPU copy, mirrored on the GPU)
+    uint64_t instance_bytes;      // instanced renderer transform buffers
+    uint64_t stats_bytes;         // this stats ring
+} EngineMemoryStats;
+
+// Latest completed frame; false before the first tick.
+bool engine_get_stats(Engine* e, EngineFrameStats* out);
+// Copy up to max most recent frames into out, oldest first; returns the count.
+int  engine_get_stats_history(Engine* e, EngineFrameStats* out, int max);
+// frame_ms percentiles over the ring (any pointer may be NULL); false when empty.
+bool engine_get_frame_percentiles(Engine* e, float* p50, float* p95, float* p99);
+void engine_get_memory_stats(Engine* e, EngineMemoryStats* out);
+
 // Convenience: build a flat terrain column (helper)
 void engine_fill_box(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t block_id);
 
+// Bulk copies of a dx*dy*dz box, x fastest, then y, then z (same layout as the
+// world array). Voxels outside the world read as 0 and are skipped on write.
+void engine_read_region(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz, uint16_t* out);
+void engine_write_region(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz, const uint16_t* in);
+
+// Snapshots: the whole world frozen as it is now, for a saver or other background
+// work that must see one consistent version. Taking one copies no voxels; each
+// chunk is copied only when it is next edited, and only while a snapshot still
+// holds its old version, so writers never wait for snapshot readers. Take it
+// where edits are serialized (under engine_lock with a sim thread); read it from
+// any thread, also after the world was replaced, until released. Reads must not
+// overlap engine_destroy; releasing after it is fine.
+typedef struct EngineSnapshot EngineSnapshot;
+EngineSnapshot* engine_snapshot_world(Engine* e);   // NULL when there is no world
+void engine_snapshot_size(const EngineSnapshot* s, int* sx, int* sy, int* sz);
+void engine_snapshot_read_region(const EngineSnapshot* s, int x0,int y0,int z0, int dx,int dy,int dz, uint16_t* out);   // as engine_read_region
+void engine_release_snapshot(EngineSnapshot* s);
+
+// Level of detail: the world is drawn as 16^3 chunk meshes. Chunks farther than
+// lod1/lod2/lod3 use meshes with 2x/4x/8x merged voxels; beyond view_dist they are skipped.
+void engine_set_lod_distances(Engine* e, float lod1, float lod2, float lod3, float view_dist);
+// Max chunk meshes (re)built per frame (nearest first); default 8.
+void engine_set_mesh_budget(Engine* e, int chunks_per_frame);
+
+// Renderer selection (also cycled with F2):
+//   MESHED    - per-chunk meshes with LOD (default)
+//   INSTANCED - exposed blocks as instanced unit cubes, one draw per tile
+//   CUBES     - reference path, one DrawCube per block
+//   SOFTWARE  - the MESHED chunk meshes rasterized on the CPU into an in-memory
+//               frame (softrast.c); works headless, no GPU needed
+enum { ENGINE_RENDER_MESHED = 0, ENGINE_RENDER_INSTANCED = 1, ENGINE_RENDER_CUBES = 2, ENGINE_RENDER_SOFTWARE = 3 };
+void engine_set_render_mode(Engine* e, int mode);
+int  engine_get_render_mode(Engine* e);
+
+// Software renderer target: width x height pixels (0 = the window, or 640x360
+// headless, where it also sets the aspect culling uses), rasterized by `threads`
+// workers (0 = one per core, at most 8). The image is the same for any thread count.
+bool engine_set_software_target(Engine* e, int width, int height, int threads);
+// Last software frame: RGBA8, top row first; NULL before the first one.
+const uint8_t* engine_get_software_frame(Engine* e, int* width, int* height);
+bool engine_save_software_frame(Engine* e, const char* path);   // binary PPM (P6), for golden images
+
+// Software occlusion culling (on by default): solid chunk bases are rasterized into a
+// small CPU depth buffer and chunks hidden behind them are skipped.
+void engine_set_occlusion(Engine* e, bool enabled);
+// Cave culling (on by default): chunks are found by a BFS from the camera chunk that
+// only passes between chunk faces connected through air, so chunks hidden underground
+// (or in sealed caves) are never visited. Falls back to a full scan outside the world.
+void engine_set_cave_culling(Engine* e, bool enabled);
+// Last frame: chunks drawn, chunks dropped by occlusion, triangles submitted (any may be NULL).
+void engine_get_chunk_stats(Engine* e, int* drawn, int* occluded, int* triangles);
+
+// Edit ring: lock-free single-producer queue of block edits. ONE controller thread
+// may push while another thread runs engine_tick; each tick applies up to the edit
+// budget (default 16384) in push order. Returns how many edits fit (0..n) — the
+// ring holds 65536, so retry the rest after a tick when it is full.
+typedef struct {
+    int32_t  x, y, z;
+    uint16_t id;
+    uint16_t _pad;
+} EngineEdit;
+int  engine_queue_edits(Engine* e, const EngineEdit* edits, int n);
+int  engine_pending_edits(Engine* e);       // pushed but not yet applied
+void engine_set_edit_budget(Engine* e, int edits_per_frame);
+
+// Events: key/mouse transitions sampled by engine_tick and the player pose after
+// each tick in which it changed, kept in a ring of the last 1024. Drain them in
+// one call per frame (or less often); returns the number copied, oldest first.
+enum {
+    ENGINE_EVENT_KEY_DOWN   = 1,  // code = raylib KEY_*
+    ENGINE_EVENT_KEY_UP     = 2,
+    ENGINE_EVENT_MOUSE_DOWN = 3,  // code = MOUSE_BUTTON_* (0 left, 1 right, 2 middle), x/y = screen position
+    ENGINE_EVENT_MOUSE_UP   = 4,
+    ENGINE_EVENT_PLAYER     = 5,  // x/y/z = camera position, yaw/pitch
+};
+typedef struct {
+    uint32_t type;                // ENGINE_EVENT_*
+    uint32_t frame;               // tick it was recorded in
+    int32_t  code;
+    float    x, y, z;
+    float    yaw, pitch;
+} EngineEvent;
+int      engine_poll_events(Engine* e, EngineEvent* buf, int max);
+uint32_t engine_events_dropped(Engine* e);   // overwritten before being polled, total
+
+// Change feed (off by default): every world mutation is appended to a ring of the
+// last 65536 records. Single voxel writes are BLOCK records with old/new id; box
+// writes (fill_box, clear_world, command server chunks) are one BOX record with
+// old_id = MIXED (chunk payloads also have new_id = MIXED: re-read that box);
+// engine_create_world adds a RESET. Readers keep their own cursor (start from
+// engine_change_cursor); engine_read_changes copies records at *cursor onward and
+// advances it, or returns -1 and jumps the cursor to the oldest record when the
+// ring has already overwritten some, or the feed was off since the cursor was
+// taken (enabling it skips one seq, so older cursors all read as stale) —
+// re-read the world then.
+enum { ENGINE_CHANGE_BLOCK = 0, ENGINE_CHANGE_BOX = 1, ENGINE_CHANGE_RESET = 2 };
+#define ENGINE_CHANGE_MIXED 0xFFFF
+typedef struct {
+    uint64_t seq;                 // position in the feed
+    uint64_t tick;                // engine_tick count when it happened
+    int32_t  x0, y0, z0;          // inclusive box (BLOCK: x0==x1, ...)
+    int32_t  x1, y1, z1;
+    uint16_t old_id, new_id;
+    uint8_t  kind;                // ENGINE_CHANGE_*
+    uint8_t  _pad[3];
+} EngineChange;
+void     engine_set_change_feed(Engine* e, bool enabled);
+uint64_t engine_change_cursor(Engine* e);   // seq of the next record
+int      engine_read_changes(Engine* e, uint64_t* cursor, EngineChange* out, int max);
+
+// Command server: read line-delimited JSON commands (protocol v0 in
+// notes/high-level-wrapper.md: init, set, fill, column, chunk, camera_set, clear,
+// flush, subscribe) from in_fd on a background thread, and write events (ready,
+// ack, error, quit, plus key_down/key_up/mouse_button/player from the event ring)
+// to out_fd. Parsed commands are queued and applied at the start of each
+// engine_tick, at most budget_ms per tick (default 4 ms); the rest waits for the
+// next tick. Typical use: engine_start_command_server(e, 0, 1) for stdin/stdout.
+// POSIX only; returns false on Windows or if a server is already running.
+// out_fd is switched to non-blocking while the server runs: lines a controller
+// does not read pile up to 1 MB, and past that are dropped and counted.
+bool engine_start_command_server(Engine* e, int in_fd, int out_fd);
+void engine_stop_command_server(Engine* e);
+uint32_t engine_command_events_dropped(Engine* e);   // lines dropped for a full out_fd, total
+void engine_set_command_budget(Engine* e, float budget_ms);
+
+// Socket server: listen on Unix-domain socket `path` for any number of clients
+// speaking the command server protocol. Serviced inside engine_tick (no threads):
+// each tick reads what clients sent, then applies up to a fixed number of each
+// client's commands, round-robin in connection order; the command budget only
+// cuts an overloaded tick short. Replies go to the sender; events
+// go to clients that sent {"op":"subscribe","events":[...]} with any of "key",
+// "mouse", "player", "change" (change records from the change feed, which this
+// turns on), "world" (binary replication, below). POSIX only; returns false on Windows or if already running.
+bool engine_start_socket_server(Engine* e, const char* path);
+void engine_stop_socket_server(Engine* e);   // closes every listener; also done by engine_destroy
+
+// The same server on TCP (host NULL = 127.0.0.1), alongside or instead of the Unix
+// socket. For a dedicated server (engine_create_headless) clients subscribe to
+// "world": a snapshot of every chunk (at most bytes_per_tick per client per tick,
+// default 64 KB), then one frame per tick with that tick's block writes; chunks
+// hit by box writes are resent. A client that sends {"op":"view","pos":[x,y,z],
+// "radius":r} only gets the chunk columns within r chunks of pos, nearest first,
+// deltas for those only, and the other clients' views in range. Frame layout at
+// the top of sockserver.c.
+bool engine_start_tcp_server(Engine* e, const char* host, int port);
+void engine_set_replication_budget(Engine* e, int bytes_per_tick);
+
+typedef struct {
+    int32_t  clients;             // connected, Unix socket + TCP
+    int32_t  world_clients;       // subscribed to world replication
+    int32_t  snapshots_pending;   // ... still missing chunks of their interest (snapshot, moved view)
+    uint32_t bytes_tick;          // queued for sending during the last tick
+    uint64_t bytes_total;
+    uint32_t chunks_tick;         // chunk frames queued during the last tick
+    uint32_t deltas_tick;         // block writes in the last tick
+    uint32_t unloads_tick;        // chunks dropped from clients' interest during the last tick
+    float    net_ms;              // socket I/O + applying commands + replication, last tick
+} EngineNetStats;
+bool engine_get_net_stats(Engine* e, EngineNetStats* out);   // false when no server is running
+
+// Join a dedicated server (mini3d_server) as a player: its world is replicated
+// into this engine (view_radius chunks around the player, 0 = all of it) and the
+// camera becomes a networked player. The server owns the position; this engine
+// predicts it from each tick's input so controls answer in the same frame, and
+// replays the inputs the server has not acknowledged when it disagrees. POSIX only.
+bool engine_connect(Engine* e, const char* host, int port, int view_radius);
+void engine_disconnect(Engine* e);                       // also done by engine_destroy
+void engine_set_net_latency(Engine* e, float rtt_ms);    // simulated, in-process: try 100 ms on loopback
+
+typedef struct {
+    bool     connected;
+    int32_t  entities;            // other players in range
+    uint32_t inputs_sent;
+    uint32_t inputs_pending;      // sent, not acknowledged yet (predicted ahead of the server)
+    uint32_t corrections;         // acks that disagreed with the prediction (state reset + replay)
+    float    last_error;          // distance between predicted and server position, last correction
+    float    rtt_ms;              // input sent -> its ack applied, last ack
+} EnginePredictionStats;
+bool engine_get_prediction_stats(Engine* e, EnginePredictionStats* out);   // false when not connected
+
+// Record a session to `path`: the world as it is now, then every tick's dt and
+// input (keys, look, renderer) with the camera position physics produced, and
+// every world edit between ticks from any source. engine_start_replay plays one
+// back through engine_tick in place of keyboard and mouse (the dt argument is
+// ignored; ticks are not paced) until the log ends and engine_tick returns
+// false, so the same session can be timed on different builds. A replayed tick
+// whose position differs from the log counts as a divergence and is snapped back.
+// A recording that runs out of memory stops itself, with the log ending on the last
+// whole record (engine_get_recording_stats then returns false). Layout at the top
+// of replay.c.
+bool engine_start_recording(Engine* e, const char* path);
+void engine_stop_recording(Engine* e);                  // flushes + closes; also done by engine_destroy
+bool engine_start_replay(Engine* e, const char* path);  // false: unreadable, or recording/replaying/connected
+void engine_stop_replay(Engine* e);                     // back to live input; also done by engine_destroy
+
+typedef struct {
+    bool     recording, replaying;
+    uint32_t ticks;               // recorded / replayed so far
+    uint32_t ticks_total;         // replay: ticks in the log
+    uint32_t edits;               // world edit records written / applied
+    uint64_t bytes;               // log size so far / in total
+    uint32_t divergences;         // replay: ticks that ended somewhere other than the log says
+    float    max_error;           // ... largest such distance
+} EngineRecordingStats;
+bool engine_get_recording_stats(Engine* e, EngineRecordingStats* out);   // false when neither is running
+
+// Shared-memory transport: create POSIX shm segment `name` (e.g. "/mini3d") with a
+// command ring (set/fill/column/clear records, drained at the start of engine_tick
+// within the edit budget), an event ring (everything engine_poll_events sees) and
+// a read-only copy of the world of up to max_world_voxels, kept current from the
+// change feed (turned on here) under a seqlock. Layout at the top of shm.c;
+// shm_client.py is a Python controller. On Linux the engine futex-wakes the event
+// head and command tail words. POSIX only; false on Windows, if already started or
+// if name is 64 bytes or longer.
+bool engine_start_shm(Engine* e, const char* name, int max_world_voxels);
+void engine_stop_shm(Engine* e);   // unmaps + unlinks; also done by engine_destroy
+
+// Simulation thread: tick the world (edits from every source, physics, servers,
+// replication, recording) on its own thread at a fixed hz, and leave engine_tick
+// on the calling thread to sample keyboard/mouse and draw the latest finished
+// tick, so a slow frame no longer slows the simulation and a slow tick no longer
+// drops frames. engine_tick's dt is then ignored. While it runs, every other
+// engine call but engine_queue_edits and the lock-free readers must sit between
+// engine_lock and engine_unlock (engine_run does this for its callback); never
+// call engine_tick or engine_stop_sim_thread while holding the lock. The meshed
+// renderer reads the world lock-free and never waits for a tick. POSIX only;
+// false on Windows, if hz <= 0 or if already running.
+bool engine_start_sim_thread(Engine* e, int hz);
+void engine_stop_sim_thread(Engine* e);   // joins; also done by engine_destroy
+void engine_lock(Engine* e);              // no-ops without a sim thread
+void engine_unlock(Engine* e);
+
+typedef struct {
+    int      hz;
+    uint64_t ticks;               // simulated so far
+    uint64_t late_ticks;          // started more than one period behind schedule
+    float    tick_ms;             // last tick, whole
+    float    tick_ms_max;         // slowest since the previous call
+    uint64_t frames;              // engine_tick calls since the start
+    uint64_t stale_frames;        // ... that redrew the last chunk list while a tick replaced the world
+} EngineSimStats;
+bool engine_get_sim_stats(Engine* e, EngineSimStats* out);   // false when not running
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,477 @@
+// engine_internal.h — private types shared by the engine translation units.
+// Not part of the public API: Python/ctypes only ever sees engine.h.
+#pragma once
+
+#include "engine.h"
+#include "raylib.h"
+#include "raymath.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Chunks are fixed-size cubes laid over the dense world array. They are the
+// unit of meshing, culling and dirty tracking; storage stays dense.
+#define CHUNK_SIZE 16
+#define LOD_LEVELS 4          // 1x, 2x, 4x, 8x voxel merging
+#define CHUNK_INSTANCES_BIT (1u<<LOD_LEVELS) // built/stale bit of the instance buffer
+#define CHUNK_OCCLUDER_BIT  (1u<<(LOD_LEVELS+1)) // stale bit of occ_h
+#define CHUNK_VISGRAPH_BIT  (1u<<(LOD_LEVELS+2)) // stale bit of conn[]
+
+// Input applied once per tick by input_apply; physics only reads this.
+enum { INPUT_W = 1<<0, INPUT_A = 1<<1, INPUT_S = 1<<2, INPUT_D = 1<<3, INPUT_SPRINT = 1<<4, INPUT_JUMP = 1<<5 };
+typedef struct {
+    uint8_t keys;         // INPUT_* (INPUT_JUMP = pressed this tick, others = held)
+} InputFrame;
+
+// Keyboard/mouse read on the window thread (input_sample), applied to the
+// simulation by input_apply: in the same tick, or merged until the simulation
+// thread's next one.
+#define INPUT_EVENTS_MAX 32
+typedef struct {
+    uint8_t keys;         // INPUT_* held now (INPUT_JUMP: pressed since the last tick)
+    int     mode_steps;   // F2 presses: renderer cycles
+    float   dyaw, dpitch; // mouse look
+    int     nevents;
+    EngineEvent events[INPUT_EVENTS_MAX];   // key/mouse transitions for events_push
+} InputSample;
+
+static inline float look_pitch(float pitch) {   // mouse look stops short of straight up/down
+    const float limit = PI/2.2f;
+    return pitch > limit ? limit : pitch < -limit ? -limit : pitch;
+}
+
+// Everything a frame draws that the simulation owns, copied after a tick
+// (view_capture), so drawing never reads simulation state directly.
+#define VIEW_PLAYERS 256
+typedef struct {
+    uint32_t id;
+    float    pos[3];      // eye position
+} ViewPlayer;
+typedef struct {
+    Camera3D cam;
+    float    yaw, pitch;
+    int      mode;        // ENGINE_RENDER_*
+    int      nplayers;
+    ViewPlayer players[VIEW_PLAYERS];   // other players, from netclient.c
+} RenderView;
+
+// What movement integrates: the camera (eye) position and vertical speed. The
+// local camera, the server's authoritative copy of each networked player and the
+// client's prediction all advance it with the same player_step.
+typedef struct {
+    Vector3 pos;
+    float   vel_y;
+} PlayerState;
+
+#define OCC_W 256             // occlusion depth buffer size
+#define OCC_H 128
+#define STATS_RING 1024       // frames of history kept for engine_get_stats_history
+#define EDIT_RING 65536       // SPSC block edit ring slots (power of two)
+#define EVENT_RING 1024       // outbound events kept for engine_poll_events
+#define CHANGE_RING 65536     // change feed records kept for engine_read_changes
+
+// Chunk faces, in the order the meshing tables use; the opposite face is f^1.
+enum { FACE_PX, FACE_NX, FACE_PY, FACE_NY, FACE_PZ, FACE_NZ };
+
+// A run of instance transforms sharing one tile (one instanced draw per tile).
+typedef struct {
+    uint16_t tile;
+    int start, count;
+} InstRun;
+
+typedef struct {
+    Mesh    mesh[LOD_LEVELS]; // CPU+GPU mesh per LOD level (vertexCount==0 => nothing to draw)
+    uint8_t built;            // bit i: mesh[i] has been built (and uploaded if non-empty)
+    _Atomic uint8_t stale;    // bit i: voxels changed since mesh[i] was built (set by writers, cleared by readers before they read)
+    _Atomic uint32_t seq;     // seqlock over the chunk's voxels: odd while a writer is inside
+    struct ChunkSnap* snap;   // current version, while snapshots may hold it (snapshot.c)
+    uint8_t pending;          // marked dirty inside an edit batch, stale set at the commit (writer side)
+
+    // instanced renderer: transforms of exposed blocks, grouped into per-tile runs
+    float16* inst_xf;
+    InstRun* inst_runs;
+    int      inst_count, inst_nruns;
+
+    // occlusion: the bottom occ_h voxel layers of the chunk are completely solid
+    uint8_t  occ_h;
+
+    // cave culling: conn[a] bit b set when faces a and b (FACE_* order) see each
+    // other through connected air inside the chunk
+    uint8_t  conn[6];
+} Chunk;
+
+typedef struct {
+    int sx, sy, sz;       // world dims
+    uint16_t* v;          // [sx*sy*sz] block ids
+
+    int ncx, ncy, ncz;    // chunk grid dims (ceil(s/CHUNK_SIZE))
+    Chunk* chunks;        // [ncx*ncy*ncz]
+    int snapped;          // chunks with a snap (writer side)
+
+    // lock-free readers inside (world_read_enter), and engine_create_world swapping the arrays
+    atomic_int  readers;
+    atomic_bool replacing;
+} World;
+
+typedef struct {
+    Texture2D* tiles;     // per-tile textures (sliced from atlas)
+    int tile_count;
+    int tile_px, cols, rows;
+    Texture2D atlas_tex;  // optional: whole atlas
+    Image     atlas_img;  // kept until slicing done
+    bool      atlas_loaded;
+} Atlas;
+
+typedef struct {
+    uint16_t tile_of_block[256]; // block_id -> tile_index (0..tile_count-1), 0xFFFF=undefined
+} BlockDefs;
+
+// SPSC ring behind engine_queue_edits; head and tail sit on separate cache lines.
+typedef struct {
+    EngineEdit* buf;              // [EDIT_RING]
+    _Atomic uint32_t head;        // next slot to write (producer thread only)
+    char pad0[60];
+    _Atomic uint32_t tail;        // next slot to apply (engine thread only)
+    char pad1[60];
+} EditRing;
+
+// One entry of the per-frame visible chunk list (sorted near -> far).
+typedef struct {
+    int   ci;             // chunk index
+    int   lod;            // wanted LOD level
+    float dist;           // camera distance to chunk AABB
+} VisChunk;
+
+// A chunk mesh picked by chunks_prepare for chunks_submit (the Mesh by value, so
+// the list stays drawable while the chunk table changes under it).
+typedef struct {
+    Mesh    mesh;
+    Vector3 origin;
+} ChunkDraw;
+
+struct Engine {
+    // window/render
+    int screen_w, screen_h;
+    bool headless;        // engine_create_headless: no window, no input, no drawing
+    int  tick_hz;         // target ticks per second (headless ticks pace themselves; 0 = uncapped)
+    Camera3D cam;
+    float yaw, pitch;
+    bool  cursor_locked;
+    RenderView view;      // what the frame being drawn shows (render code reads this, not cam)
+    uint64_t ticks;       // simulation ticks so far (the tick number of edits, events, deltas)
+
+    // assets/world
+    Atlas atlas;
+    BlockDefs defs;
+    World world;
+
+    // Inverted (Minecraft) mouse
+    bool invert_mouse_x;
+    bool invert_mouse_y;
+
+    // movement
+    float move_speed, sprint_mult, eye_height;
+    float velY, gravity, jump_speed;
+    InputFrame in;
+
+    // chunk meshing / LOD
+    float lod_dist[LOD_LEVELS-1]; // distance at which LOD 1..3 kicks in
+    float view_dist;              // chunks beyond this are not drawn
+    int   mesh_budget;            // chunk meshes (re)built per frame
+    Material mesh_mat;
+    bool  mesh_mat_loaded;
+    VisChunk* vis;                // [chunk count] scratch for chunks_prepare
+    ChunkDraw* draws;             // meshes chunks_submit draws, kept between frames
+    int   ndraws, draws_cap;
+    int   chunks_drawn, tris_drawn;
+
+    // renderer selection + instanced path (instanced.c)
+    int   render_mode;            // ENGINE_RENDER_*
+    bool  inst_loaded;
+    Shader inst_shader;
+    Mesh  inst_cube;
+    float16* inst_stage;          // concatenation of visible runs, by tile, uploaded to inst_vbo
+    int   inst_stage_cap;
+    int*  inst_tile_count;        // [atlas tile_count] end of each tile's slot in inst_vbo
+    unsigned int inst_vbo;        // instance transforms, kept until the visible runs change
+    int   inst_vbo_cap;
+    int*  inst_vis;               // chunks uploaded to inst_vbo, in visible order
+    int   inst_nvis, inst_vis_cap;
+    int   inst_total, inst_chunks; // instances and chunks in inst_vbo
+    bool  inst_dirty;             // inst_vbo no longer matches the world
+
+    // software occlusion culling (occlusion.c)
+    bool  occlusion;
+    float* occ_depth;             // [OCC_W*OCC_H] 1/w of the nearest occluder, 0 = empty
+    float* occ_corner;            // [(OCC_W+1)*(OCC_H+1)] pixel corner scratch per occluder
+    int   chunks_occluded;
+
+    // cave culling (visgraph.c)
+    bool  cave_culling;
+    uint32_t* vg_stamp;           // [chunk count] BFS visit stamp
+    uint8_t* vg_from;             // [chunk count] face the BFS entered through (6 = start)
+    uint8_t* vg_dirs;             // [chunk count] directions travelled so far
+    uint32_t vg_frame;
+
+    // profiling (stats.c): cur accumulates during the tick, then lands in the ring
+    EngineFrameStats cur;
+    EngineFrameStats* stats_ring; // [STATS_RING]
+    uint64_t stats_frames;        // frames recorded so far
+
+    // line-delimited JSON command server (cmdserver.c)
+    struct CmdServer* cmd;        // NULL when not started
+    float cmd_budget_ms;          // time spent applying queued commands per tick
+
+    // block edits pushed from a controller thread (editring.c)
+    EditRing edits;
+    int   edit_budget;            // edits applied per tick
+
+    // edit batches (engine_begin_edit): dirty marks held back until the outermost commit
+    int   edit_depth;
+    int*  edit_chunks;            // chunks with pending marks
+    int   nedit_chunks, edit_chunks_cap;
+    bool  edit_all;               // ... or every chunk
+
+    // outbound events (events.c)
+    EngineEvent ev_ring[EVENT_RING];
+    uint32_t ev_head, ev_count, ev_dropped;
+    int   keys_held[16];          // keys seen going down, watched for release
+    int   nheld;
+    float ev_last_pose[5];        // pose of the last player event
+
+    // block change feed (changes.c), NULL when disabled
+    EngineChange* changes;        // [CHANGE_RING]
+    uint64_t change_seq;          // records written so far
+    uint64_t change_base;         // seq of the first record in the current ring (set when enabled)
+
+    // shared-memory transport (shm.c), NULL when not started
+    struct ShmTransport* shm;
+
+    // multi-client socket server (sockserver.c), NULL when not started
+    struct SockServer* sock;
+
+    // connection to a dedicated server (netclient.c), NULL when not connected
+    struct NetClient* net;
+
+    // CPU rasterizer (softrast.c), NULL until ENGINE_RENDER_SOFTWARE first draws
+    struct SoftRaster* soft;
+
+    // session recording / replay (replay.c), NULL when off
+    struct Recorder* rec;
+    struct Replayer* replay;
+
+    // simulation thread (simthread.c), NULL when engine_tick does everything
+    struct SimThread* sim;
+};
+
+static inline int idx3D(const World* w, int x,int y,int z) {
+    return x + y*w->sx + z*w->sx*w->sy;
+}
+
+static inline int chunkIndex(const World* w, int cx,int cy,int cz) {
+    return cx + cy*w->ncx + cz*w->ncx*w->ncy;
+}
+
+// Chunks overlapping an inclusive voxel box, clipped to the grid.
+static inline void chunk_range(const World* w, int x0,int y0,int z0, int x1,int y1,int z1, int lo[3], int hi[3]) {
+    lo[0] = x0<0?0:x0/CHUNK_SIZE; hi[0] = x1/CHUNK_SIZE; if (hi[0]>=w->ncx) hi[0] = w->ncx-1;
+    lo[1] = y0<0?0:y0/CHUNK_SIZE; hi[1] = y1/CHUNK_SIZE; if (hi[1]>=w->ncy) hi[1] = w->ncy-1;
+    lo[2] = z0<0?0:z0/CHUNK_SIZE; hi[2] = z1/CHUNK_SIZE; if (hi[2]>=w->ncz) hi[2] = w->ncz-1;
+}
+
+// Lock-free voxel reads (engine_get_block, engine_read_region, engine_raycast, the
+// meshed renderer). Writers bracket every voxel change with chunks_write_begin/end,
+// which keep the seq of each chunk they touch odd meanwhile; a reader copies
+// between chunk_read_begin and chunk_read_retry and copies again when a writer got
+// in. engine_create_world frees the arrays themselves, so readers first enter the
+// world: it waits for those inside to leave, and one arriving mid-swap finds no world.
+static inline bool world_read_enter(World* w) {
+    if (atomic_load(&w->replacing)) return false;   // first, so turned-away readers cannot starve it
+    atomic_fetch_add(&w->readers, 1);
+    if (!atomic_load(&w->replacing)) return true;
+    atomic_fetch_sub(&w->readers, 1);
+    return false;
+}
+
+static inline void world_read_leave(World* w) {
+    atomic_fetch_sub(&w->readers, 1);
+}
+
+static inline uint32_t chunk_read_begin(const Chunk* c) {
+    return atomic_load_explicit(&c->seq, memory_order_acquire);
+}
+
+static inline bool chunk_read_retry(const Chunk* c, uint32_t seq) {   // true: the copy may be torn
+    atomic_thread_fence(memory_order_acquire);
+    return (seq & 1) || atomic_load_explicit(&c->seq, memory_order_relaxed) != seq;
+}
+
+// color helper for non-textured fallback
+static inline Color tileColorForIndex(int tile) {
+    switch (tile % 8) {
+        case 0: return (Color){  80, 170,  80, 255 }; // grass green
+        case 1: return (Color){ 255, 180,  60, 255 }; // flowers-ish / warm
+        case 2: return (Color){ 139, 105,  80, 255 }; // dirt brown
+        case 3: return (Color){ 230, 220, 170, 255 }; // sand beige
+        case 4: return (Color){ 150, 150, 150, 255 }; // stone gray
+        case 5: return (Color){  70, 130, 200, 255 }; // water blue
+        case 6: return (Color){ 150, 110,  70, 255 }; // wood brown
+        case 7: return (Color){ 245, 250, 255, 255 }; // snow
+        default: return (Color){255,  64, 255, 255};   // magenta = debug
+    }
+}
+
+// engine.c — one movement step: WASD relative to yaw on the ground plane, sprint,
+// gravity, jump, floor at y=0. Deterministic in its inputs and the engine's
+// movement settings, so a server and its clients agree bit for bit.
+void player_step(const Engine* e, PlayerState* p, uint8_t keys, float yaw, float pitch, float dt);
+#define PLAYER_DT_MAX 0.1f
+// The dt a networked input is stepped with, on the server and in the client's prediction.
+static inline float player_input_dt(float dt) { return dt > PLAYER_DT_MAX ? PLAYER_DT_MAX : dt > 0 ? dt : 0; }
+
+// engine.c — the tick split in two: simulation (input applied, edits, physics,
+// publishing) and the copy of its state a frame draws
+void input_sample(Engine* e, InputSample* s);         // window thread
+void input_apply(Engine* e, const InputSample* s);
+bool simulate_tick(Engine* e, float dt, const InputSample* in, float* physics_ms);   // false: replay ended
+void view_capture(Engine* e, RenderView* v);
+
+// engine.c — expand a raw8 (one byte per voxel) or rle8 ((count,id) pairs) payload
+// covering a dx*dy*dz box (x fastest, then y, then z) straight into the world,
+// clipped to it. False when the payload does not match the box.
+bool world_decode_box(Engine* e, int x0,int y0,int z0, int dx,int dy,int dz,
+                      const uint8_t* data, int len, bool rle);
+
+// mesh.c — chunk grid, LOD meshing and chunk drawing
+bool chunks_alloc(Engine* e);
+void chunks_free(Engine* e);
+void chunks_mark_dirty(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1); // inclusive voxel box
+void chunks_mark_all_dirty(Engine* e);
+void chunks_flush_dirty(Engine* e);   // marks held back by an edit batch, once per chunk
+void chunks_write_begin(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1); // inclusive voxel box, before writing it
+void chunks_write_end(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1);   // ... after
+Matrix camera_view_proj(const Engine* e);
+void frustum_planes(const Engine* e, Vector4 out[6]);
+bool chunk_view_test(const Engine* e, const Vector4 planes[6], int cx,int cy,int cz, VisChunk* out);
+int  collect_visible_chunks(Engine* e); // frustum + view distance (+ occlusion), fills e->vis near -> far
+// Mesh for a visible chunk: its wanted LOD is (re)built first while *budget lasts,
+// else the nearest LOD already built is used. NULL when there is nothing to draw.
+const Mesh* chunk_draw_mesh(Engine* e, const VisChunk* vc, int* budget);
+bool chunks_prepare(Engine* e);   // cull + mesh into e->draws, lock-free; false: world being replaced, list kept
+void chunks_submit(Engine* e);    // draw e->draws (does not), inside BeginMode3D
+
+// snapshot.c — chunk versions shared with engine_snapshot_world snapshots
+typedef struct ChunkSnap ChunkSnap;
+void snapshot_detach(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1); // inclusive voxel box, before writing it
+void snapshot_detach_all(Engine* e);   // before the world is freed
+void snapshot_retire(Engine* e);       // before the engine is freed: detach all, wait out snapshot reads
+
+// instanced.c — one instanced draw per tile over all visible chunks
+void draw_chunks_instanced(Engine* e);
+void instanced_unload(Engine* e);
+
+// occlusion.c — coarse CPU depth buffer, chunk AABB tests
+int  occlusion_cull(Engine* e, int nvis); // compacts e->vis, returns new count
+
+// stats.c — timers + per-frame stats ring
+double stats_now(void);           // monotonic seconds
+void   stats_sleep_until(double t);   // stats_now() time
+void   stats_end_frame(Engine* e);
+
+// visgraph.c — per-chunk face connectivity + BFS from the camera chunk
+int  visgraph_collect(Engine* e, const Vector4 planes[6]); // fills e->vis unsorted, -1 = camera outside world or out of memory
+void visgraph_free(Engine* e);
+
+// cmdserver.c — wire protocol (JSON lines + binary frames), shared by the command
+// server (reader thread + queue) and the socket server
+enum { WIRE_OP_NONE, WIRE_OP_INIT, WIRE_OP_SET, WIRE_OP_FILL, WIRE_OP_COLUMN, WIRE_OP_CHUNK,
+       WIRE_OP_CAMERA_SET, WIRE_OP_CLEAR, WIRE_OP_FLUSH, WIRE_OP_SUBSCRIBE, WIRE_OP_VIEW,
+       WIRE_OP_INPUT };
+enum { WIRE_SUB_KEY = 1, WIRE_SUB_MOUSE = 2, WIRE_SUB_PLAYER = 4, WIRE_SUB_CHANGE = 8, WIRE_SUB_WORLD = 16 };
+enum { WIRE_NEED_MORE, WIRE_CMD, WIRE_SKIP, WIRE_CORRUPT };   // wire_next results
+#define WIRE_PALETTE_MAX 256
+
+typedef struct {
+    uint8_t  op;         // WIRE_OP_*
+    uint16_t id;
+    int      a[6];       // set: x,y,z | fill: min,max | column: x,z,h | chunk: origin,dims | init: size | subscribe: mask | view: radius | input: seq, keys
+    float    f[5];       // camera_set: pos, yaw, pitch | view: pos | input: yaw, pitch, dt
+    uint8_t* data;       // chunk: still-encoded payload (owned)
+    int      data_len;
+    bool     rle;        // chunk: rle8 (count,id pairs) rather than raw8
+} WireCmd;
+
+typedef struct {         // per-connection parser state
+    struct { char name[32]; uint16_t id; } palette[WIRE_PALETTE_MAX];
+    int npalette;
+    size_t scanned;      // bytes of the pending JSON line already searched for '\n'
+    const char* err;     // why the last message was rejected, NULL if it was not
+} WireParser;
+
+// Next message in m[0..avail): WIRE_CMD fills *c, WIRE_SKIP is a blank or rejected
+// message (p->err says why), both set *used; WIRE_CORRUPT means the stream cannot
+// be resynchronized. After WIRE_NEED_MORE call again with m at the same message.
+int         wire_next(WireParser* p, const uint8_t* m, size_t avail, size_t* used, WireCmd* c);
+const char* wire_apply(Engine* e, WireCmd* c);   // reply line for the sender or NULL; frees c->data
+uint32_t    wire_event_json(const EngineEvent* ev, char* buf, int cap);   // WIRE_SUB_* class, 0 = not sent
+int         wire_change_json(const EngineChange* c, char* buf, int cap);
+
+typedef struct CmdServer CmdServer;
+void cmdserver_apply(Engine* e);                          // drain the queue, start of engine_tick
+void cmdserver_event(Engine* e, const EngineEvent* ev);   // forward as a JSON line
+
+// editring.c — SPSC block edit ring, drained at the start of engine_tick
+bool edits_alloc(Engine* e);
+void edits_free(Engine* e);
+void edits_apply(Engine* e);
+
+// softrast.c — ENGINE_RENDER_SOFTWARE: chunk meshes rasterized on the CPU
+typedef struct SoftRaster SoftRaster;
+void softrast_draw(Engine* e);   // cull, mesh, rasterize; windowed also shows the frame
+void softrast_free(Engine* e);
+
+// events.c — outbound event ring
+void events_push(Engine* e, EngineEvent ev);
+int  events_sample_input(Engine* e, EngineEvent* out, int max);  // key/mouse transitions, from input_sample
+void events_player(Engine* e);        // player pose if it changed, after physics
+
+// changes.c — change feed; every world mutation path reports here
+void changes_block(Engine* e, int x,int y,int z, uint16_t old_id, uint16_t new_id);
+void changes_box(Engine* e, int kind, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t new_id);
+
+// shm.c — shared-memory command/event rings + world view for out-of-process controllers
+typedef struct ShmTransport ShmTransport;
+void shm_apply(Engine* e);                            // drain the command ring, start of engine_tick
+void shm_event(Engine* e, const EngineEvent* ev);     // copy into the shared event ring
+void shm_publish(Engine* e);                          // sync the world view + wake waiters, after physics
+
+// sockserver.c — Unix-domain/TCP socket clients, serviced from engine_tick without threads
+typedef struct SockServer SockServer;
+void sockserver_poll(Engine* e, float dt);                 // accept, read, apply in client order; start of engine_tick
+void sockserver_event(Engine* e, const EngineEvent* ev);   // fan out to subscribers
+void sockserver_publish(Engine* e);                        // change records, world replication, flush; after physics
+
+// netclient.c — this engine as a player on a dedicated server: replicated world in,
+// predicted input out
+typedef struct NetClient NetClient;
+void netclient_poll(Engine* e);                  // world frames + acks (reconcile); start of engine_tick
+void netclient_send_input(Engine* e, float dt);  // this tick's input + predicted state; after physics
+int  netclient_players(Engine* e, ViewPlayer* out, int max);   // other players, for view_capture
+
+// replay.c — session log out (every tick's input + every world edit) and back in
+typedef struct Recorder Recorder;
+typedef struct Replayer Replayer;
+void replay_record_change(Engine* e, int kind, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t id); // from changes.c
+void replay_record_camera(Engine* e);           // from engine_set_camera_pose
+bool replay_begin_tick(Engine* e, float* dt);   // apply edits up to the next tick, load its input; false at the end
+void replay_end_tick(Engine* e, float dt);      // after physics: log the tick, or check it against the log
+
+// simthread.c — engine_start_sim_thread: the simulation ticks on its own thread at a
+// fixed rate under the world lock and publishes a RenderView per tick through a
+// triple buffer; engine_tick on the window thread only samples input and draws.
+typedef struct SimThread SimThread;
+bool simthread_begin_frame(Engine* e, float* tick_ms);   // input out, latest view in; false: replay ended
+void simthread_lock(Engine* e);                          // world lock (nothing without a sim thread)
+void simthread_unlock(Engine* e);
+void simthread_stale_frame(Engine* e);                   // counts a frame that redrew the last chunk list
+bool simthread_defer_unload(Engine* e, const Mesh* m);   // GPU mesh freed later by the window thread
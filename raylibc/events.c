@@ -0,0 +1,75 @@
+// events.c — outbound event ring: input and player events for the controller.
+//
+// input_sample collects key/mouse transitions and input_apply pushes them, each
+// tick adds a player event whenever the pose changed, and engine_poll_events
+// hands them over in bulk.
+// When the controller falls behind the oldest events are overwritten. With a
+// command server running every event is also written out as a JSON line.
+#include "engine_internal.h"
+#include <math.h>
+
+static const int kMouseButtons[] = { MOUSE_BUTTON_LEFT, MOUSE_BUTTON_RIGHT, MOUSE_BUTTON_MIDDLE };
+
+void events_push(Engine* e, EngineEvent ev) {
+    ev.frame = (uint32_t)e->ticks;
+    if (e->ev_count == EVENT_RING) {             // full: drop the oldest
+        e->ev_head = (e->ev_head + 1) % EVENT_RING;
+        e->ev_count--;
+        e->ev_dropped++;
+    }
+    e->ev_ring[(e->ev_head + e->ev_count) % EVENT_RING] = ev;
+    e->ev_count++;
+    if (e->cmd) cmdserver_event(e, &ev);
+    if (e->shm) shm_event(e, &ev);
+    if (e->sock) sockserver_event(e, &ev);
+}
+
+int events_sample_input(Engine* e, EngineEvent* out, int max) {
+    int n = 0;
+    // key presses arrive through raylib's per-frame queue; releases are checked
+    // only for the keys we saw go down
+    for (int key = GetKeyPressed(); key; key = GetKeyPressed()) {
+        if (n < max) out[n++] = (EngineEvent){ .type = ENGINE_EVENT_KEY_DOWN, .code = key };
+        if (e->nheld < (int)(sizeof(e->keys_held)/sizeof(e->keys_held[0]))) e->keys_held[e->nheld++] = key;
+    }
+    for (int i=0; i<e->nheld; ) {
+        if (IsKeyReleased(e->keys_held[i]) || !IsKeyDown(e->keys_held[i])) {
+            if (n < max) out[n++] = (EngineEvent){ .type = ENGINE_EVENT_KEY_UP, .code = e->keys_held[i] };
+            e->keys_held[i] = e->keys_held[--e->nheld];
+        } else i++;
+    }
+
+    for (int i=0;i<3;i++) {
+        int b = kMouseButtons[i];
+        bool down = IsMouseButtonPressed(b), up = IsMouseButtonReleased(b);
+        if (!down && !up) continue;
+        Vector2 m = GetMousePosition();
+        if (n < max) out[n++] = (EngineEvent){ .type = down ? ENGINE_EVENT_MOUSE_DOWN : ENGINE_EVENT_MOUSE_UP,
+                                               .code = b, .x = m.x, .y = m.y };
+    }
+    return n;
+}
+
+void events_player(Engine* e) {
+    const float* p = e->ev_last_pose;
+    Vector3 c = e->cam.position;
+    if (fabsf(c.x-p[0]) < 1e-4f && fabsf(c.y-p[1]) < 1e-4f && fabsf(c.z-p[2]) < 1e-4f &&
+        fabsf(e->yaw-p[3]) < 1e-4f && fabsf(e->pitch-p[4]) < 1e-4f) return;
+    e->ev_last_pose[0] = c.x; e->ev_last_pose[1] = c.y; e->ev_last_pose[2] = c.z;
+    e->ev_last_pose[3] = e->yaw; e->ev_last_pose[4] = e->pitch;
+    events_push(e, (EngineEvent){ .type = ENGINE_EVENT_PLAYER, .x = c.x, .y = c.y, .z = c.z,
+                                  .yaw = e->yaw, .pitch = e->pitch });
+}
+
+int engine_poll_events(Engine* e, EngineEvent* buf, int max) {
+    if (!e || !buf || max <= 0) return 0;
+    int n = (int)e->ev_count < max ? (int)e->ev_count : max;
+    for (int i=0;i<n;i++) buf[i] = e->ev_ring[(e->ev_head + i) % EVENT_RING];
+    e->ev_head = (e->ev_head + n) % EVENT_RING;
+    e->ev_count -= n;
+    return n;
+}
+
+uint32_t engine_events_dropped(Engine* e) {
+    return e ? e->ev_dropped : 0;
+}
@@ -0,0 +1,258 @@
+// instanced.c — ENGINE_RENDER_INSTANCED: unit cubes drawn instanced, one draw per tile.
+//
+// Each chunk keeps a persistent array of transforms for its exposed blocks (at
+// least one air neighbour), sorted into per-tile runs. Transforms are stored as
+// MatrixToFloatV gives them, column by column as a mat4 attribute reads them;
+// a raylib Matrix is laid out row by row. The array is rebuilt only when the
+// chunk is dirty. The runs of all visible chunks are gathered by tile into one
+// persistent instance buffer, re-uploaded only when the visible chunks or their
+// runs change; each tile is drawn from its slot in that buffer.
+#include "engine_internal.h"
+#include "rlgl.h"
+
+static const char* kInstVS =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec3 vertexNormal;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    // same directional shading as the chunk meshes\n"
+    "    vec3 n = abs(vertexNormal);\n"
+    "    float shade = n.y > 0.5 ? (vertexNormal.y > 0.0 ? 1.0 : 0.55) : (n.x > 0.5 ? 0.78 : 0.88);\n"
+    "    fragColor = vec4(colDiffuse.rgb*shade, colDiffuse.a);\n"
+    "    gl_Position = mvp*instanceTransform*vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char* kInstFS =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main() { finalColor = fragColor; }\n";
+
+static void instanced_load(Engine* e) {
+    e->inst_shader = LoadShaderFromMemory(kInstVS, kInstFS);
+    e->inst_shader.locs[SHADER_LOC_MATRIX_MVP]    = GetShaderLocation(e->inst_shader, "mvp");
+    e->inst_shader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocation(e->inst_shader, "colDiffuse");
+    e->inst_shader.locs[SHADER_LOC_MATRIX_MODEL]  = GetShaderLocationAttrib(e->inst_shader, "instanceTransform");
+    e->inst_cube = GenMeshCube(1.0f, 1.0f, 1.0f);  // centred, like DrawCube(pos, 1,1,1)
+    e->inst_loaded = true;
+    e->inst_dirty = true;
+}
+
+void instanced_unload(Engine* e) {
+    if (e->inst_loaded) {
+        if (e->inst_vbo) rlUnloadVertexBuffer(e->inst_vbo);
+        UnloadMesh(e->inst_cube);
+        UnloadShader(e->inst_shader);
+        e->inst_loaded = false;
+    }
+    e->inst_vbo = 0; e->inst_vbo_cap = 0;
+    free(e->inst_stage);      e->inst_stage = NULL; e->inst_stage_cap = 0;
+    free(e->inst_tile_count); e->inst_tile_count = NULL;
+    free(e->inst_vis);        e->inst_vis = NULL; e->inst_nvis = e->inst_vis_cap = 0;
+}
+
+static inline bool solid_at(const World* w, int x,int y,int z) {
+    if (x<0||y<0||z<0||x>=w->sx||y>=w->sy||z>=w->sz) return false;
+    return w->v[idx3D(w,x,y,z)] != 0;
+}
+
+// Rebuild the transform runs of chunk ci: exposed blocks only, grouped by tile.
+static void chunk_rebuild_instances(Engine* e, int ci) {
+    World* w = &e->world;
+    Chunk* c = &w->chunks[ci];
+    int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+    int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+    int x1 = x0+CHUNK_SIZE, y1 = y0+CHUNK_SIZE, z1 = z0+CHUNK_SIZE;
+    if (x1 > w->sx) x1 = w->sx;
+    if (y1 > w->sy) y1 = w->sy;
+    if (z1 > w->sz) z1 = w->sz;
+
+    // pass 1: tile of each exposed block (0xFFFF = skip) + count
+    static uint16_t tile_of[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    int count = 0;
+    for (int z=z0; z<z1; z++)
+    for (int y=y0; y<y1; y++)
+    for (int x=x0; x<x1; x++) {
+        int li = (x-x0) + (y-y0)*CHUNK_SIZE + (z-z0)*CHUNK_SIZE*CHUNK_SIZE;
+        uint16_t id = w->v[idx3D(w,x,y,z)];
+        uint16_t tile = (id && id < 256) ? e->defs.tile_of_block[id] : 0xFFFF;
+        if (tile != 0xFFFF && tile >= e->atlas.tile_count) tile = 0xFFFF;
+        if (tile != 0xFFFF &&
+            solid_at(w,x+1,y,z) && solid_at(w,x-1,y,z) && solid_at(w,x,y+1,z) &&
+            solid_at(w,x,y-1,z) && solid_at(w,x,y,z+1) && solid_at(w,x,y,z-1)) tile = 0xFFFF; // buried
+        tile_of[li] = tile;
+        if (tile != 0xFFFF) count++;
+    }
+
+    free(c->inst_xf);   c->inst_xf = NULL;
+    free(c->inst_runs); c->inst_runs = NULL;
+    c->inst_count = c->inst_nruns = 0;
+    c->built |= (uint8_t)CHUNK_INSTANCES_BIT;
+    if (count) {
+        c->inst_xf = (float16*)malloc(count*sizeof(float16));
+
+        // pass 2: counting sort by tile -> one contiguous run per tile
+        int ntiles = e->atlas.tile_count;
+        int* slot = (int*)calloc(ntiles+1, sizeof(int));
+        if (!c->inst_xf || !slot) {   // draw nothing for now, retry on a later frame
+            free(c->inst_xf); c->inst_xf = NULL;
+            free(slot);
+            c->stale |= (uint8_t)CHUNK_INSTANCES_BIT;
+            return;
+        }
+        for (int z=z0; z<z1; z++)
+        for (int y=y0; y<y1; y++)
+        for (int x=x0; x<x1; x++) {
+            uint16_t tile = tile_of[(x-x0) + (y-y0)*CHUNK_SIZE + (z-z0)*CHUNK_SIZE*CHUNK_SIZE];
+            if (tile != 0xFFFF) slot[tile+1]++;
+        }
+        for (int t=0;t<ntiles;t++) if (slot[t+1]) c->inst_nruns++;
+        c->inst_runs = (InstRun*)malloc(c->inst_nruns*sizeof(InstRun));
+        if (!c->inst_runs) {
+            free(c->inst_xf); c->inst_xf = NULL;
+            free(slot);
+            c->inst_nruns = 0;
+            c->stale |= (uint8_t)CHUNK_INSTANCES_BIT;
+            return;
+        }
+        for (int t=0, r=0; t<ntiles; t++) {
+            if (slot[t+1]) c->inst_runs[r++] = (InstRun){ (uint16_t)t, slot[t], slot[t+1] };
+            slot[t+1] += slot[t];
+        }
+        for (int z=z0; z<z1; z++)
+        for (int y=y0; y<y1; y++)
+        for (int x=x0; x<x1; x++) {
+            uint16_t tile = tile_of[(x-x0) + (y-y0)*CHUNK_SIZE + (z-z0)*CHUNK_SIZE*CHUNK_SIZE];
+            if (tile != 0xFFFF) c->inst_xf[slot[tile]++] = MatrixToFloatV(MatrixTranslate((float)x, (float)y, (float)z));
+        }
+        free(slot);
+        c->inst_count = count;
+    }
+    c->stale &= (uint8_t)~CHUNK_INSTANCES_BIT;
+}
+
+// Gather the runs of the visible chunks by tile into inst_vbo. False when out of memory.
+static bool upload_instances(Engine* e, int nvis) {
+    World* w = &e->world;
+    int ntiles = e->atlas.tile_count;
+    if (nvis > e->inst_vis_cap) {
+        int* vis = (int*)realloc(e->inst_vis, nvis*sizeof(int));
+        if (!vis) return false;
+        e->inst_vis = vis; e->inst_vis_cap = nvis;
+    }
+    int total = 0, chunks = 0;
+    memset(e->inst_tile_count, 0, ntiles*sizeof(int));
+    for (int i=0;i<nvis;i++) {
+        const Chunk* c = &w->chunks[e->vis[i].ci];
+        e->inst_vis[i] = e->vis[i].ci;
+        if (!(c->built & CHUNK_INSTANCES_BIT) || !c->inst_count) continue;
+        for (int r=0;r<c->inst_nruns;r++) e->inst_tile_count[c->inst_runs[r].tile] += c->inst_runs[r].count;
+        total += c->inst_count;
+        chunks++;
+    }
+    e->inst_nvis = nvis;
+    e->inst_total = total; e->inst_chunks = chunks;
+    if (!total) return true;
+
+    if (total > e->inst_stage_cap) {
+        free(e->inst_stage);
+        e->inst_stage_cap = total + total/2;
+        e->inst_stage = (float16*)malloc(e->inst_stage_cap*sizeof(float16));
+        if (!e->inst_stage) { e->inst_stage_cap = 0; return false; }
+    }
+
+    // tile counts -> offsets, then scatter every visible run into its tile slot
+    int off = 0;
+    for (int t=0;t<ntiles;t++) { int n = e->inst_tile_count[t]; e->inst_tile_count[t] = off; off += n; }
+    for (int i=0;i<nvis;i++) {
+        const Chunk* c = &w->chunks[e->vis[i].ci];
+        if (!(c->built & CHUNK_INSTANCES_BIT)) continue;
+        for (int r=0;r<c->inst_nruns;r++) {
+            const InstRun* run = &c->inst_runs[r];
+            memcpy(e->inst_stage + e->inst_tile_count[run->tile], c->inst_xf + run->start, run->count*sizeof(float16));
+            e->inst_tile_count[run->tile] += run->count;
+        }
+    }
+    // inst_tile_count[t] is now the end of tile t's slot
+
+    if (total > e->inst_vbo_cap) {
+        if (e->inst_vbo) rlUnloadVertexBuffer(e->inst_vbo);
+        e->inst_vbo_cap = e->inst_stage_cap;
+        e->inst_vbo = rlLoadVertexBuffer(NULL, e->inst_vbo_cap*(int)sizeof(float16), true);
+        if (!e->inst_vbo) { e->inst_vbo_cap = 0; return false; }
+    }
+    rlUpdateVertexBuffer(e->inst_vbo, e->inst_stage, total*(int)sizeof(float16), 0);
+    return true;
+}
+
+void draw_chunks_instanced(Engine* e) {
+    World* w = &e->world;
+    e->chunks_drawn = 0; e->tris_drawn = 0;
+    if (!w->chunks || e->atlas.tile_count <= 0) return;
+    if (!e->inst_loaded) instanced_load(e);
+    if (!e->inst_tile_count) {
+        e->inst_tile_count = (int*)malloc(e->atlas.tile_count*sizeof(int));
+        if (!e->inst_tile_count) return;
+        e->inst_dirty = true;
+    }
+
+    int nvis = collect_visible_chunks(e);
+
+    // refresh dirty instance runs nearest-first; any change, or a different
+    // visible set, means the instance buffer has to be gathered again
+    int budget = e->mesh_budget;
+    bool changed = e->inst_dirty || nvis != e->inst_nvis;
+    for (int i=0;i<nvis;i++) {
+        Chunk* c = &w->chunks[e->vis[i].ci];
+        bool have = (c->built & CHUNK_INSTANCES_BIT) != 0;
+        if (budget > 0 && (!have || (c->stale & CHUNK_INSTANCES_BIT))) {
+            double t0 = stats_now();
+            chunk_rebuild_instances(e, e->vis[i].ci);
+            e->cur.mesh_ms += (float)((stats_now()-t0)*1000.0);
+            e->cur.chunks_meshed++;
+            budget--;
+            changed = true;
+        }
+        if (!changed && e->inst_vis[i] != e->vis[i].ci) changed = true;
+    }
+    if (changed) {
+        e->inst_dirty = !upload_instances(e, nvis);
+        if (e->inst_dirty) return;
+    }
+    if (!e->inst_total) return;
+    e->chunks_drawn = e->inst_chunks;
+
+    // what DrawMeshInstanced does, minus creating and freeing a buffer per call
+    Shader sh = e->inst_shader;
+    int loc = sh.locs[SHADER_LOC_MATRIX_MODEL];
+    rlDrawRenderBatchActive();   // keep immediate-mode draws queued before ours in order
+    rlEnableShader(sh.id);
+    Matrix mvp = MatrixMultiply(MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview()), rlGetMatrixProjection());
+    rlSetUniformMatrix(sh.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlEnableVertexArray(e->inst_cube.vaoId);
+    rlEnableVertexBuffer(e->inst_vbo);
+    for (int k=0;k<4;k++) { rlEnableVertexAttribute(loc+k); rlSetVertexAttributeDivisor(loc+k, 1); }
+    int start = 0;
+    for (int t=0;t<e->atlas.tile_count;t++) {
+        int n = e->inst_tile_count[t] - start;
+        if (n > 0) {
+            Color col = tileColorForIndex(t);
+            float diffuse[4] = { col.r/255.0f, col.g/255.0f, col.b/255.0f, col.a/255.0f };
+            rlSetUniform(sh.locs[SHADER_LOC_COLOR_DIFFUSE], diffuse, RL_SHADER_UNIFORM_VEC4, 1);
+            for (int k=0;k<4;k++)   // point the per-instance matrix at this tile's slot
+                rlSetVertexAttribute(loc+k, 4, RL_FLOAT, false, sizeof(float16), start*(int)sizeof(float16) + k*4*(int)sizeof(float));
+            if (e->inst_cube.indices) rlDrawVertexArrayElementsInstanced(0, e->inst_cube.triangleCount*3, 0, n);
+            else rlDrawVertexArrayInstanced(0, e->inst_cube.vertexCount, n);
+            e->cur.draw_calls++;
+        }
+        start = e->inst_tile_count[t];
+    }
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+    rlDisableShader();
+    e->tris_drawn = e->inst_total * e->inst_cube.triangleCount;
+}
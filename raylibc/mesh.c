@@ -0,0 +1,446 @@
+// mesh.c — chunk grid, face-culled chunk meshes with distance-based LOD.
+//
+// Every chunk can carry one mesh per LOD level. Level L merges 2^L x 2^L x 2^L
+// voxels into one cell, so a 16^3 chunk becomes 8^3, 4^3 or 2^3 cells. Meshes
+// are built lazily for the level a chunk is drawn at, within a per-frame budget.
+#include "engine_internal.h"
+#include <math.h>
+
+// Face tables: normal direction + 4 corners of a unit cube, CCW seen from outside.
+static const int kFaceDir[6][3] = {
+    { 1,0,0}, {-1,0,0}, {0, 1,0}, {0,-1,0}, {0,0, 1}, {0,0,-1}
+};
+static const float kFaceCorner[6][4][3] = {
+    { {1,0,0},{1,1,0},{1,1,1},{1,0,1} }, // +X
+    { {0,0,1},{0,1,1},{0,1,0},{0,0,0} }, // -X
+    { {0,1,0},{0,1,1},{1,1,1},{1,1,0} }, // +Y
+    { {0,0,0},{1,0,0},{1,0,1},{0,0,1} }, // -Y
+    { {1,0,1},{1,1,1},{0,1,1},{0,0,1} }, // +Z
+    { {0,0,0},{0,1,0},{1,1,0},{1,0,0} }, // -Z
+};
+// cheap directional shading so faces read without lighting
+static const unsigned char kFaceShade[6] = { 200, 200, 255, 140, 225, 225 };
+
+bool chunks_alloc(Engine* e) {
+    World* w = &e->world;
+    w->ncx = (w->sx + CHUNK_SIZE-1) / CHUNK_SIZE;
+    w->ncy = (w->sy + CHUNK_SIZE-1) / CHUNK_SIZE;
+    w->ncz = (w->sz + CHUNK_SIZE-1) / CHUNK_SIZE;
+    int n = w->ncx*w->ncy*w->ncz;
+    w->chunks = (Chunk*)calloc(n, sizeof(Chunk));
+    e->vis = (VisChunk*)calloc(n, sizeof(VisChunk));
+    if (!w->chunks || !e->vis) return false;
+    chunks_mark_all_dirty(e);   // nothing derived (occluders, meshes) exists yet
+    return true;
+}
+
+static void chunk_unload_mesh(Engine* e, Chunk* c, int lod) {
+    Mesh* m = &c->mesh[lod];
+    if ((c->built & (1u<<lod)) && m->vertexCount > 0) {
+        if (m->vboId) { if (!simthread_defer_unload(e, m)) UnloadMesh(*m); }   // uploaded: GPU buffers + CPU arrays
+        else { RL_FREE(m->vertices); RL_FREE(m->colors); }     // headless: never left the CPU
+    }
+    memset(&c->mesh[lod], 0, sizeof(Mesh));
+    c->built &= (uint8_t)~(1u<<lod);
+}
+
+void chunks_free(Engine* e) {
+    World* w = &e->world;
+    if (w->chunks) {
+        int n = w->ncx*w->ncy*w->ncz;
+        for (int i=0;i<n;i++) {
+            for (int l=0;l<LOD_LEVELS;l++) chunk_unload_mesh(e, &w->chunks[i], l);
+            free(w->chunks[i].inst_xf);
+            free(w->chunks[i].inst_runs);
+        }
+    }
+    free(w->chunks); w->chunks = NULL;
+    free(e->vis);    e->vis = NULL;
+    e->nedit_chunks = 0;   // pending marks of these chunks
+    e->inst_dirty = true;  // instance runs of these chunks
+    visgraph_free(e);
+    w->ncx = w->ncy = w->ncz = 0;
+}
+
+// Inside an edit batch marks are only collected, and each chunk is marked once,
+// at the commit. A chunk that was clean when the batch began is not remeshed
+// before then; one already stale may still be remeshed mid-batch (the seqlock
+// keeps that mesh consistent), but the commit marks it again, so no chunk the
+// batch touched is left clean before the commit.
+static void chunk_mark(Engine* e, int ci) {
+    Chunk* c = &e->world.chunks[ci];
+    if (!e->edit_depth) { c->stale = 0xFF; return; }
+    if (c->pending) return;
+    if (e->nedit_chunks == e->edit_chunks_cap) {
+        int cap = e->edit_chunks_cap ? e->edit_chunks_cap*2 : 256;
+        int* l = (int*)realloc(e->edit_chunks, (size_t)cap*sizeof(int));
+        if (!l) { c->stale = 0xFF; return; }   // out of memory: mark it now
+        e->edit_chunks = l; e->edit_chunks_cap = cap;
+    }
+    c->pending = 1;
+    e->edit_chunks[e->nedit_chunks++] = ci;
+}
+
+void chunks_mark_dirty(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1) {
+    World* w = &e->world;
+    if (!w->chunks) return;
+    // grow by a coarsest LOD cell: border faces of neighbouring chunks depend on
+    // the cells these voxels fall in (border_mask)
+    const int g = 1<<(LOD_LEVELS-1);
+    int lo[3], hi[3];
+    chunk_range(w, x0-g,y0-g,z0-g, x1+g,y1+g,z1+g, lo, hi);
+    for (int cz=lo[2]; cz<=hi[2]; cz++)
+    for (int cy=lo[1]; cy<=hi[1]; cy++)
+    for (int cx=lo[0]; cx<=hi[0]; cx++) chunk_mark(e, chunkIndex(w,cx,cy,cz));
+}
+
+void chunks_mark_all_dirty(Engine* e) {
+    World* w = &e->world;
+    if (!w->chunks) return;
+    if (e->edit_depth) { e->edit_all = true; return; }
+    int n = w->ncx*w->ncy*w->ncz;
+    for (int i=0;i<n;i++) w->chunks[i].stale = 0xFF;
+}
+
+void chunks_flush_dirty(Engine* e) {
+    World* w = &e->world;
+    for (int i=0; i<e->nedit_chunks; i++) {
+        Chunk* c = &w->chunks[e->edit_chunks[i]];
+        c->pending = 0;
+        if (!e->edit_all) c->stale = 0xFF;
+    }
+    e->nedit_chunks = 0;
+    if (e->edit_all) { e->edit_all = false; chunks_mark_all_dirty(e); }
+}
+
+// Voxel writes are serialized (one simulation, or callers holding engine_lock), so
+// the seqs only need ordering against the readers, not atomic increments.
+static void chunks_seq_bump(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1, memory_order order) {
+    World* w = &e->world;
+    if (!w->chunks) return;
+    int lo[3], hi[3];
+    chunk_range(w, x0,y0,z0, x1,y1,z1, lo, hi);
+    for (int cz=lo[2]; cz<=hi[2]; cz++)
+    for (int cy=lo[1]; cy<=hi[1]; cy++)
+    for (int cx=lo[0]; cx<=hi[0]; cx++) {
+        _Atomic uint32_t* seq = &w->chunks[chunkIndex(w,cx,cy,cz)].seq;
+        atomic_store_explicit(seq, atomic_load_explicit(seq, memory_order_relaxed) + 1, order);
+    }
+}
+
+void chunks_write_begin(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1) {
+    snapshot_detach(e, x0,y0,z0, x1,y1,z1);                          // versions snapshots hold, copied out first
+    chunks_seq_bump(e, x0,y0,z0, x1,y1,z1, memory_order_relaxed);   // odd: writing
+    atomic_thread_fence(memory_order_release);                       // ... before any voxel changes
+}
+
+void chunks_write_end(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1) {
+    chunks_seq_bump(e, x0,y0,z0, x1,y1,z1, memory_order_release);   // even: stable
+}
+
+static inline uint16_t voxel_at(const World* w, int x,int y,int z) {
+    if (x<0||y<0||z<0||x>=w->sx||y>=w->sy||z>=w->sz) return 0;
+    return w->v[idx3D(w,x,y,z)];
+}
+
+// Downsample an f^3 cell at (ox,oy,oz): solid when at least half the voxels are,
+// with the most common non-air id. f==1 is a plain voxel read.
+static uint16_t sample_cell(const World* w, int ox,int oy,int oz, int f) {
+    if (f == 1) return voxel_at(w, ox,oy,oz);
+    uint16_t ids[8]; int counts[8]; int nids = 0, solid = 0;
+    for (int z=oz; z<oz+f; z++)
+    for (int y=oy; y<oy+f; y++)
+    for (int x=ox; x<ox+f; x++) {
+        uint16_t id = voxel_at(w, x,y,z);
+        if (!id) continue;
+        solid++;
+        int k = 0;
+        while (k<nids && ids[k]!=id) k++;
+        if (k == nids) {
+            if (nids == 8) continue;  // rare: more than 8 distinct ids in one cell
+            ids[nids] = id; counts[nids] = 0; nids++;
+        }
+        counts[k]++;
+    }
+    if (solid*2 < f*f*f) return 0;
+    int best = 0;
+    for (int k=1;k<nids;k++) if (counts[k] > counts[best]) best = k;
+    return ids[best];
+}
+
+// Which voxels of the chunk face d the neighbour across it covers at every LOD it
+// may be drawn at: mask[u + v*CHUNK_SIZE] is set when, for each level, the
+// neighbour cell holding the border voxel at (u,v) is solid. u and v run along
+// the two other axes, in x,y,z order after the face axis.
+static void border_mask(const World* w, int x0,int y0,int z0, int d, uint8_t* mask) {
+    const int ax = d>>1, au = (ax+1)%3, av = (ax+2)%3;
+    memset(mask, 1, CHUNK_SIZE*CHUNK_SIZE);
+    for (int l=0; l<LOD_LEVELS; l++) {
+        int g = 1<<l;
+        for (int v=0; v<CHUNK_SIZE; v+=g)
+        for (int u=0; u<CHUNK_SIZE; u+=g) {
+            int o[3] = { x0, y0, z0 };
+            o[ax] += kFaceDir[d][ax] > 0 ? CHUNK_SIZE : -g;
+            o[au] += u; o[av] += v;
+            if (sample_cell(w, o[0],o[1],o[2], g)) continue;
+            for (int b=0; b<g; b++) memset(mask + u + (v+b)*CHUNK_SIZE, 0, (size_t)g);
+        }
+    }
+}
+
+// Build the mesh of chunk (cx,cy,cz) at one LOD level. Vertices are relative to
+// the chunk origin. Faces between two solid cells are culled. On the chunk border
+// the neighbour may be drawn at any level, so a face is only culled where the
+// neighbour is solid at all of them (border_mask); edits within a coarsest cell of
+// a border remesh both chunks (chunks_mark_dirty).
+static Mesh build_chunk_mesh(const Engine* e, int cx,int cy,int cz, int lod) {
+    const World* w = &e->world;
+    const int f = 1<<lod, n = CHUNK_SIZE/f;
+    const int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+
+    static uint16_t cell[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    static uint8_t  faces[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    #define CELL(i,j,k) cell[(i) + (j)*n + (k)*n*n]
+
+    for (int k=0;k<n;k++) for (int j=0;j<n;j++) for (int i=0;i<n;i++)
+        CELL(i,j,k) = sample_cell(w, x0+i*f, y0+j*f, z0+k*f, f);
+    static uint8_t border[6][CHUNK_SIZE*CHUNK_SIZE];
+    for (int d=0; d<6; d++) border_mask(w, x0,y0,z0, d, border[d]);
+
+    // pass 1: face masks + count
+    int nfaces = 0;
+    for (int k=0;k<n;k++) for (int j=0;j<n;j++) for (int i=0;i<n;i++) {
+        uint8_t mask = 0;
+        uint16_t id = CELL(i,j,k);
+        if (id) {
+            uint16_t tile = id < 256 ? e->defs.tile_of_block[id] : 0xFFFF;
+            if (tile != 0xFFFF && tile < e->atlas.tile_count) {
+                for (int d=0; d<6; d++) {
+                    int ni = i+kFaceDir[d][0], nj = j+kFaceDir[d][1], nk = k+kFaceDir[d][2];
+                    bool occluded;
+                    if (ni>=0 && nj>=0 && nk>=0 && ni<n && nj<n && nk<n) {
+                        occluded = CELL(ni,nj,nk) != 0;
+                    } else {   // every border voxel this cell's face spans
+                        const int c3[3] = { i*f, j*f, k*f }, ax = d>>1;
+                        const int u0 = c3[(ax+1)%3], v0 = c3[(ax+2)%3];
+                        occluded = true;
+                        for (int v=v0; v<v0+f && occluded; v++)
+                        for (int u=u0; u<u0+f; u++) if (!border[d][u + v*CHUNK_SIZE]) { occluded = false; break; }
+                    }
+                    if (!occluded) { mask |= (uint8_t)(1u<<d); nfaces++; }
+                }
+            }
+        }
+        faces[i + j*n + k*n*n] = mask;
+    }
+
+    Mesh m = { 0 };
+    if (!nfaces) return m;
+    m.vertexCount   = nfaces*6;
+    m.triangleCount = nfaces*2;
+    m.vertices = (float*)RL_MALLOC(m.vertexCount*3*sizeof(float));
+    m.colors   = (unsigned char*)RL_MALLOC(m.vertexCount*4);
+
+    // pass 2: emit two triangles per visible face
+    static const int kQuad[6] = { 0,1,2, 0,2,3 };
+    int vi = 0;
+    for (int k=0;k<n;k++) for (int j=0;j<n;j++) for (int i=0;i<n;i++) {
+        uint8_t mask = faces[i + j*n + k*n*n];
+        if (!mask) continue;
+        Color base = tileColorForIndex(e->defs.tile_of_block[CELL(i,j,k)]);
+        for (int d=0; d<6; d++) {
+            if (!(mask & (1u<<d))) continue;
+            unsigned char s = kFaceShade[d];
+            Color c = { (unsigned char)(base.r*s/255), (unsigned char)(base.g*s/255), (unsigned char)(base.b*s/255), 255 };
+            for (int q=0;q<6;q++) {
+                const float* p = kFaceCorner[d][kQuad[q]];
+                m.vertices[vi*3+0] = (float)((i + p[0])*f);
+                m.vertices[vi*3+1] = (float)((j + p[1])*f);
+                m.vertices[vi*3+2] = (float)((k + p[2])*f);
+                m.colors[vi*4+0] = c.r; m.colors[vi*4+1] = c.g; m.colors[vi*4+2] = c.b; m.colors[vi*4+3] = c.a;
+                vi++;
+            }
+        }
+    }
+    #undef CELL
+    return m;
+}
+
+// The mesh reads the chunk and the border cells of its face neighbours. When a
+// writer got into any of them meanwhile it may be torn: it is dropped, the old
+// mesh stays, and the chunk is left stale for the next frame.
+static void chunk_rebuild(Engine* e, int ci, int lod) {
+    World* w = &e->world;
+    Chunk* c = &w->chunks[ci];
+    int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+    const Chunk* src[7] = { c };
+    uint32_t seq[7];
+    int nsrc = 1;
+    for (int d=0; d<6; d++) {
+        int nx = cx+kFaceDir[d][0], ny = cy+kFaceDir[d][1], nz = cz+kFaceDir[d][2];
+        if (nx>=0 && ny>=0 && nz>=0 && nx<w->ncx && ny<w->ncy && nz<w->ncz) src[nsrc++] = &w->chunks[chunkIndex(w,nx,ny,nz)];
+    }
+    for (int i=0; i<nsrc; i++) seq[i] = chunk_read_begin(src[i]);
+    c->stale &= (uint8_t)~(1u<<lod);   // before reading: an edit from here on marks it again
+
+    double t0 = stats_now();
+    Mesh m = build_chunk_mesh(e, cx,cy,cz, lod);
+    bool torn = false;
+    for (int i=0; i<nsrc; i++) torn |= chunk_read_retry(src[i], seq[i]);
+    if (torn) {
+        RL_FREE(m.vertices); RL_FREE(m.colors);
+        c->stale |= (uint8_t)(1u<<lod);
+        e->cur.mesh_ms += (float)((stats_now()-t0)*1000.0);
+        return;
+    }
+    chunk_unload_mesh(e, c, lod);
+    c->mesh[lod] = m;
+    double t1 = stats_now();
+    if (c->mesh[lod].vertexCount > 0 && !e->headless) UploadMesh(&c->mesh[lod], false);
+    c->built |= (uint8_t)(1u<<lod);
+    e->cur.mesh_ms   += (float)((t1-t0)*1000.0);
+    e->cur.upload_ms += (float)((stats_now()-t1)*1000.0);
+    e->cur.chunks_meshed++;
+}
+
+// Same view/projection raylib uses for BeginMode3D (default near/far planes).
+Matrix camera_view_proj(const Engine* e) {
+    float aspect = (float)e->screen_w / (float)(e->screen_h > 0 ? e->screen_h : 1);
+    const Camera3D* cam = &e->view.cam;
+    Matrix view = MatrixLookAt(cam->position, cam->target, cam->up);
+    Matrix proj = MatrixPerspective(cam->fovy*DEG2RAD, aspect, 0.01, 1000.0);
+    return MatrixMultiply(view, proj);
+}
+
+// Frustum planes (a,b,c,d) with inward normals, from the raylib view/projection.
+void frustum_planes(const Engine* e, Vector4 out[6]) {
+    Matrix m = camera_view_proj(e);
+    Vector4 r0 = { m.m0, m.m4, m.m8,  m.m12 };
+    Vector4 r1 = { m.m1, m.m5, m.m9,  m.m13 };
+    Vector4 r2 = { m.m2, m.m6, m.m10, m.m14 };
+    Vector4 r3 = { m.m3, m.m7, m.m11, m.m15 };
+    out[0] = (Vector4){ r3.x+r0.x, r3.y+r0.y, r3.z+r0.z, r3.w+r0.w };
+    out[1] = (Vector4){ r3.x-r0.x, r3.y-r0.y, r3.z-r0.z, r3.w-r0.w };
+    out[2] = (Vector4){ r3.x+r1.x, r3.y+r1.y, r3.z+r1.z, r3.w+r1.w };
+    out[3] = (Vector4){ r3.x-r1.x, r3.y-r1.y, r3.z-r1.z, r3.w-r1.w };
+    out[4] = (Vector4){ r3.x+r2.x, r3.y+r2.y, r3.z+r2.z, r3.w+r2.w };
+    out[5] = (Vector4){ r3.x-r2.x, r3.y-r2.y, r3.z-r2.z, r3.w-r2.w };
+}
+
+static bool aabb_in_frustum(const Vector4 pl[6], Vector3 lo, Vector3 hi) {
+    for (int i=0;i<6;i++) {
+        // farthest corner along the plane normal
+        float px = pl[i].x >= 0 ? hi.x : lo.x;
+        float py = pl[i].y >= 0 ? hi.y : lo.y;
+        float pz = pl[i].z >= 0 ? hi.z : lo.z;
+        if (pl[i].x*px + pl[i].y*py + pl[i].z*pz + pl[i].w < 0) return false;
+    }
+    return true;
+}
+
+static int cmp_vis(const void* a, const void* b) {
+    float da = ((const VisChunk*)a)->dist, db = ((const VisChunk*)b)->dist;
+    return (da > db) - (da < db);
+}
+
+// Pick a drawable LOD for chunk c, preferring the wanted one, then finer, then coarser.
+static int drawable_lod(const Chunk* c, int want) {
+    if (c->built & (1u<<want)) return want;
+    for (int l=want-1; l>=0; l--) if (c->built & (1u<<l)) return l;
+    for (int l=want+1; l<LOD_LEVELS; l++) if (c->built & (1u<<l)) return l;
+    return -1;
+}
+
+// Distance/frustum test of one chunk; fills *out (index, LOD, distance) when it passes.
+bool chunk_view_test(const Engine* e, const Vector4 planes[6], int cx,int cy,int cz, VisChunk* out) {
+    const World* w = &e->world;
+    Vector3 cam = e->view.cam.position;
+    // voxel (x,y,z) is drawn centred on (x,y,z), so chunks span [o-0.5, o+S-0.5]
+    Vector3 lo = { cx*CHUNK_SIZE-0.5f, cy*CHUNK_SIZE-0.5f, cz*CHUNK_SIZE-0.5f };
+    Vector3 hi = { lo.x+CHUNK_SIZE, lo.y+CHUNK_SIZE, lo.z+CHUNK_SIZE };
+    float dx = cam.x<lo.x ? lo.x-cam.x : cam.x>hi.x ? cam.x-hi.x : 0;
+    float dy = cam.y<lo.y ? lo.y-cam.y : cam.y>hi.y ? cam.y-hi.y : 0;
+    float dz = cam.z<lo.z ? lo.z-cam.z : cam.z>hi.z ? cam.z-hi.z : 0;
+    float dist = sqrtf(dx*dx + dy*dy + dz*dz);
+    if (dist > e->view_dist) return false;
+    if (!aabb_in_frustum(planes, lo, hi)) return false;
+    int lod = 0;
+    while (lod < LOD_LEVELS-1 && dist > e->lod_dist[lod]) lod++;
+    *out = (VisChunk){ chunkIndex(w,cx,cy,cz), lod, dist };
+    return true;
+}
+
+int collect_visible_chunks(Engine* e) {
+    World* w = &e->world;
+    if (!w->chunks) return 0;
+
+    double t0 = stats_now();
+    Vector4 planes[6];
+    frustum_planes(e, planes);
+
+    // cave culling walks the chunk visibility graph from the camera; it needs the
+    // camera inside the world, otherwise fall back to testing every chunk
+    int nvis = e->cave_culling ? visgraph_collect(e, planes) : -1;
+    if (nvis < 0) {
+        nvis = 0;
+        for (int cz=0; cz<w->ncz; cz++)
+        for (int cy=0; cy<w->ncy; cy++)
+        for (int cx=0; cx<w->ncx; cx++)
+            if (chunk_view_test(e, planes, cx,cy,cz, &e->vis[nvis])) nvis++;
+    }
+    qsort(e->vis, nvis, sizeof(VisChunk), cmp_vis);
+    e->chunks_occluded = 0;
+    if (e->occlusion) nvis = occlusion_cull(e, nvis);
+    e->cur.chunks_visible = nvis;
+    e->cur.cull_ms += (float)((stats_now()-t0)*1000.0);
+    return nvis;
+}
+
+const Mesh* chunk_draw_mesh(Engine* e, const VisChunk* vc, int* budget) {
+    Chunk* c = &e->world.chunks[vc->ci];
+    uint8_t bit = (uint8_t)(1u<<vc->lod);
+    if (*budget > 0 && (!(c->built & bit) || (c->stale & bit))) { chunk_rebuild(e, vc->ci, vc->lod); (*budget)--; }
+    int lod = drawable_lod(c, vc->lod);
+    if (lod < 0 || c->mesh[lod].vertexCount == 0) return NULL;
+    return &c->mesh[lod];
+}
+
+bool chunks_prepare(Engine* e) {
+    World* w = &e->world;
+    if (!world_read_enter(w)) return false;
+    e->ndraws = 0;
+    int n = w->ncx*w->ncy*w->ncz;
+    if (!w->chunks || !e->atlas.tiles) { world_read_leave(w); return true; }
+    if (e->draws_cap < n) {
+        ChunkDraw* d = (ChunkDraw*)realloc(e->draws, (size_t)n*sizeof(ChunkDraw));
+        if (!d) { world_read_leave(w); return true; }
+        e->draws = d; e->draws_cap = n;
+    }
+
+    int nvis = collect_visible_chunks(e);
+
+    // (re)mesh nearest-first within budget, then draw whatever is built
+    int budget = e->mesh_budget;
+    for (int i=0;i<nvis;i++) {
+        VisChunk* vc = &e->vis[i];
+        const Mesh* m = chunk_draw_mesh(e, vc, &budget);
+        if (!m) continue;
+        int cx = vc->ci % w->ncx, cy = (vc->ci / w->ncx) % w->ncy, cz = vc->ci / (w->ncx*w->ncy);
+        e->draws[e->ndraws++] = (ChunkDraw){ *m, { cx*CHUNK_SIZE-0.5f, cy*CHUNK_SIZE-0.5f, cz*CHUNK_SIZE-0.5f } };
+    }
+    world_read_leave(w);
+    return true;
+}
+
+void chunks_submit(Engine* e) {
+    e->chunks_drawn = 0; e->tris_drawn = 0;
+    if (!e->ndraws) return;
+    if (!e->mesh_mat_loaded) { e->mesh_mat = LoadMaterialDefault(); e->mesh_mat_loaded = true; }
+    for (int i=0;i<e->ndraws;i++) {
+        const ChunkDraw* d = &e->draws[i];
+        DrawMesh(d->mesh, e->mesh_mat, MatrixTranslate(d->origin.x, d->origin.y, d->origin.z));
+        e->cur.draw_calls++;
+        e->chunks_drawn++;
+        e->tris_drawn += d->mesh.triangleCount;
+    }
+}
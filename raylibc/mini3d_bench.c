@@ -0,0 +1,451 @@
+// mini3d_bench.c — microbenchmarks of the engine core, headless, for diffing commits.
+//
+//   ./mini3d_bench [options]
+//     --sizes 64x64x64,128x64x128,256x64x256   world sizes to run every case on
+//     --filter name          only cases whose name contains this (e.g. set, mesh)
+//     --min-time ms          minimum time per measured batch (default 50)
+//     --reps N               measured batches per case (default 7)
+//     --csv out.csv          also write one row per case and size
+//     --atlas png tile_px cols rows   (default terrain_sheet_simple.png 64 8 8; meshing only)
+//
+// Cases: set/get (random voxels), fill (16^3 boxes), clear (whole world), mesh (every
+// visible chunk at LOD 0, rebuilt through the software renderer's draw path), raycast
+// (random rays down onto the terrain), save/load (the world as a recording, replay.c),
+// snapshot (take one, edit a voxel under it, release it), build_each/build_batch (a
+// structure set voxel by voxel while frames are drawn, per call or as one edit
+// batch), generate (the dedicated server's terrain formula written slab by slab) and
+// changes (a voxel set and its record read back through the change feed; fails if a
+// cursor from before the feed was turned off and on again is not reported stale).
+// Each case runs on a world holding the same generated terrain. Iteration counts are
+// calibrated first (doubling until one batch takes --min-time), which also warms
+// caches; then --reps batches of that count are timed and the median and minimum ns/op
+// are reported, with throughput in the case's own unit and the spread between the
+// slowest and fastest batch. Inputs come from a fixed-seed generator, so two builds
+// run exactly the same operations. A case that fails is reported on stderr and makes
+// the exit status 1.
+#include "engine.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SIZES   8
+#define MAX_REPS    64
+#define NINPUTS     65536          // pre-generated random inputs, reused cyclically
+#define FILL_EDGE   16
+#define BUILD_EDITS 512            // voxels per structure (build cases)
+#define BUILD_FRAME 64             // ... drawn after every this many
+
+typedef struct {
+    Engine* e;
+    int sx, sy, sz;
+    int   (*pos)[3];               // [NINPUTS] random voxels
+    float (*ray)[6];               // [NINPUTS] origin + direction
+    const char* tmp;               // scratch recording for save/load
+    bool  can_mesh;
+    long  builds;                  // structures built so far: each one sets new ids
+    volatile uint32_t sink;        // keeps reads from being optimized away
+} Bench;
+
+typedef struct {
+    const char* name;
+    const char* unit;              // throughput unit
+    double scale;                  // units per item (1e-6 for the "M" units)
+    // Runs `iters` operations; returns the seconds they took and adds the units processed to *items.
+    double (*run)(Bench* b, long iters, double* items);
+} Case;
+
+static double now_s(void) {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static uint32_t rng_state = 0x9E3779B9u;
+static uint32_t rng(void) {   // xorshift32: same sequence on every platform
+    rng_state ^= rng_state << 13; rng_state ^= rng_state >> 17; rng_state ^= rng_state << 5;
+    return rng_state;
+}
+static float rng01(void) { return (rng() >> 8)*(1.0f/16777216.0f); }
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Same hills as mini3d_server (grass, dirt, stone), one x-y slab per z.
+static void generate_terrain(Engine* e, int sx, int sy, int sz, uint16_t* slab) {
+    for (int z=0; z<sz; z++) {
+        for (int x=0; x<sx; x++) {
+            int h = (int)(sy*0.35f + 6*sinf(x*0.07f) + 5*cosf(z*0.05f) + 3*sinf((x+z)*0.11f));
+            if (h < 1) h = 1;
+            if (h > sy) h = sy;
+            for (int y=0; y<sy; y++) slab[x + y*sx] = y >= h ? 0 : y < h-4 ? 5 : y < h-1 ? 3 : 1;
+        }
+        engine_write_region(e, 0, 0, z, sx, sy, 1, slab);
+    }
+}
+
+static double run_set(Bench* b, long iters, double* items) {
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        const int* p = b->pos[i & (NINPUTS-1)];
+        engine_set_block(b->e, p[0], p[1], p[2], (uint16_t)(1 + (i & 3)));
+    }
+    *items += (double)iters;
+    return now_s() - t0;
+}
+
+static double run_get(Bench* b, long iters, double* items) {
+    uint32_t acc = 0;
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        const int* p = b->pos[i & (NINPUTS-1)];
+        acc += engine_get_block(b->e, p[0], p[1], p[2]);
+    }
+    double t = now_s() - t0;
+    b->sink += acc;
+    *items += (double)iters;
+    return t;
+}
+
+static double run_fill(Bench* b, long iters, double* items) {
+    int n = FILL_EDGE - 1;
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        const int* p = b->pos[i & (NINPUTS-1)];
+        int x = p[0] % (b->sx > n ? b->sx - n : 1), y = p[1] % (b->sy > n ? b->sy - n : 1), z = p[2] % (b->sz > n ? b->sz - n : 1);
+        engine_fill_box(b->e, x, y, z, x+n, y+n, z+n, (uint16_t)(1 + (i & 3)));
+    }
+    *items += (double)iters*FILL_EDGE*FILL_EDGE*FILL_EDGE;
+    return now_s() - t0;
+}
+
+static double run_clear(Bench* b, long iters, double* items) {
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) engine_clear_world(b->e, (uint16_t)(i & 1 ? 5 : 0));
+    *items += (double)iters*b->sx*b->sy*b->sz;
+    return now_s() - t0;
+}
+
+// Camera straight down from high enough to see every chunk, all at LOD 0.
+static void view_whole_world(Bench* b) {
+    int span = b->sx > b->sz ? b->sx : b->sz;
+    engine_set_lod_distances(b->e, 1e6f, 1e6f, 1e6f, 1e6f);
+    engine_set_camera_pose(b->e, b->sx*0.5f, b->sy + 1.3f*span, b->sz*0.5f, 0, -1.5607964f);
+}
+
+// One op = remeshing every chunk in view. Redefining a block's tile marks all chunks
+// stale without touching voxels; the next software-rendered tick rebuilds them (the
+// budget is unlimited). Timed from the engine's own mesh stage, so culling and
+// rasterizing are left out.
+static double run_mesh(Bench* b, long iters, double* items) {
+    double t = 0;
+    engine_set_render_mode(b->e, ENGINE_RENDER_SOFTWARE);
+    for (long i=0; i<iters; i++) {
+        engine_define_block_tile(b->e, 1, 0);
+        engine_tick(b->e, 0);
+        EngineFrameStats st;
+        engine_get_stats(b->e, &st);
+        if (st.chunks_meshed == 0) { t = -1; break; }   // nothing in view
+        t += (st.mesh_ms + st.upload_ms)*1e-3;
+        *items += st.chunks_meshed;
+    }
+    engine_set_render_mode(b->e, ENGINE_RENDER_MESHED);   // headless: other ticks draw nothing
+    return t;
+}
+
+static double run_raycast(Bench* b, long iters, double* items) {
+    float max_dist = (float)(b->sx + b->sy + b->sz);
+    uint32_t acc = 0;
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        const float* r = b->ray[i & (NINPUTS-1)];
+        acc += engine_raycast(b->e, r[0], r[1], r[2], r[3], r[4], r[5], max_dist, NULL, NULL);
+    }
+    double t = now_s() - t0;
+    b->sink += acc;
+    *items += (double)iters;
+    return t;
+}
+
+static double run_save(Bench* b, long iters, double* items) {
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        if (!engine_start_recording(b->e, b->tmp)) return -1;
+        EngineRecordingStats rs;
+        engine_get_recording_stats(b->e, &rs);
+        engine_stop_recording(b->e);
+        *items += (double)rs.bytes;
+    }
+    return now_s() - t0;
+}
+
+// One replayed tick applies the recording's world (as mini3d_flythrough --world does).
+static double run_load(Bench* b, long iters, double* items) {
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        if (!engine_start_replay(b->e, b->tmp)) return -1;
+        EngineRecordingStats rs;
+        engine_get_recording_stats(b->e, &rs);
+        engine_tick(b->e, 0);
+        engine_stop_replay(b->e);
+        *items += (double)rs.bytes;
+    }
+    return now_s() - t0;
+}
+
+// One op = a structure of BUILD_EDITS voxels set one call at a time in a 32^3 box,
+// with a software-rendered frame after every BUILD_FRAME of them (a controller
+// spread over frames) and one more at the end. Per call, every frame remeshes what
+// the edits so far touched; in a batch the chunks are marked once at the commit
+// and only the last frame remeshes them. Timed: the edits plus the frames' mesh
+// stage (as in mesh), not culling or rasterizing.
+static void build_frame(Bench* b, double* t) {
+    engine_tick(b->e, 0);
+    EngineFrameStats st;
+    engine_get_stats(b->e, &st);
+    *t += (st.mesh_ms + st.upload_ms)*1e-3;
+}
+
+static double run_build_mode(Bench* b, long iters, double* items, bool batch) {
+    double t = 0;
+    engine_set_render_mode(b->e, ENGINE_RENDER_SOFTWARE);
+    for (long i=0; i<iters; i++) {
+        const int* p0 = b->pos[i & (NINPUTS-1)];
+        long n = b->builds++;
+        int o[3] = { p0[0] % (b->sx > 32 ? b->sx - 32 : 1), p0[1] % (b->sy > 32 ? b->sy - 32 : 1), p0[2] % (b->sz > 32 ? b->sz - 32 : 1) };
+        // look down on the structure from close by, so frames draw little besides it
+        engine_set_lod_distances(b->e, 1e6f, 1e6f, 1e6f, 80);
+        engine_set_camera_pose(b->e, o[0] + 16.0f, o[1] + 72.0f, o[2] + 16.0f, 0, -1.5607964f);
+        engine_tick(b->e, 0);   // untimed: meshes what the move brought into view
+        double t0 = now_s();
+        if (batch) engine_begin_edit(b->e);
+        for (int k=0; k<BUILD_EDITS; k++) {
+            const int* p = b->pos[(i*BUILD_EDITS + k + 1) & (NINPUTS-1)];
+            engine_set_block(b->e, o[0] + p[0]%32, o[1] + p[1]%32, o[2] + p[2]%32, (uint16_t)(1 + ((n + k) & 3)));
+            if (k % BUILD_FRAME == BUILD_FRAME-1) {
+                t += now_s() - t0;
+                build_frame(b, &t);
+                t0 = now_s();
+            }
+        }
+        if (batch) engine_commit_edit(b->e);
+        t += now_s() - t0;
+        build_frame(b, &t);
+    }
+    engine_set_render_mode(b->e, ENGINE_RENDER_MESHED);   // headless: other ticks draw nothing
+    view_whole_world(b);
+    *items += (double)iters*BUILD_EDITS;
+    return t;
+}
+
+static double run_build(Bench* b, long iters, double* items)       { return run_build_mode(b, iters, items, false); }
+static double run_build_batch(Bench* b, long iters, double* items) { return run_build_mode(b, iters, items, true); }
+
+// One op = a snapshot taken, one voxel set (its chunk copied out for the snapshot),
+// the snapshot released: the cost of a consistent save point, per chunk of the world.
+static double run_snapshot(Bench* b, long iters, double* items) {
+    int nchunks = ((b->sx+15)/16)*((b->sy+15)/16)*((b->sz+15)/16);
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) {
+        EngineSnapshot* s = engine_snapshot_world(b->e);
+        if (!s) return -1;
+        const int* p = b->pos[i & (NINPUTS-1)];
+        engine_set_block(b->e, p[0], p[1], p[2], (uint16_t)(1 + (i & 3)));
+        engine_release_snapshot(s);
+    }
+    *items += (double)iters*nchunks;
+    return now_s() - t0;
+}
+
+static double run_generate(Bench* b, long iters, double* items) {
+    uint16_t* slab = (uint16_t*)malloc((size_t)b->sx*b->sy*sizeof(uint16_t));
+    double t0 = now_s();
+    for (long i=0; i<iters; i++) generate_terrain(b->e, b->sx, b->sy, b->sz, slab);
+    double t = now_s() - t0;
+    free(slab);
+    *items += (double)iters*b->sx*b->sy*b->sz;
+    return t;
+}
+
+// One op = a voxel set to a new id and its record read back from the change feed.
+// First checks that a cursor from before the feed was switched off and on again is
+// reported stale (-1, jumped to the new ring) rather than reading slots the new ring
+// never wrote.
+static void set_other(Engine* e, const int* p) {   // always a change: same-id writes aren't recorded
+    engine_set_block(e, p[0], p[1], p[2], (uint16_t)(engine_get_block(e, p[0], p[1], p[2]) % 4 + 1));
+}
+
+static double run_changes(Bench* b, long iters, double* items) {
+    EngineChange rec;
+    engine_set_change_feed(b->e, true);
+    uint64_t stale = engine_change_cursor(b->e);
+    set_other(b->e, b->pos[0]);
+    engine_set_change_feed(b->e, false);
+    set_other(b->e, b->pos[1]);   // never recorded
+    engine_set_change_feed(b->e, true);
+    uint64_t cur = engine_change_cursor(b->e);
+    bool ok = engine_read_changes(b->e, &stale, &rec, 1) == -1 && stale == cur;
+    double t0 = now_s();
+    for (long i=0; i<iters && ok; i++) {
+        const int* p = b->pos[i & (NINPUTS-1)];
+        set_other(b->e, p);
+        ok = engine_read_changes(b->e, &cur, &rec, 1) == 1 && rec.x0 == p[0] && rec.y0 == p[1] && rec.z0 == p[2];
+    }
+    double t = now_s() - t0;
+    engine_set_change_feed(b->e, false);   // other cases run without it
+    *items += (double)iters;
+    return ok ? t : -1;
+}
+
+static const Case kCases[] = {
+    { "set",      "Mops/s",    1e-6, run_set },
+    { "get",      "Mops/s",    1e-6, run_get },
+    { "fill",     "Mvoxels/s", 1e-6, run_fill },
+    { "clear",    "Mvoxels/s", 1e-6, run_clear },
+    { "mesh",     "chunks/s",  1,    run_mesh },
+    { "raycast",  "Mrays/s",   1e-6, run_raycast },
+    { "save",     "MB/s",      1e-6, run_save },
+    { "load",     "MB/s",      1e-6, run_load },
+    { "snapshot", "Mchunks/s", 1e-6, run_snapshot },
+    { "build_each", "Kvoxels/s", 1e-3, run_build },
+    { "build_batch", "Kvoxels/s", 1e-3, run_build_batch },
+    { "generate", "Mvoxels/s", 1e-6, run_generate },
+    { "changes",  "Mops/s",    1e-6, run_changes },
+};
+
+// Fresh terrain before every case, so cases don't see each other's edits.
+static void reset_world(Bench* b) {
+    uint16_t* slab = (uint16_t*)malloc((size_t)b->sx*b->sy*sizeof(uint16_t));
+    generate_terrain(b->e, b->sx, b->sy, b->sz, slab);
+    free(slab);
+}
+
+int main(int argc, char** argv) {
+    int sizes[MAX_SIZES][3] = { {64,64,64}, {128,64,128}, {256,64,256} };
+    int nsizes = 3, reps = 7, tile_px = 64, cols = 8, rows = 8;
+    double min_time = 0.05;
+    const char* filter = NULL;
+    const char* csv = NULL;
+    const char* atlas = "terrain_sheet_simple.png";
+    for (int i=1; i<argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--sizes") && i+1 < argc) {
+            nsizes = 0;
+            for (const char* s = argv[++i]; *s && nsizes < MAX_SIZES; ) {
+                int* d = sizes[nsizes];
+                int used = 0;
+                if (sscanf(s, "%dx%dx%d%n", &d[0], &d[1], &d[2], &used) != 3 || d[0] <= 0 || d[1] <= 0 || d[2] <= 0) {
+                    fprintf(stderr, "mini3d_bench: bad size list %s (want SXxSYxSZ,...)\n", argv[i]);
+                    return 2;
+                }
+                nsizes++;
+                s += used;
+                if (*s == ',') s++;
+            }
+        }
+        else if (!strcmp(a, "--filter") && i+1 < argc) filter = argv[++i];
+        else if (!strcmp(a, "--min-time") && i+1 < argc) min_time = atof(argv[++i])*1e-3;
+        else if (!strcmp(a, "--reps") && i+1 < argc) reps = atoi(argv[++i]);
+        else if (!strcmp(a, "--csv") && i+1 < argc) csv = argv[++i];
+        else if (!strcmp(a, "--atlas") && i+4 < argc) {
+            atlas = argv[i+1]; tile_px = atoi(argv[i+2]); cols = atoi(argv[i+3]); rows = atoi(argv[i+4]); i += 4;
+        } else {
+            fprintf(stderr, "mini3d_bench: unknown option %s (see the top of mini3d_bench.c)\n", a);
+            return 2;
+        }
+    }
+    if (reps < 1) reps = 1;
+    if (reps > MAX_REPS) reps = MAX_REPS;
+    if (min_time <= 0) min_time = 0.05;
+
+    FILE* out = NULL;
+    if (csv) {
+        if (!(out = fopen(csv, "w"))) { fprintf(stderr, "mini3d_bench: cannot write %s\n", csv); return 1; }
+        fprintf(out, "case,sx,sy,sz,iters,reps,ns_op_median,ns_op_min,throughput,unit,spread_pct\n");
+    }
+
+    int status = 0;   // 1 if any case failed
+    Bench b = { 0 };
+    b.pos = malloc(NINPUTS*sizeof *b.pos);
+    b.ray = malloc(NINPUTS*sizeof *b.ray);
+    b.tmp = "mini3d_bench.m3r";
+    printf("%-11s %-12s %10s %12s %12s %18s %8s\n", "case", "world", "iters", "ns/op med", "ns/op min", "throughput", "spread");
+    for (int si=0; si<nsizes; si++) {
+        b.sx = sizes[si][0]; b.sy = sizes[si][1]; b.sz = sizes[si][2];
+        b.e = engine_create_headless(-1);   // unpaced ticks
+        if (!b.e || !engine_create_world(b.e, b.sx, b.sy, b.sz)) {
+            fprintf(stderr, "mini3d_bench: cannot create a %dx%dx%d world\n", b.sx, b.sy, b.sz);
+            if (b.e) engine_destroy(b.e);
+            continue;
+        }
+        // Meshing runs in the software renderer's draw path (run_mesh): a tiny target, the camera
+        // high above the centre looking straight down, every chunk in view at LOD 0.
+        b.can_mesh = engine_load_atlas(b.e, atlas, tile_px, cols, rows);
+        if (b.can_mesh) {
+            for (int t=0; t<cols*rows && t<255; t++) engine_define_block_tile(b.e, (uint16_t)(t+1), t);
+            engine_set_software_target(b.e, 64, 64, 1);
+            engine_set_occlusion(b.e, false);
+            engine_set_cave_culling(b.e, false);
+            engine_set_mesh_budget(b.e, 1 << 30);
+            view_whole_world(&b);
+        }
+        rng_state = 0x9E3779B9u;
+        for (int i=0; i<NINPUTS; i++) {
+            b.pos[i][0] = (int)(rng() % (uint32_t)b.sx);
+            b.pos[i][1] = (int)(rng() % (uint32_t)b.sy);
+            b.pos[i][2] = (int)(rng() % (uint32_t)b.sz);
+            float* r = b.ray[i];   // from just under the top, down at up to 45 degrees
+            r[0] = rng01()*b.sx; r[1] = b.sy - 0.5f; r[2] = rng01()*b.sz;
+            r[3] = rng01()*2 - 1; r[4] = -1.0f; r[5] = rng01()*2 - 1;
+        }
+        char world[40];
+        snprintf(world, sizeof world, "%dx%dx%d", b.sx, b.sy, b.sz);
+
+        for (size_t ci=0; ci<sizeof kCases/sizeof kCases[0]; ci++) {
+            const Case* c = &kCases[ci];
+            if (filter && !strstr(c->name, filter)) continue;
+            if ((run_mesh == c->run || run_build == c->run || run_build_batch == c->run) && !b.can_mesh) {
+                fprintf(stderr, "mini3d_bench: %s skipped, could not load atlas %s\n", c->name, atlas);
+                continue;
+            }
+            reset_world(&b);
+            if (run_load == c->run) {   // needs a recording to read
+                double unused = 0;
+                if (run_save(&b, 1, &unused) < 0) { fprintf(stderr, "mini3d_bench: cannot write %s\n", b.tmp); continue; }
+            }
+            // calibrate: grow the batch until it takes min_time (this is also the warmup)
+            long iters = 1;
+            bool failed = false;
+            for (;;) {
+                double items = 0, t = c->run(&b, iters, &items);
+                if (t < 0) { failed = true; break; }
+                if (t >= min_time || iters >= (1L << 30)) break;
+                double grow = t > 0 ? 1.2*min_time/t : 10;
+                iters = (long)(iters*(grow < 2 ? 2 : grow > 10 ? 10 : grow));
+            }
+            if (failed) { fprintf(stderr, "mini3d_bench: %s failed\n", c->name); status = 1; continue; }
+            double ns[MAX_REPS], items_total = 0, secs_total = 0;
+            for (int r=0; r<reps; r++) {
+                double items = 0, t = c->run(&b, iters, &items);
+                ns[r] = t*1e9/iters;
+                items_total += items; secs_total += t;
+            }
+            qsort(ns, (size_t)reps, sizeof(double), cmp_double);
+            double med = ns[reps/2], tp = secs_total > 0 ? items_total*c->scale/secs_total : 0;
+            double spread = med > 0 ? 100.0*(ns[reps-1] - ns[0])/med : 0;
+            char tps[32];
+            snprintf(tps, sizeof tps, "%.2f %s", tp, c->unit);
+            printf("%-11s %-12s %10ld %12.1f %12.1f %18s %7.1f%%\n", c->name, world, iters, med, ns[0], tps, spread);
+            if (out) fprintf(out, "%s,%d,%d,%d,%ld,%d,%.2f,%.2f,%.4f,%s,%.2f\n",
+                             c->name, b.sx, b.sy, b.sz, iters, reps, med, ns[0], tp, c->unit, spread);
+        }
+        engine_destroy(b.e);
+    }
+    remove(b.tmp);
+    if (out) fclose(out);
+    free(b.pos); free(b.ray);
+    return status;
+}
@@ -0,0 +1,224 @@
+// mini3d_flythrough.c — reproducible rendering benchmark: a scripted camera path
+// over a reference world, per-frame stats to CSV.
+//
+//   ./mini3d_flythrough [options]
+//     --frames N             frames along one loop of the path (default 1800)
+//     --warmup N             frames at the start pose before measuring (default 120)
+//     --size sx sy sz        generated world size (default 256 64 256)
+//     --world session.m3r    start from the world of a recording instead (replay.c)
+//     --mode meshed|instanced|cubes|software
+//     --headless             no window or GPU (implies --mode software)
+//     --threads N            software rasterizer workers (default one per core)
+//     --ppm out.ppm          save the last software frame (golden image)
+//     --no-occlusion --no-cave-culling
+//     --csv out.csv          (default flythrough.csv)
+//     --atlas png tile_px cols rows   (default terrain_sheet_simple.png 64 8 8)
+//
+// The reference world is generated from fixed formulas (hills, caves, pillars), so
+// every run sees the same voxels. The camera follows a closed Catmull-Rom spline
+// around the world, looking along it, and is placed with engine_set_camera_pose
+// before every frame (ticks run with dt 0, so physics leaves it there). Frames are
+// uncapped. Each frame's stage times, draw calls, triangles and chunk counts go to
+// the CSV; p50/p95/p99/max of the main columns are printed at the end.
+#include "engine.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PATH_POINTS 8
+
+static int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char* name, const float* v, int n, int decimals, float* sorted) {
+    memcpy(sorted, v, (size_t)n*sizeof(float));
+    qsort(sorted, (size_t)n, sizeof(float), cmp_float);
+    printf("  %-15s p50 %9.*f  p95 %9.*f  p99 %9.*f  max %9.*f\n", name, decimals, sorted[n/2],
+           decimals, sorted[n*95/100], decimals, sorted[n*99/100], decimals, sorted[n-1]);
+}
+
+// Rolling hills with grass/dirt/stone layers, worm-like caves under them and a
+// grid of pillars on top: open views, overdraw and hidden volume to cull.
+static void generate_world(Engine* e, int sx, int sy, int sz) {
+    uint16_t* col = (uint16_t*)calloc((size_t)sy, sizeof(uint16_t));
+    for (int z=0; z<sz; z++)
+    for (int x=0; x<sx; x++) {
+        int h = (int)(sy*0.35f + 6*sinf(x*0.07f) + 5*cosf(z*0.05f) + 3*sinf((x+z)*0.11f));
+        if (h < 1) h = 1;
+        if (h > sy) h = sy;
+        for (int y=0; y<sy; y++) {
+            col[y] = y >= h ? 0 : y < h-4 ? 5 : y < h-1 ? 3 : 1;   // stone, dirt, grass
+            float cave = sinf(x*0.11f + y*0.05f) + sinf(z*0.09f - y*0.07f) + sinf((x-z)*0.05f);
+            if (y > 1 && y < h-3 && cave > 2.1f) col[y] = 0;
+        }
+        if (x % 24 == 12 && z % 24 == 12)   // pillars
+            for (int y=h; y<h+sy/4 && y<sy; y++) col[y] = 7;
+        engine_write_region(e, x, 0, z, 1, sy, 1, col);
+    }
+    free(col);
+}
+
+typedef struct { float x, y, z; } P3;
+
+static P3 catmull_rom(const P3* p, float u) {
+    int i = (int)floorf(u);
+    float t = u - (float)i, t2 = t*t, t3 = t2*t;
+    const P3 *a = &p[(i+PATH_POINTS-1)%PATH_POINTS], *b = &p[i%PATH_POINTS],
+             *c = &p[(i+1)%PATH_POINTS], *d = &p[(i+2)%PATH_POINTS];
+    float wa = -0.5f*t3 + t2 - 0.5f*t, wb = 1.5f*t3 - 2.5f*t2 + 1.0f;
+    float wc = -1.5f*t3 + 2.0f*t2 + 0.5f*t, wd = 0.5f*t3 - 0.5f*t2;
+    return (P3){ wa*a->x + wb*b->x + wc*c->x + wd*d->x,
+                 wa*a->y + wb*b->y + wc*c->y + wd*d->y,
+                 wa*a->z + wb*b->z + wc*c->z + wd*d->z };
+}
+
+// Control points on a wobbly loop around the centre, dipping low and climbing high.
+static void make_path(P3* p, int sx, int sy, int sz) {
+    float r = 0.35f*(float)(sx < sz ? sx : sz);
+    for (int k=0; k<PATH_POINTS; k++) {
+        float a = 6.2831853f*(float)k/PATH_POINTS;
+        float rk = r*(1.0f + 0.25f*sinf(3*a));
+        p[k] = (P3){ sx*0.5f + rk*cosf(a), sy*(0.75f + 0.2f*sinf(2*a)), sz*0.5f + rk*sinf(a) };
+    }
+}
+
+// Pose at u (in control-point units): on the curve, looking along it, tilted down.
+static void path_pose(const P3* p, float u, float* pos, float* yaw, float* pitch) {
+    P3 a = catmull_rom(p, u), b = catmull_rom(p, u + 0.01f);
+    float dx = b.x-a.x, dy = b.y-a.y, dz = b.z-a.z;
+    float len = sqrtf(dx*dx + dy*dy + dz*dz);
+    pos[0] = a.x; pos[1] = a.y; pos[2] = a.z;
+    *yaw = atan2f(dx, -dz);                               // forward = (sin yaw, ., -cos yaw)
+    *pitch = (len > 1e-6f ? asinf(dy/len) : 0) - 0.3f;
+}
+
+int main(int argc, char** argv) {
+    int frames = 1800, warmup = 120, sx = 256, sy = 64, sz = 256;
+    int mode = ENGINE_RENDER_MESHED, tile_px = 64, cols = 8, rows = 8;
+    int threads = 0;
+    bool occlusion = true, cave = true, headless = false;
+    const char* world = NULL;
+    const char* ppm = NULL;
+    const char* csv = "flythrough.csv";
+    const char* atlas = "terrain_sheet_simple.png";
+    for (int i=1; i<argc; i++) {
+        const char* a = argv[i];
+        if      (!strcmp(a, "--frames") && i+1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(a, "--warmup") && i+1 < argc) warmup = atoi(argv[++i]);
+        else if (!strcmp(a, "--size") && i+3 < argc) { sx = atoi(argv[i+1]); sy = atoi(argv[i+2]); sz = atoi(argv[i+3]); i += 3; }
+        else if (!strcmp(a, "--world") && i+1 < argc) world = argv[++i];
+        else if (!strcmp(a, "--csv") && i+1 < argc) csv = argv[++i];
+        else if (!strcmp(a, "--headless")) headless = true;
+        else if (!strcmp(a, "--threads") && i+1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(a, "--ppm") && i+1 < argc) ppm = argv[++i];
+        else if (!strcmp(a, "--no-occlusion")) occlusion = false;
+        else if (!strcmp(a, "--no-cave-culling")) cave = false;
+        else if (!strcmp(a, "--mode") && i+1 < argc) {
+            const char* m = argv[++i];
+            mode = !strcmp(m, "instanced") ? ENGINE_RENDER_INSTANCED : !strcmp(m, "cubes") ? ENGINE_RENDER_CUBES
+                 : !strcmp(m, "software") ? ENGINE_RENDER_SOFTWARE : ENGINE_RENDER_MESHED;
+        } else if (!strcmp(a, "--atlas") && i+4 < argc) {
+            atlas = argv[i+1]; tile_px = atoi(argv[i+2]); cols = atoi(argv[i+3]); rows = atoi(argv[i+4]); i += 4;
+        } else {
+            fprintf(stderr, "mini3d_flythrough: unknown option %s (see the top of mini3d_flythrough.c)\n", a);
+            return 2;
+        }
+    }
+    if (frames < 1) frames = 1;
+    if (headless) mode = ENGINE_RENDER_SOFTWARE;
+
+    Engine* e = headless ? engine_create_headless(-1) : engine_create(1280, 720, "mini3d flythrough", 0);
+    if (!e) return 1;
+    if (engine_load_atlas(e, atlas, tile_px, cols, rows)) {
+        for (int t=0; t<cols*rows && t<255; t++) engine_define_block_tile(e, (uint16_t)(t+1), t);
+    } else {
+        fprintf(stderr, "mini3d_flythrough: could not load atlas %s, blocks will not be drawn\n", atlas);
+    }
+    if (world) {   // one replayed tick applies the recording's starting world
+        if (!engine_start_replay(e, world)) {
+            fprintf(stderr, "mini3d_flythrough: %s is not a readable recording\n", world);
+            engine_destroy(e);
+            return 1;
+        }
+        engine_tick(e, 0);
+        engine_stop_replay(e);
+        if (!engine_get_world_size(e, &sx, &sy, &sz)) {
+            fprintf(stderr, "mini3d_flythrough: %s has no world\n", world);
+            engine_destroy(e);
+            return 1;
+        }
+    } else if (!engine_create_world(e, sx, sy, sz)) {
+        fprintf(stderr, "mini3d_flythrough: bad world size\n");
+        engine_destroy(e);
+        return 1;
+    } else {
+        generate_world(e, sx, sy, sz);
+    }
+    engine_set_render_mode(e, mode);
+    if (mode == ENGINE_RENDER_SOFTWARE) engine_set_software_target(e, 0, 0, threads);
+    engine_set_occlusion(e, occlusion);
+    engine_set_cave_culling(e, cave);
+
+    FILE* out = fopen(csv, "w");
+    if (!out) {
+        fprintf(stderr, "mini3d_flythrough: cannot write %s\n", csv);
+        engine_destroy(e);
+        return 1;
+    }
+    fprintf(out, "frame,frame_ms,cpu_ms,input_ms,physics_ms,cull_ms,mesh_ms,upload_ms,draw_ms,present_ms,"
+                 "draw_calls,triangles,chunks_visible,chunks_drawn,chunks_occluded,chunks_meshed,x,y,z,yaw,pitch\n");
+
+    P3 path[PATH_POINTS];
+    make_path(path, sx, sy, sz);
+    float* col_frame = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_cpu   = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_cull  = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_mesh  = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_draw  = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_calls = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_tris  = (float*)malloc((size_t)frames*sizeof(float));
+    float* col_vis   = (float*)malloc((size_t)frames*sizeof(float));
+    float* sorted    = (float*)malloc((size_t)frames*sizeof(float));
+
+    int n = 0;
+    for (int f = -warmup; f < frames; f++) {
+        float pos[3], yaw, pitch;
+        path_pose(path, f < 0 ? 0.0f : (float)PATH_POINTS*f/frames, pos, &yaw, &pitch);
+        engine_set_camera_pose(e, pos[0], pos[1], pos[2], yaw, pitch);
+        if (!engine_tick(e, 0)) break;   // window closed
+        EngineFrameStats st;
+        if (f < 0 || !engine_get_stats(e, &st)) continue;
+        float cpu = st.frame_ms - st.present_ms;   // everything but the buffer swap
+        fprintf(out, "%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%.4f,%.4f\n",
+                f, st.frame_ms, cpu, st.input_ms, st.physics_ms, st.cull_ms, st.mesh_ms, st.upload_ms, st.draw_ms,
+                st.present_ms, st.draw_calls, st.triangles, st.chunks_visible, st.chunks_drawn, st.chunks_occluded,
+                st.chunks_meshed, pos[0], pos[1], pos[2], yaw, pitch);
+        col_frame[n] = st.frame_ms; col_cpu[n] = cpu;
+        col_cull[n] = st.cull_ms; col_mesh[n] = st.mesh_ms + st.upload_ms; col_draw[n] = st.draw_ms;
+        col_calls[n] = (float)st.draw_calls; col_tris[n] = (float)st.triangles; col_vis[n] = (float)st.chunks_visible;
+        n++;
+    }
+    fclose(out);
+    if (ppm && !engine_save_software_frame(e, ppm))
+        fprintf(stderr, "mini3d_flythrough: no software frame to save to %s (use --mode software)\n", ppm);
+
+    printf("flythrough: %d frames (%d warmup), %s world %dx%dx%d, mode %d, occlusion %s, cave culling %s -> %s\n",
+           n, warmup, world ? world : "generated", sx, sy, sz, mode, occlusion ? "on" : "off", cave ? "on" : "off", csv);
+    if (n > 0) {
+        report("frame ms", col_frame, n, 3, sorted);
+        report("cpu ms", col_cpu, n, 3, sorted);
+        report("cull ms", col_cull, n, 3, sorted);
+        report("mesh+upload ms", col_mesh, n, 3, sorted);
+        report("draw ms", col_draw, n, 3, sorted);
+        report("draw calls", col_calls, n, 0, sorted);
+        report("triangles", col_tris, n, 0, sorted);
+        report("chunks visible", col_vis, n, 0, sorted);
+    }
+    free(col_frame); free(col_cpu); free(col_cull); free(col_mesh); free(col_draw);
+    free(col_calls); free(col_tris); free(col_vis); free(sorted);
+    engine_destroy(e);
+    return 0;
+}
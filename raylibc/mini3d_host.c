@@ -0,0 +1,82 @@
+// mini3d_host.c — standalone engine process driven over stdin/stdout.
+//
+// Any language can spawn this and speak the line-delimited JSON protocol of
+// notes/high-level-wrapper.md instead of linking the library via ctypes:
+//
+//   ./mini3d_host [atlas.png tile_px cols rows] < commands.jsonl
+//
+// With MINI3D_SHM=/name set it also serves the shared-memory transport (see
+// shm.c, shm_client.py), sized for MINI3D_SHM_VOXELS voxels (default 8M), and
+// with MINI3D_SOCKET=/path/to.sock it also accepts any number of clients on a
+// Unix-domain socket (sockserver.c). MINI3D_CONNECT=127.0.0.1:7777 joins a
+// mini3d_server as a player instead of owning the world (netclient.c), seeing
+// MINI3D_VIEW_RADIUS chunks around it (default 8) with MINI3D_LATENCY_MS of
+// simulated round trip. MINI3D_RECORD=session.m3r records the session for
+// mini3d_replay (replay.c). MINI3D_SIM_HZ=60 ticks the world on its own thread
+// at that rate while this one only draws (simthread.c).
+//
+// Block ids 1..tile_count map to tiles 0..tile_count-1 (like test_client.py).
+// raylib logs to stdout, so the real stdout is kept for protocol events and
+// fd 1 is pointed at stderr.
+#include "engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    int events_fd = dup(1);
+    dup2(2, 1);
+
+    Engine* e = engine_create(1280, 720, "mini3d host", 60);
+    if (!e) return 1;
+
+    const char* atlas = argc > 1 ? argv[1] : "terrain_sheet_simple.png";
+    int tile_px = argc > 2 ? atoi(argv[2]) : 64;
+    int cols    = argc > 3 ? atoi(argv[3]) : 8;
+    int rows    = argc > 4 ? atoi(argv[4]) : 8;
+    if (engine_load_atlas(e, atlas, tile_px, cols, rows)) {
+        for (int t=0; t<cols*rows && t<255; t++) engine_define_block_tile(e, (uint16_t)(t+1), t);
+    } else {
+        fprintf(stderr, "mini3d_host: could not load atlas %s, blocks will not be drawn\n", atlas);
+    }
+
+    if (!engine_start_command_server(e, 0, events_fd)) {
+        fprintf(stderr, "mini3d_host: command server unavailable on this platform\n");
+        engine_destroy(e);
+        return 1;
+    }
+    const char* shm = getenv("MINI3D_SHM");
+    if (shm) {
+        const char* cap = getenv("MINI3D_SHM_VOXELS");
+        if (!engine_start_shm(e, shm, cap ? atoi(cap) : 256*128*256))
+            fprintf(stderr, "mini3d_host: could not create shared memory %s\n", shm);
+    }
+    const char* sock = getenv("MINI3D_SOCKET");
+    if (sock && !engine_start_socket_server(e, sock))
+        fprintf(stderr, "mini3d_host: could not listen on %s\n", sock);
+    const char* server = getenv("MINI3D_CONNECT");
+    if (server) {
+        char host[64] = "127.0.0.1";
+        const char* colon = strrchr(server, ':');
+        if (colon && colon > server && (size_t)(colon - server) < sizeof host) {
+            memcpy(host, server, (size_t)(colon - server));
+            host[colon - server] = 0;
+        }
+        const char* radius = getenv("MINI3D_VIEW_RADIUS");
+        const char* latency = getenv("MINI3D_LATENCY_MS");
+        if (!engine_connect(e, host, atoi(colon ? colon + 1 : server), radius ? atoi(radius) : 8))
+            fprintf(stderr, "mini3d_host: could not connect to %s\n", server);
+        else if (latency)
+            engine_set_net_latency(e, (float)atof(latency));
+    }
+    const char* rec = getenv("MINI3D_RECORD");
+    if (rec && !engine_start_recording(e, rec))
+        fprintf(stderr, "mini3d_host: could not record to %s\n", rec);
+    const char* sim_hz = getenv("MINI3D_SIM_HZ");
+    if (sim_hz && !engine_start_sim_thread(e, atoi(sim_hz)))
+        fprintf(stderr, "mini3d_host: could not start the simulation thread\n");
+    while (engine_tick(e, 1.0f/60.0f)) {}
+    engine_destroy(e);
+    return 0;
+}
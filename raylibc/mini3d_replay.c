@@ -0,0 +1,96 @@
+// mini3d_replay.c — play a recorded session back as a benchmark.
+//
+//   ./mini3d_replay session.m3r [atlas.png tile_px cols rows]   # windowed, uncapped
+//   ./mini3d_replay session.m3r --headless                      # simulation only
+//
+// Record with MINI3D_RECORD=session.m3r on mini3d_host or mini3d_server (or
+// engine_start_recording). Every tick of the log runs through engine_tick as fast
+// as it will go; at the end it prints the wall time and per-stage frame time
+// percentiles over the whole session, and whether the replay stayed on the
+// recorded path. Run two builds on the same log to compare them.
+#include "engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static double now_s(void) {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static void report(const char* name, float* v, int n) {
+    qsort(v, (size_t)n, sizeof(float), cmp_float);
+    printf("  %-8s p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms\n",
+           name, v[n/2], v[n*95/100], v[n*99/100], v[n-1]);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: mini3d_replay session.m3r [--headless | atlas.png tile_px cols rows]\n");
+        return 2;
+    }
+    bool headless = argc > 2 && !strcmp(argv[2], "--headless");
+    Engine* e = headless ? engine_create_headless(60) : engine_create(1280, 720, "mini3d replay", 60);
+    if (!e) return 1;
+    if (!headless) {
+        const char* atlas = argc > 2 ? argv[2] : "terrain_sheet_simple.png";
+        int tile_px = argc > 3 ? atoi(argv[3]) : 64;
+        int cols    = argc > 4 ? atoi(argv[4]) : 8;
+        int rows    = argc > 5 ? atoi(argv[5]) : 8;
+        if (engine_load_atlas(e, atlas, tile_px, cols, rows)) {
+            for (int t=0; t<cols*rows && t<255; t++) engine_define_block_tile(e, (uint16_t)(t+1), t);
+        } else {
+            fprintf(stderr, "mini3d_replay: could not load atlas %s, blocks will not be drawn\n", atlas);
+        }
+    }
+    if (!engine_start_replay(e, argv[1])) {
+        fprintf(stderr, "mini3d_replay: %s is not a readable recording\n", argv[1]);
+        engine_destroy(e);
+        return 1;
+    }
+    EngineRecordingStats rs;
+    engine_get_recording_stats(e, &rs);
+    int cap = (int)rs.ticks_total;
+    if (cap < 1) cap = 1;
+
+    // per-tick stages, kept for the whole run (the engine's history ring is shorter)
+    float* frame   = (float*)malloc((size_t)cap*sizeof(float));
+    float* work    = (float*)malloc((size_t)cap*sizeof(float));
+    float* sim     = (float*)malloc((size_t)cap*sizeof(float));
+    float* render  = (float*)malloc((size_t)cap*sizeof(float));
+    int n = 0;
+    double t0 = now_s();
+    while (engine_tick(e, 0)) {
+        EngineFrameStats st;
+        if (n == cap || !engine_get_stats(e, &st)) continue;
+        frame[n]  = st.frame_ms;
+        work[n]   = st.frame_ms - st.present_ms;
+        sim[n]    = st.input_ms + st.physics_ms;
+        render[n] = st.cull_ms + st.mesh_ms + st.upload_ms + st.draw_ms;
+        n++;
+    }
+    double wall = now_s() - t0;
+    engine_get_recording_stats(e, &rs);
+
+    printf("%s: %u ticks, %u edits, %.2f MB, %s\n", argv[1], rs.ticks, rs.edits, rs.bytes/1e6,
+           headless ? "headless" : "windowed");
+    printf("wall %.3f s, %.0f ticks/s\n", wall, wall > 0 ? rs.ticks/wall : 0.0);
+    if (n > 0) {
+        report("frame", frame, n);
+        report("work", work, n);
+        report("sim", sim, n);
+        if (!headless) report("render", render, n);
+    }
+    printf("divergences %u (max %.5f)\n", rs.divergences, rs.max_error);
+
+    free(frame); free(work); free(sim); free(render);
+    engine_destroy(e);
+    return rs.divergences ? 3 : 0;
+}
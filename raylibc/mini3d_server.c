@@ -0,0 +1,101 @@
+// mini3d_server.c — dedicated (headless) server: owns the world, no window.
+//
+//   ./mini3d_server [port] [sx sy sz] [tick_hz]      # defaults: 7777 256 64 256 60
+//
+// Generates rolling terrain, then serves the protocol on 127.0.0.1:port (and on
+// MINI3D_SOCKET if set). Clients subscribe to "world" to receive chunk snapshots
+// and per-tick block deltas, and edit with the usual set/fill/chunk commands;
+// clients that send input frames are players (see engine_connect).
+// Once a second it prints a metrics line on stderr: clients, snapshots still
+// streaming, bytes/s sent, and tick time percentiles. Stops on SIGINT/SIGTERM.
+// MINI3D_RECORD=session.m3r records the session (terrain, every client edit and
+// tick) for mini3d_replay --headless.
+#include "engine.h"
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static volatile sig_atomic_t g_stop = 0;
+static void on_signal(int sig) { (void)sig; g_stop = 1; }
+
+static int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static bool generate_terrain(Engine* e, int sx, int sy, int sz) {
+    uint16_t* col = (uint16_t*)calloc((size_t)sy, sizeof(uint16_t));
+    if (!col) return false;
+    for (int z=0; z<sz; z++)
+    for (int x=0; x<sx; x++) {
+        int h = (int)(sy*0.35f + 6*sinf(x*0.07f) + 5*cosf(z*0.05f) + 3*sinf((x+z)*0.11f));
+        if (h < 1) h = 1;
+        if (h > sy) h = sy;
+        for (int y=0; y<sy; y++) col[y] = y >= h ? 0 : y < h-4 ? 5 : y < h-1 ? 3 : 1;   // stone, dirt, grass
+        engine_write_region(e, x, 0, z, 1, sy, 1, col);
+    }
+    free(col);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 7777;
+    int sx   = argc > 4 ? atoi(argv[2]) : 256;
+    int sy   = argc > 4 ? atoi(argv[3]) : 64;
+    int sz   = argc > 4 ? atoi(argv[4]) : 256;
+    int hz   = argc > 5 ? atoi(argv[5]) : 60;
+    if (hz <= 0) hz = 60;
+
+    Engine* e = engine_create_headless(hz);
+    if (!e || !engine_create_world(e, sx, sy, sz)) { fprintf(stderr, "mini3d_server: bad world size\n"); return 1; }
+    if (!generate_terrain(e, sx, sy, sz)) {
+        fprintf(stderr, "mini3d_server: out of memory generating terrain\n");
+        engine_destroy(e);
+        return 1;
+    }
+    engine_set_camera_pose(e, sx*0.5f, sy*0.5f, sz*0.5f, 0, 0);   // where players spawn
+    if (!engine_start_tcp_server(e, NULL, port)) {
+        fprintf(stderr, "mini3d_server: cannot listen on 127.0.0.1:%d\n", port);
+        engine_destroy(e);
+        return 1;
+    }
+    const char* sock = getenv("MINI3D_SOCKET");
+    if (sock && !engine_start_socket_server(e, sock))
+        fprintf(stderr, "mini3d_server: could not listen on %s\n", sock);
+    const char* rec = getenv("MINI3D_RECORD");
+    if (rec && !engine_start_recording(e, rec))
+        fprintf(stderr, "mini3d_server: could not record to %s\n", rec);
+    EngineFrameStats* hist = (EngineFrameStats*)malloc((size_t)hz*sizeof(EngineFrameStats));
+    float* work = (float*)malloc((size_t)hz*sizeof(float));
+    if (!hist || !work) {
+        fprintf(stderr, "mini3d_server: out of memory for tick stats\n");
+        free(hist); free(work);
+        engine_destroy(e);
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    fprintf(stderr, "mini3d_server: listening on 127.0.0.1:%d, world %dx%dx%d, %d Hz\n", port, sx, sy, sz, hz);
+
+    uint64_t last_bytes = 0;
+    int ticks = 0;
+    while (!g_stop && engine_tick(e, 1.0f/hz)) {
+        if (++ticks % hz) continue;
+        // tick work = frame_ms minus the pacing sleep (present_ms), over the last second
+        int n = engine_get_stats_history(e, hist, hz);
+        if (n <= 0) continue;   // no ticks recorded yet: nothing to take percentiles of
+        for (int i=0;i<n;i++) work[i] = hist[i].frame_ms - hist[i].present_ms;
+        qsort(work, (size_t)n, sizeof(float), cmp_float);
+        EngineNetStats ns;
+        engine_get_net_stats(e, &ns);
+        fprintf(stderr, "clients %d (world %d, snapshot %d) | out %.2f MB/s | deltas %u/tick | "
+                        "tick work p50 %.2f p95 %.2f p99 %.2f max %.2f ms\n",
+                ns.clients, ns.world_clients, ns.snapshots_pending, (ns.bytes_total - last_bytes)/1e6,
+                ns.deltas_tick, work[n/2], work[n*95/100], work[n*99/100], work[n-1]);
+        last_bytes = ns.bytes_total;
+    }
+    free(hist); free(work);
+    engine_destroy(e);
+    return 0;
+}
@@ -0,0 +1,354 @@
+// mini3dmodule.c — CPython extension wrapping engine.h (`import mini3d`).
+//
+// A thinner, faster alternative to the ctypes declarations in test_client.py:
+// every method uses METH_FASTCALL (the vectorcall convention: arguments arrive
+// as a C array, no tuple is built) and bulk data goes through the buffer
+// protocol, so regions, edits and events move as flat memory:
+//
+//   eng = mini3d.Engine(1280, 720, "title", 60)
+//   buf = array.array("H", bytes(2*16*16*16))
+//   eng.read_region(0, 0, 0, 16, 16, 16, buf)    # fills buf in place
+//   eng.write_region(0, 0, 0, 16, 16, 16, buf)   # any uint16 buffer (numpy too)
+//
+// Build: see README ("Python extension module").
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "engine.h"
+
+typedef struct {
+    PyObject_HEAD
+    Engine* e;
+    int busy;                     // calls using e with the GIL released (changed under the GIL)
+} EngineObject;
+
+// ---- argument helpers ----
+
+static bool check_nargs(const char* name, Py_ssize_t nargs, Py_ssize_t want) {
+    if (nargs == want) return true;
+    PyErr_Format(PyExc_TypeError, "%s() takes %zd arguments (%zd given)", name, want, nargs);
+    return false;
+}
+
+// Convert args[0..n) to ints; false with an exception set on failure.
+static bool ints_from(PyObject* const* args, Py_ssize_t n, int* out) {
+    for (Py_ssize_t i=0;i<n;i++) {
+        long v = PyLong_AsLong(args[i]);
+        if (v == -1 && PyErr_Occurred()) return false;
+        if (v < INT_MIN || v > INT_MAX) {
+            PyErr_SetString(PyExc_OverflowError, "Python int too large to convert to C int");
+            return false;
+        }
+        out[i] = (int)v;
+    }
+    return true;
+}
+
+static Engine* live(EngineObject* self) {
+    if (!self->e) PyErr_SetString(PyExc_RuntimeError, "engine is closed");
+    return self->e;
+}
+
+// The engine can only go away while no other thread is inside it with the GIL
+// released. Dealloc never sees busy set: a call in flight holds a reference.
+static bool idle(EngineObject* self) {
+    if (!self->busy) return true;
+    PyErr_SetString(PyExc_RuntimeError, "engine is in use by another thread");
+    return false;
+}
+
+// Contiguous buffer of at least count items of itemsize bytes; plain byte buffers
+// (bytes, bytearray — what read_region returns) are taken as raw native memory.
+static bool get_buffer(PyObject* obj, Py_buffer* view, int flags, Py_ssize_t itemsize, Py_ssize_t count) {
+    if (PyObject_GetBuffer(obj, view, flags | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) return false;
+    if ((view->itemsize != itemsize && view->itemsize != 1) || view->len < itemsize*count) {
+        PyErr_Format(PyExc_ValueError, "buffer needs %zd items of %zd bytes (got %zd bytes, itemsize %zd)",
+                     count, itemsize, view->len, view->itemsize);
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+// Voxel count of a dx*dy*dz region, checked so the uint16 byte size fits a
+// Py_ssize_t: a wrapped product would let a short buffer pass get_buffer.
+static bool region_count(const int* d, Py_ssize_t* count) {
+    if (d[0] <= 0 || d[1] <= 0 || d[2] <= 0) { PyErr_SetString(PyExc_ValueError, "region size must be positive"); return false; }
+    Py_ssize_t n, bytes;
+    if (__builtin_mul_overflow((Py_ssize_t)d[0], (Py_ssize_t)d[1], &n) ||
+        __builtin_mul_overflow(n, (Py_ssize_t)d[2], &n) ||
+        __builtin_mul_overflow(n, (Py_ssize_t)sizeof(uint16_t), &bytes)) {
+        PyErr_SetString(PyExc_OverflowError, "region too large");
+        return false;
+    }
+    *count = n;
+    return true;
+}
+
+// ---- Engine type ----
+
+static int Engine_init(EngineObject* self, PyObject* args, PyObject* kw) {
+    int w = 1280, h = 720, fps = 60;
+    const char* title = "mini3d";
+    static char* kwlist[] = { "width", "height", "title", "fps", NULL };
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|iisi", kwlist, &w, &h, &title, &fps)) return -1;
+    if (!idle(self)) return -1;
+    if (self->e) engine_destroy(self->e);
+    self->e = engine_create(w, h, title, fps);
+    if (!self->e) { PyErr_SetString(PyExc_RuntimeError, "engine_create failed"); return -1; }
+    return 0;
+}
+
+static void Engine_dealloc(EngineObject* self) {
+    if (self->e) engine_destroy(self->e);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* Engine_close(EngineObject* self, PyObject* unused) {
+    (void)unused;
+    if (!idle(self)) return NULL;
+    if (self->e) { engine_destroy(self->e); self->e = NULL; }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Engine_tick(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    if (!e || !check_nargs("tick", nargs, 1)) return NULL;
+    double dt = PyFloat_AsDouble(args[0]);
+    if (dt == -1.0 && PyErr_Occurred()) return NULL;
+    return PyBool_FromLong(engine_tick(e, (float)dt));
+}
+
+static PyObject* Engine_load_atlas(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[3];
+    if (!e || !check_nargs("load_atlas", nargs, 4)) return NULL;
+    const char* path = PyUnicode_AsUTF8(args[0]);
+    if (!path || !ints_from(args+1, 3, v)) return NULL;
+    return PyBool_FromLong(engine_load_atlas(e, path, v[0], v[1], v[2]));
+}
+
+static PyObject* Engine_define_block_tile(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[2];
+    if (!e || !check_nargs("define_block_tile", nargs, 2) || !ints_from(args, 2, v)) return NULL;
+    return PyBool_FromLong(engine_define_block_tile(e, (uint16_t)v[0], v[1]));
+}
+
+static PyObject* Engine_create_world(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[3];
+    if (!e || !check_nargs("create_world", nargs, 3) || !ints_from(args, 3, v)) return NULL;
+    return PyBool_FromLong(engine_create_world(e, v[0], v[1], v[2]));
+}
+
+static PyObject* Engine_clear_world(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int id = 0;
+    if (!e || (nargs > 1 && !check_nargs("clear_world", nargs, 1))) return NULL;
+    if (nargs == 1 && !ints_from(args, 1, &id)) return NULL;
+    engine_clear_world(e, (uint16_t)id);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_block(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[4];
+    if (!e || !check_nargs("set_block", nargs, 4) || !ints_from(args, 4, v)) return NULL;
+    return PyBool_FromLong(engine_set_block(e, v[0], v[1], v[2], (uint16_t)v[3]));
+}
+
+static PyObject* Engine_get_block(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[3];
+    if (!e || !check_nargs("get_block", nargs, 3) || !ints_from(args, 3, v)) return NULL;
+    return PyLong_FromLong(engine_get_block(e, v[0], v[1], v[2]));
+}
+
+static PyObject* Engine_fill_box(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[7];
+    if (!e || !check_nargs("fill_box", nargs, 7) || !ints_from(args, 7, v)) return NULL;
+    engine_fill_box(e, v[0], v[1], v[2], v[3], v[4], v[5], (uint16_t)v[6]);
+    Py_RETURN_NONE;
+}
+
+// read_region(x0, y0, z0, dx, dy, dz[, out]) -> out, or a new bytearray of uint16
+static PyObject* Engine_read_region(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[6];
+    if (!e) return NULL;
+    if (nargs != 6 && nargs != 7) { check_nargs("read_region", nargs, 7); return NULL; }
+    Py_ssize_t n;
+    if (!ints_from(args, 6, v) || !region_count(v+3, &n)) return NULL;
+
+    if (nargs == 6) {
+        PyObject* out = PyByteArray_FromStringAndSize(NULL, n*2);
+        if (!out) return NULL;
+        uint16_t* buf = (uint16_t*)PyByteArray_AS_STRING(out);
+        self->busy++;
+        Py_BEGIN_ALLOW_THREADS      // lock-free reader: other threads may edit meanwhile
+        engine_read_region(e, v[0], v[1], v[2], v[3], v[4], v[5], buf);
+        Py_END_ALLOW_THREADS
+        self->busy--;
+        return out;
+    }
+    Py_buffer view;
+    if (!get_buffer(args[6], &view, PyBUF_WRITABLE, 2, n)) return NULL;
+    self->busy++;
+    Py_BEGIN_ALLOW_THREADS
+    engine_read_region(e, v[0], v[1], v[2], v[3], v[4], v[5], (uint16_t*)view.buf);
+    Py_END_ALLOW_THREADS
+    self->busy--;
+    PyBuffer_Release(&view);
+    Py_INCREF(args[6]);
+    return args[6];
+}
+
+// write_region(x0, y0, z0, dx, dy, dz, data) with data any buffer of uint16
+static PyObject* Engine_write_region(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    int v[6];
+    Py_ssize_t n;
+    if (!e || !check_nargs("write_region", nargs, 7) || !ints_from(args, 6, v) || !region_count(v+3, &n)) return NULL;
+    Py_buffer view;
+    if (!get_buffer(args[6], &view, PyBUF_SIMPLE, 2, n)) return NULL;
+    engine_write_region(e, v[0], v[1], v[2], v[3], v[4], v[5], (const uint16_t*)view.buf);
+    PyBuffer_Release(&view);
+    Py_RETURN_NONE;
+}
+
+// queue_edits(buf) -> count accepted; buf holds packed EngineEdit records (16 bytes each)
+static PyObject* Engine_queue_edits(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    if (!e || !check_nargs("queue_edits", nargs, 1)) return NULL;
+    Py_buffer view;
+    if (PyObject_GetBuffer(args[0], &view, PyBUF_SIMPLE) < 0) return NULL;
+    if (view.len % sizeof(EngineEdit)) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "edit buffer must be a multiple of %zu bytes", sizeof(EngineEdit));
+        return NULL;
+    }
+    int n;
+    self->busy++;
+    Py_BEGIN_ALLOW_THREADS      // the ring takes edits from another thread
+    n = engine_queue_edits(e, (const EngineEdit*)view.buf, (int)(view.len / sizeof(EngineEdit)));
+    Py_END_ALLOW_THREADS
+    self->busy--;
+    PyBuffer_Release(&view);
+    return PyLong_FromLong(n);
+}
+
+static PyObject* Engine_begin_edit(EngineObject* self, PyObject* unused) {
+    (void)unused;
+    Engine* e = live(self);
+    if (!e) return NULL;
+    engine_begin_edit(e);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Engine_commit_edit(EngineObject* self, PyObject* unused) {
+    (void)unused;
+    Engine* e = live(self);
+    if (!e) return NULL;
+    engine_commit_edit(e);
+    Py_RETURN_NONE;
+}
+
+// poll_events() -> list of (type, frame, code, x, y, z, yaw, pitch)
+static PyObject* Engine_poll_events(EngineObject* self, PyObject* unused) {
+    (void)unused;
+    Engine* e = live(self);
+    if (!e) return NULL;
+    EngineEvent buf[64];
+    PyObject* list = PyList_New(0);
+    if (!list) return NULL;
+    int n;
+    do {
+        n = engine_poll_events(e, buf, 64);
+        for (int i=0;i<n;i++) {
+            const EngineEvent* ev = &buf[i];
+            PyObject* t = Py_BuildValue("(IIifffff)", ev->type, ev->frame, ev->code,
+                                        ev->x, ev->y, ev->z, ev->yaw, ev->pitch);
+            if (!t || PyList_Append(list, t) < 0) { Py_XDECREF(t); Py_DECREF(list); return NULL; }
+            Py_DECREF(t);
+        }
+    } while (n == 64);
+    return list;
+}
+
+static PyObject* Engine_set_camera_pose(EngineObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Engine* e = live(self);
+    if (!e || !check_nargs("set_camera_pose", nargs, 5)) return NULL;
+    double v[5];
+    for (int i=0;i<5;i++) {
+        v[i] = PyFloat_AsDouble(args[i]);
+        if (v[i] == -1.0 && PyErr_Occurred()) return NULL;
+    }
+    engine_set_camera_pose(e, (float)v[0], (float)v[1], (float)v[2], (float)v[3], (float)v[4]);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Engine_get_camera_pose(EngineObject* self, PyObject* unused) {
+    (void)unused;
+    Engine* e = live(self);
+    if (!e) return NULL;
+    float x, y, z, yaw, pitch;
+    engine_get_camera_pose(e, &x, &y, &z, &yaw, &pitch);
+    return Py_BuildValue("(fffff)", x, y, z, yaw, pitch);
+}
+
+static PyMethodDef Engine_methods[] = {
+    { "close",             (PyCFunction)Engine_close,             METH_NOARGS,   "Destroy the engine and close the window." },
+    { "tick",              (PyCFunction)(void(*)(void))Engine_tick,              METH_FASTCALL, "tick(dt) -> False when the window wants to close" },
+    { "load_atlas",        (PyCFunction)(void(*)(void))Engine_load_atlas,        METH_FASTCALL, "load_atlas(path, tile_px, cols, rows) -> bool" },
+    { "define_block_tile", (PyCFunction)(void(*)(void))Engine_define_block_tile, METH_FASTCALL, "define_block_tile(block_id, tile_index) -> bool" },
+    { "create_world",      (PyCFunction)(void(*)(void))Engine_create_world,      METH_FASTCALL, "create_world(sx, sy, sz) -> bool" },
+    { "clear_world",       (PyCFunction)(void(*)(void))Engine_clear_world,       METH_FASTCALL, "clear_world([block_id])" },
+    { "set_block",         (PyCFunction)(void(*)(void))Engine_set_block,         METH_FASTCALL, "set_block(x, y, z, id) -> bool" },
+    { "get_block",         (PyCFunction)(void(*)(void))Engine_get_block,         METH_FASTCALL, "get_block(x, y, z) -> id" },
+    { "fill_box",          (PyCFunction)(void(*)(void))Engine_fill_box,          METH_FASTCALL, "fill_box(x0, y0, z0, x1, y1, z1, id)" },
+    { "read_region",       (PyCFunction)(void(*)(void))Engine_read_region,       METH_FASTCALL, "read_region(x0, y0, z0, dx, dy, dz[, out]) -> uint16 buffer, x fastest" },
+    { "write_region",      (PyCFunction)(void(*)(void))Engine_write_region,      METH_FASTCALL, "write_region(x0, y0, z0, dx, dy, dz, data) from a uint16 buffer" },
+    { "queue_edits",       (PyCFunction)(void(*)(void))Engine_queue_edits,       METH_FASTCALL, "queue_edits(buf) -> accepted; packed (i32 x, y, z, u16 id, u16 pad) records" },
+    { "begin_edit",        (PyCFunction)Engine_begin_edit,        METH_NOARGS,   "begin_edit(): collect dirty chunks until commit_edit" },
+    { "commit_edit",       (PyCFunction)Engine_commit_edit,       METH_NOARGS,   "commit_edit(): mark the batch's chunks for remeshing once" },
+    { "poll_events",       (PyCFunction)Engine_poll_events,       METH_NOARGS,   "poll_events() -> [(type, frame, code, x, y, z, yaw, pitch)]" },
+    { "set_camera_pose",   (PyCFunction)(void(*)(void))Engine_set_camera_pose,   METH_FASTCALL, "set_camera_pose(x, y, z, yaw, pitch)" },
+    { "get_camera_pose",   (PyCFunction)Engine_get_camera_pose,   METH_NOARGS,   "get_camera_pose() -> (x, y, z, yaw, pitch)" },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject EngineType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name      = "mini3d.Engine",
+    .tp_basicsize = sizeof(EngineObject),
+    .tp_flags     = Py_TPFLAGS_DEFAULT,
+    .tp_doc       = "Engine(width=1280, height=720, title='mini3d', fps=60)",
+    .tp_new       = PyType_GenericNew,
+    .tp_init      = (initproc)Engine_init,
+    .tp_dealloc   = (destructor)Engine_dealloc,
+    .tp_methods   = Engine_methods,
+};
+
+static struct PyModuleDef mini3d_module = {
+    PyModuleDef_HEAD_INIT, "mini3d", "mini3d voxel engine (C extension over engine.h)", -1, NULL,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_mini3d(void) {
+    if (PyType_Ready(&EngineType) < 0) return NULL;
+    PyObject* m = PyModule_Create(&mini3d_module);
+    if (!m) return NULL;
+    Py_INCREF(&EngineType);
+    if (PyModule_AddObject(m, "Engine", (PyObject*)&EngineType) < 0) {
+        Py_DECREF(&EngineType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    PyModule_AddIntConstant(m, "EVENT_KEY_DOWN",   ENGINE_EVENT_KEY_DOWN);
+    PyModule_AddIntConstant(m, "EVENT_KEY_UP",     ENGINE_EVENT_KEY_UP);
+    PyModule_AddIntConstant(m, "EVENT_MOUSE_DOWN", ENGINE_EVENT_MOUSE_DOWN);
+    PyModule_AddIntConstant(m, "EVENT_MOUSE_UP",   ENGINE_EVENT_MOUSE_UP);
+    PyModule_AddIntConstant(m, "EVENT_PLAYER",     ENGINE_EVENT_PLAYER);
+    return m;
+}
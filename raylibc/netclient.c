@@ -0,0 +1,392 @@
+// netclient.c — join a dedicated server (mini3d_server) as a player.
+//
+// The server owns the world and this player's position (sockserver.c). This side:
+//   - keeps a local copy of the world from the replication frames (world, chunk,
+//     tick, unload), applied at the start of engine_tick like any other edit;
+//   - sends every tick's input as {seq, keys, yaw, pitch, dt} and moves the camera
+//     with it in the same tick (prediction: the same player_step the server runs);
+//   - remembers each unacknowledged input with the state it led to. The server
+//     answers once per tick with the state after the newest input it applied; if
+//     that differs from our prediction for the same input, we take the server's
+//     state and replay the inputs it has not seen yet on top (reconciliation).
+// Controls therefore answer in the frame they are pressed whatever the round trip
+// and still converge to the server. engine_set_net_latency delays both directions
+// in-process, so 100 ms RTT can be tried over loopback.
+#define _POSIX_C_SOURCE 200809L
+#include "engine_internal.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <math.h>
+
+#define PREDICT_MAX      1024          // unacknowledged inputs kept (~17 s at 60 Hz)
+#define MAX_ENTITIES     256
+#define PREDICT_EPSILON  1e-3f         // same code on both ends: any real mismatch is far larger
+#define FRAME_WORLD      0x81          // server -> client frames, see sockserver.c
+#define FRAME_CHUNK      0x82
+#define FRAME_TICK       0x83
+#define FRAME_UNLOAD     0x84
+#define FRAME_ENTITIES   0x85
+#define FRAME_ACK        0x86
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+typedef struct Packet {               // bytes held back by the simulated latency
+    struct Packet* next;
+    double due;
+    size_t len;
+    uint8_t data[];
+} Packet;
+
+typedef struct { Packet *head, *tail; } DelayQueue;
+
+typedef struct {
+    uint32_t seq;
+    uint8_t  keys;
+    float    yaw, pitch, dt;
+    double   sent;                     // stats_now() when sent, for the RTT
+    PlayerState after;                 // predicted state after this input
+} PendingInput;
+
+struct NetClient {
+    int fd;
+    bool closed;
+    double delay;                      // simulated one-way latency, seconds
+    DelayQueue out_q, in_q;
+    uint8_t* out; size_t out_len, out_cap;   // due bytes the socket did not take yet
+    uint8_t* in;  size_t in_len, in_cap;     // delivered bytes not parsed yet
+
+    PendingInput pend[PREDICT_MAX];    // ring, oldest first
+    int pend_head, pend_len;
+    uint32_t next_seq;
+    bool spawned;                      // first ack seen
+
+    struct { uint32_t id; float pos[3]; } ents[MAX_ENTITIES];
+    int nents;
+    uint16_t chunk[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    EnginePredictionStats stats;
+};
+
+// False when out of memory: the stream has a hole, so the caller closes the connection.
+static bool buf_append(uint8_t** b, size_t* len, size_t* cap, const void* data, size_t n) {
+    if (*len + n > *cap) {
+        size_t grown_cap = (*len + n)*2;
+        uint8_t* grown = (uint8_t*)realloc(*b, grown_cap);
+        if (!grown) return false;
+        *b = grown; *cap = grown_cap;
+    }
+    memcpy(*b + *len, data, n);
+    *len += n;
+    return true;
+}
+
+static bool queue_push(DelayQueue* q, double due, const void* data, size_t n) {
+    Packet* p = (Packet*)malloc(sizeof(Packet) + n);
+    if (!p) return false;
+    p->next = NULL; p->due = due; p->len = n;
+    memcpy(p->data, data, n);
+    if (q->tail) q->tail->next = p; else q->head = p;
+    q->tail = p;
+    return true;
+}
+
+// Move packets that are due into b. False when out of memory.
+static bool queue_deliver(DelayQueue* q, double now, uint8_t** b, size_t* len, size_t* cap) {
+    while (q->head && q->head->due <= now) {
+        Packet* p = q->head;
+        if (!buf_append(b, len, cap, p->data, p->len)) return false;
+        q->head = p->next;
+        if (!q->head) q->tail = NULL;
+        free(p);
+    }
+    return true;
+}
+
+static void queue_free(DelayQueue* q) {
+    while (q->head) { Packet* p = q->head; q->head = p->next; free(p); }
+    q->tail = NULL;
+}
+
+static void net_send(NetClient* n, const void* data, size_t len) {
+    bool ok = n->delay > 0 ? queue_push(&n->out_q, stats_now() + n->delay, data, len)
+                           : buf_append(&n->out, &n->out_len, &n->out_cap, data, len);
+    if (!ok) n->closed = true;
+}
+
+static void net_flush(NetClient* n) {
+    size_t sent = 0;
+    while (sent < n->out_len && !n->closed) {
+        ssize_t w = send(n->fd, n->out + sent, n->out_len - sent, SEND_FLAGS);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) n->closed = true;
+            break;
+        }
+        sent += (size_t)w;
+    }
+    if (!sent) return;
+    memmove(n->out, n->out + sent, n->out_len - sent);
+    n->out_len -= sent;
+}
+
+static inline int32_t rd_i32(const uint8_t* p) { int32_t v; memcpy(&v, p, 4); return v; }
+static inline float rd_f32(const uint8_t* p) { float v; memcpy(&v, p, 4); return v; }
+
+static void set_player(Engine* e, PlayerState p) {
+    e->cam.position = p.pos;
+    e->velY = p.vel_y;
+}
+
+// Server state after input `seq`: drop what it acknowledged, and if it disagrees
+// with what we predicted for that input, start from its state and replay the rest.
+static void on_ack(Engine* e, NetClient* n, uint32_t seq, PlayerState srv) {
+    PlayerState pred = srv;
+    bool have = false;
+    while (n->pend_len && (int32_t)(n->pend[n->pend_head].seq - seq) <= 0) {
+        PendingInput* in = &n->pend[n->pend_head];
+        if (in->seq == seq) {
+            pred = in->after;
+            have = true;
+            n->stats.rtt_ms = (float)((stats_now() - in->sent)*1000.0);
+        }
+        n->pend_head = (n->pend_head + 1) % PREDICT_MAX;
+        n->pend_len--;
+    }
+    n->stats.inputs_pending = (uint32_t)n->pend_len;
+    float err = Vector3Distance(pred.pos, srv.pos);
+    if (have && n->spawned && err <= PREDICT_EPSILON && fabsf(pred.vel_y - srv.vel_y) <= PREDICT_EPSILON) return;
+
+    if (n->spawned) {
+        n->stats.corrections++;
+        n->stats.last_error = err;
+    }
+    n->spawned = true;
+    PlayerState p = srv;
+    for (int i=0; i<n->pend_len; i++) {
+        PendingInput* in = &n->pend[(n->pend_head + i) % PREDICT_MAX];
+        player_step(e, &p, in->keys, in->yaw, in->pitch, in->dt);
+        in->after = p;
+    }
+    set_player(e, p);
+}
+
+// Expand a chunk frame's (count, id) runs and write them into the local world.
+static void on_chunk(Engine* e, NetClient* n, const uint8_t* p, uint32_t len) {
+    const World* w = &e->world;
+    if (len < 12 || !w->v) return;
+    // chunk coordinates come from the server: scaled in 64 bits, range-checked before narrowing
+    int64_t ox = (int64_t)rd_i32(p)*CHUNK_SIZE, oy = (int64_t)rd_i32(p + 4)*CHUNK_SIZE, oz = (int64_t)rd_i32(p + 8)*CHUNK_SIZE;
+    if (ox < 0 || oy < 0 || oz < 0 || ox >= w->sx || oy >= w->sy || oz >= w->sz) return;
+    int x0 = (int)ox, y0 = (int)oy, z0 = (int)oz;
+    int dx = w->sx - x0 < CHUNK_SIZE ? w->sx - x0 : CHUNK_SIZE;
+    int dy = w->sy - y0 < CHUNK_SIZE ? w->sy - y0 : CHUNK_SIZE;
+    int dz = w->sz - z0 < CHUNK_SIZE ? w->sz - z0 : CHUNK_SIZE;
+    int total = dx*dy*dz, at = 0;
+    for (uint32_t k=12; k+4<=len && at<total; k+=4) {
+        int cnt = p[k] | p[k+1]<<8;
+        uint16_t id = (uint16_t)(p[k+2] | p[k+3]<<8);
+        if (cnt > total - at) cnt = total - at;
+        for (int i=0;i<cnt;i++) n->chunk[at++] = id;
+    }
+    if (at == total) engine_write_region(e, x0, y0, z0, dx, dy, dz, n->chunk);
+}
+
+static void on_frame(Engine* e, NetClient* n, uint8_t op, const uint8_t* p, uint32_t len) {
+    switch (op) {
+        case FRAME_WORLD:
+            if (len >= 12) engine_create_world(e, rd_i32(p), rd_i32(p + 4), rd_i32(p + 8));
+            break;
+        case FRAME_CHUNK:
+            on_chunk(e, n, p, len);
+            break;
+        case FRAME_TICK: {
+            uint32_t cnt = len >= 12 ? (uint32_t)rd_i32(p + 8) : 0;
+            for (uint32_t k=0; k<cnt && 12 + 14*(k+1) <= len; k++) {
+                const uint8_t* r = p + 12 + 14*k;
+                engine_set_block(e, rd_i32(r), rd_i32(r + 4), rd_i32(r + 8), (uint16_t)(r[12] | r[13]<<8));
+            }
+            break;
+        }
+        case FRAME_UNLOAD: {
+            uint32_t cnt = len >= 4 ? (uint32_t)rd_i32(p) : 0;
+            for (uint32_t k=0; k<cnt && 4 + 12*(k+1) <= len; k++) {
+                const uint8_t* r = p + 4 + 12*k;
+                int64_t x = (int64_t)rd_i32(r)*CHUNK_SIZE, y = (int64_t)rd_i32(r + 4)*CHUNK_SIZE, z = (int64_t)rd_i32(r + 8)*CHUNK_SIZE;
+                if (x < 0 || y < 0 || z < 0 || x >= e->world.sx || y >= e->world.sy || z >= e->world.sz) continue;
+                engine_fill_box(e, (int)x, (int)y, (int)z, (int)x + CHUNK_SIZE-1, (int)y + CHUNK_SIZE-1, (int)z + CHUNK_SIZE-1, 0);
+            }
+            break;
+        }
+        case FRAME_ENTITIES: {
+            uint32_t cnt = len >= 12 ? (uint32_t)rd_i32(p + 8) : 0;
+            n->nents = 0;
+            for (uint32_t k=0; k<cnt && n->nents < MAX_ENTITIES && 12 + 16*(k+1) <= len; k++) {
+                const uint8_t* r = p + 12 + 16*k;
+                n->ents[n->nents].id = (uint32_t)rd_i32(r);
+                for (int i=0;i<3;i++) n->ents[n->nents].pos[i] = rd_f32(r + 4 + 4*i);
+                n->nents++;
+            }
+            break;
+        }
+        case FRAME_ACK:
+            if (len >= 20) {
+                PlayerState srv = { (Vector3){ rd_f32(p + 4), rd_f32(p + 8), rd_f32(p + 12) }, rd_f32(p + 16) };
+                on_ack(e, n, (uint32_t)rd_i32(p), srv);
+            }
+            break;
+        default: break;   // newer server: skip
+    }
+}
+
+void netclient_poll(Engine* e) {
+    NetClient* n = e->net;
+    if (!n) return;
+    double now = stats_now();
+    if (!queue_deliver(&n->out_q, now, &n->out, &n->out_len, &n->out_cap)) n->closed = true;
+    net_flush(n);
+
+    uint8_t tmp[1<<16];
+    while (!n->closed) {
+        ssize_t r = recv(n->fd, tmp, sizeof tmp, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) n->closed = true;
+            break;
+        }
+        if (r == 0) { n->closed = true; break; }
+        bool ok = n->delay > 0 ? queue_push(&n->in_q, now + n->delay, tmp, (size_t)r)
+                               : buf_append(&n->in, &n->in_len, &n->in_cap, tmp, (size_t)r);
+        if (!ok) n->closed = true;   // out of memory: a frame is lost, the stream can't be trusted
+    }
+    if (!queue_deliver(&n->in_q, now, &n->in, &n->in_len, &n->in_cap)) n->closed = true;
+
+    size_t i = 0;
+    while (i < n->in_len) {
+        if (n->in[i] != 0xFF) {        // JSON line (an error reply): skip it
+            uint8_t* nl = (uint8_t*)memchr(n->in + i, '\n', n->in_len - i);
+            if (!nl) break;
+            i = (size_t)(nl - n->in) + 1;
+            continue;
+        }
+        if (n->in_len - i < 6) break;
+        uint32_t len = (uint32_t)rd_i32(n->in + i + 2);
+        if (n->in_len - i < 6 + (size_t)len) break;
+        on_frame(e, n, n->in[i+1], n->in + i + 6, len);
+        i += 6 + len;
+    }
+    if (!i) return;
+    memmove(n->in, n->in + i, n->in_len - i);
+    n->in_len -= i;
+}
+
+void netclient_send_input(Engine* e, float dt) {
+    NetClient* n = e->net;
+    if (!n || n->closed) return;
+    if (n->pend_len == PREDICT_MAX) {   // server stopped answering: forget the oldest
+        n->pend_head = (n->pend_head + 1) % PREDICT_MAX;
+        n->pend_len--;
+    }
+    PendingInput* in = &n->pend[(n->pend_head + n->pend_len++) % PREDICT_MAX];
+    in->seq = ++n->next_seq;
+    in->keys = e->in.keys;
+    in->yaw = e->yaw; in->pitch = e->pitch; in->dt = player_input_dt(dt);   // as step_physics did
+    in->sent = stats_now();
+    in->after = (PlayerState){ e->cam.position, e->velY };
+
+    uint8_t f[6 + 17];
+    uint32_t len = 17;
+    f[0] = 0xFF; f[1] = WIRE_OP_INPUT;
+    memcpy(f + 2, &len, 4);
+    memcpy(f + 6, &in->seq, 4);
+    f[10] = in->keys;
+    memcpy(f + 11, &in->yaw, 4); memcpy(f + 15, &in->pitch, 4); memcpy(f + 19, &in->dt, 4);
+    net_send(n, f, sizeof f);
+    n->stats.inputs_sent++;
+    n->stats.inputs_pending = (uint32_t)n->pend_len;
+    if (n->delay <= 0) net_flush(n);   // don't wait a tick for the next poll
+}
+
+int netclient_players(Engine* e, ViewPlayer* out, int max) {
+    NetClient* n = e->net;
+    if (!n) return 0;
+    int k = n->nents < max ? n->nents : max;
+    for (int i=0;i<k;i++) {
+        out[i].id = n->ents[i].id;
+        memcpy(out[i].pos, n->ents[i].pos, sizeof out[i].pos);
+    }
+    return k;
+}
+
+bool engine_connect(Engine* e, const char* host, int port, int view_radius) {
+    if (!e || e->net || port <= 0 || port > 65535) return false;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host ? host : "127.0.0.1", &addr.sin_addr) != 1) return false;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof addr) != 0) { close(fd); return false; }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);   // one small input frame per tick
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    NetClient* n = (NetClient*)calloc(1, sizeof(NetClient));
+    if (!n) { close(fd); return false; }
+    n->fd = fd;
+    e->net = n;
+    char hello[160];
+    int len = snprintf(hello, sizeof hello, "{\"op\":\"subscribe\",\"events\":[\"world\"]}\n"
+                       "{\"op\":\"view\",\"pos\":[%.2f,%.2f,%.2f],\"radius\":%d}\n",
+                       e->cam.position.x, e->cam.position.y, e->cam.position.z, view_radius > 0 ? view_radius : 0);
+    net_send(n, hello, (size_t)len);
+    net_flush(n);
+    return true;
+}
+
+void engine_disconnect(Engine* e) {
+    if (!e || !e->net) return;
+    NetClient* n = e->net;
+    close(n->fd);
+    queue_free(&n->out_q); queue_free(&n->in_q);
+    free(n->out); free(n->in);
+    free(n);
+    e->net = NULL;
+}
+
+void engine_set_net_latency(Engine* e, float rtt_ms) {
+    if (e && e->net) e->net->delay = rtt_ms > 0 ? rtt_ms*0.0005 : 0;   // half each way
+}
+
+bool engine_get_prediction_stats(Engine* e, EnginePredictionStats* out) {
+    if (!e || !out || !e->net) return false;
+    *out = e->net->stats;
+    out->connected = !e->net->closed;
+    out->entities = e->net->nents;
+    return true;
+}
+
+#else  // _WIN32: no client sockets here yet
+
+void netclient_poll(Engine* e) { (void)e; }
+void netclient_send_input(Engine* e, float dt) { (void)e; (void)dt; }
+int  netclient_players(Engine* e, ViewPlayer* out, int max) { (void)e; (void)out; (void)max; return 0; }
+bool engine_connect(Engine* e, const char* host, int port, int view_radius) { (void)e; (void)host; (void)port; (void)view_radius; return false; }
+void engine_disconnect(Engine* e) { (void)e; }
+void engine_set_net_latency(Engine* e, float rtt_ms) { (void)e; (void)rtt_ms; }
+bool engine_get_prediction_stats(Engine* e, EnginePredictionStats* out) { (void)e; (void)out; return false; }
+
+#endif
@@ -0,0 +1,181 @@
+// occlusion.c — software occlusion culling against a coarse CPU depth buffer.
+//
+// Each frame the solid base of the nearest chunks (the bottom occ_h layers that
+// are completely filled — whole chunks underground, the ground slab under
+// terrain) is rasterized as a box into a small depth buffer. The buffer is
+// conservative: a pixel only takes a box that covers all of it, at the farthest
+// depth the box has inside it. Every visible chunk AABB is then projected; if all
+// the buffer pixels it touches hold a nearer occluder, the chunk is dropped
+// before meshing/drawing.
+#include "engine_internal.h"
+#include <math.h>
+
+#define OCC_MAX_OCCLUDERS 96
+#define OCC_NEAR_W 0.1f         // boxes reaching closer than this are not projected
+
+// Height of the completely solid base of chunk ci (0..CHUNK_SIZE).
+static uint8_t chunk_solid_base(const World* w, int ci) {
+    int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+    int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+    int x1 = x0+CHUNK_SIZE, y1 = y0+CHUNK_SIZE, z1 = z0+CHUNK_SIZE;
+    if (x1 > w->sx || z1 > w->sz) return 0;   // partial chunks don't occlude
+    if (y1 > w->sy) y1 = w->sy;
+    for (int y=y0; y<y1; y++)
+        for (int z=z0; z<z1; z++) {
+            const uint16_t* row = &w->v[idx3D(w,x0,y,z)];
+            for (int x=0; x<CHUNK_SIZE; x++) if (!row[x]) return (uint8_t)(y-y0);
+        }
+    return (uint8_t)(y1-y0);
+}
+
+typedef struct { float x, y, iw; } ScreenPt;   // pixel coords + 1/w
+
+// Project a world point; false when it is behind (or too close to) the camera.
+static bool project(const Matrix* m, Vector3 p, ScreenPt* out) {
+    float cx = m->m0*p.x + m->m4*p.y + m->m8*p.z  + m->m12;
+    float cy = m->m1*p.x + m->m5*p.y + m->m9*p.z  + m->m13;
+    float cw = m->m3*p.x + m->m7*p.y + m->m11*p.z + m->m15;
+    if (cw < OCC_NEAR_W) return false;
+    float iw = 1.0f/cw;
+    out->x  = (cx*iw*0.5f + 0.5f) * OCC_W;
+    out->y  = (0.5f - cy*iw*0.5f) * OCC_H;
+    out->iw = iw;
+    return true;
+}
+
+static inline float edge(const ScreenPt* a, const ScreenPt* b, float px, float py) {
+    return (b->x - a->x)*(py - a->y) - (b->y - a->y)*(px - a->x);
+}
+
+#define OCC_CW (OCC_W+1)          // pixel corners per row
+
+// Rasterize one triangle into the pixel corner grid, keeping the nearest 1/w per
+// corner. Corners on an edge count as inside, so the faces of a box leave no
+// gaps between them.
+static void raster_tri(float* corner, ScreenPt a, ScreenPt b, ScreenPt c) {
+    float area = edge(&a, &b, c.x, c.y);
+    if (fabsf(area) < 1e-6f) return;
+    if (area < 0) { ScreenPt t = b; b = c; c = t; area = -area; }
+    int minx = (int)ceilf(fminf(a.x, fminf(b.x, c.x))),  maxx = (int)floorf(fmaxf(a.x, fmaxf(b.x, c.x)));
+    int miny = (int)ceilf(fminf(a.y, fminf(b.y, c.y))),  maxy = (int)floorf(fmaxf(a.y, fmaxf(b.y, c.y)));
+    if (minx < 0) minx = 0;
+    if (miny < 0) miny = 0;
+    if (maxx > OCC_W) maxx = OCC_W;
+    if (maxy > OCC_H) maxy = OCC_H;
+    float inv = 1.0f/area;
+    float dx0 = c.y - b.y, dx1 = a.y - c.y, dx2 = b.y - a.y;   // edge steps per corner along x
+    for (int y=miny; y<=maxy; y++) {
+        float w0 = edge(&b, &c, minx, y), w1 = edge(&c, &a, minx, y), w2 = edge(&a, &b, minx, y);
+        float* d = &corner[y*OCC_CW];
+        for (int x=minx; x<=maxx; x++, w0 -= dx0, w1 -= dx1, w2 -= dx2) {
+            if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+            float iw = (w0*a.iw + w1*b.iw + w2*c.iw) * inv;  // 1/w is linear in screen space
+            if (iw > d[x]) d[x] = iw;
+        }
+    }
+}
+
+static void box_corners(Vector3 lo, Vector3 hi, Vector3 out[8]) {
+    for (int i=0;i<8;i++)
+        out[i] = (Vector3){ (i&1) ? hi.x : lo.x, (i&2) ? hi.y : lo.y, (i&4) ? hi.z : lo.z };
+}
+
+// The box covers a pixel when it covers its four corners (both are convex), and
+// its near surface is convex too, so the farthest point of it over the pixel is
+// at one of the corners: the pixel takes the smallest corner 1/w.
+static void raster_box(float* depth, float* corner, const Matrix* m, Vector3 lo, Vector3 hi) {
+    static const int kTri[12][3] = {
+        {0,1,3},{0,3,2}, {4,6,7},{4,7,5}, {0,4,5},{0,5,1},
+        {2,3,7},{2,7,6}, {0,2,6},{0,6,4}, {1,5,7},{1,7,3},
+    };
+    Vector3 c[8]; ScreenPt s[8];
+    box_corners(lo, hi, c);
+    float minx = 1e30f, miny = 1e30f, maxx = -1e30f, maxy = -1e30f;
+    for (int i=0;i<8;i++) {
+        if (!project(m, c[i], &s[i])) return;
+        minx = fminf(minx, s[i].x); maxx = fmaxf(maxx, s[i].x);
+        miny = fminf(miny, s[i].y); maxy = fmaxf(maxy, s[i].y);
+    }
+    int x0 = (int)floorf(minx), x1 = (int)ceilf(maxx);
+    int y0 = (int)floorf(miny), y1 = (int)ceilf(maxy);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCC_W) x1 = OCC_W;
+    if (y1 > OCC_H) y1 = OCC_H;
+    if (x0 >= x1 || y0 >= y1) return;
+    for (int y=y0; y<=y1; y++) memset(&corner[y*OCC_CW + x0], 0, (x1-x0+1)*sizeof(float));
+    for (int t=0;t<12;t++) raster_tri(corner, s[kTri[t][0]], s[kTri[t][1]], s[kTri[t][2]]);
+    for (int y=y0; y<y1; y++)
+        for (int x=x0; x<x1; x++) {
+            const float* k = &corner[y*OCC_CW + x];
+            float iw = fminf(fminf(k[0], k[1]), fminf(k[OCC_CW], k[OCC_CW+1]));   // 0 when one is outside
+            float* d = &depth[y*OCC_W + x];
+            if (iw > *d) *d = iw;
+        }
+}
+
+// True when the whole screen footprint of the box lies behind occluders.
+static bool box_occluded(const float* depth, const Matrix* m, Vector3 lo, Vector3 hi) {
+    Vector3 c[8];
+    box_corners(lo, hi, c);
+    float minx = 1e30f, miny = 1e30f, maxx = -1e30f, maxy = -1e30f, near_iw = 0;
+    for (int i=0;i<8;i++) {
+        ScreenPt s;
+        if (!project(m, c[i], &s)) return false;
+        if (s.x < minx) minx = s.x;
+        if (s.x > maxx) maxx = s.x;
+        if (s.y < miny) miny = s.y;
+        if (s.y > maxy) maxy = s.y;
+        if (s.iw > near_iw) near_iw = s.iw;
+    }
+    int x0 = (int)floorf(minx), x1 = (int)ceilf(maxx);
+    int y0 = (int)floorf(miny), y1 = (int)ceilf(maxy);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCC_W) x1 = OCC_W;
+    if (y1 > OCC_H) y1 = OCC_H;
+    if (x0 >= x1 || y0 >= y1) return false;   // off screen: leave it to the frustum test
+    near_iw *= 1.0001f;                         // a chunk never hides behind its own base
+    for (int y=y0; y<y1; y++)
+        for (int x=x0; x<x1; x++) if (depth[y*OCC_W + x] <= near_iw) return false;
+    return true;
+}
+
+int occlusion_cull(Engine* e, int nvis) {
+    World* w = &e->world;
+    if (!e->occ_depth) e->occ_depth = (float*)malloc(OCC_W*OCC_H*sizeof(float));
+    if (!e->occ_corner) e->occ_corner = (float*)malloc(OCC_CW*(OCC_H+1)*sizeof(float));
+    if (!e->occ_depth || !e->occ_corner) return nvis;
+    memset(e->occ_depth, 0, OCC_W*OCC_H*sizeof(float));
+    Matrix m = camera_view_proj(e);
+
+    // 1) occluders: solid bases of the nearest chunks (e->vis is sorted near -> far)
+    int noccl = 0;
+    for (int i=0; i<nvis && noccl<OCC_MAX_OCCLUDERS; i++) {
+        int ci = e->vis[i].ci;
+        Chunk* c = &w->chunks[ci];
+        if (c->stale & CHUNK_OCCLUDER_BIT) {
+            c->stale &= (uint8_t)~CHUNK_OCCLUDER_BIT;   // first: an edit landing while it reads marks it again
+            c->occ_h = chunk_solid_base(w, ci);
+        }
+        if (c->occ_h < 2) continue;   // thin slabs rarely hide anything
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        Vector3 lo = { cx*CHUNK_SIZE-0.5f, cy*CHUNK_SIZE-0.5f, cz*CHUNK_SIZE-0.5f };
+        Vector3 hi = { lo.x+CHUNK_SIZE, lo.y+c->occ_h, lo.z+CHUNK_SIZE };
+        raster_box(e->occ_depth, e->occ_corner, &m, lo, hi);
+        noccl++;
+    }
+    if (!noccl) return nvis;
+
+    // 2) test every candidate's AABB, keep the survivors in order
+    int kept = 0;
+    for (int i=0;i<nvis;i++) {
+        int ci = e->vis[i].ci;
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        Vector3 lo = { cx*CHUNK_SIZE-0.5f, cy*CHUNK_SIZE-0.5f, cz*CHUNK_SIZE-0.5f };
+        Vector3 hi = { lo.x+CHUNK_SIZE, lo.y+CHUNK_SIZE, lo.z+CHUNK_SIZE };
+        if (box_occluded(e->occ_depth, &m, lo, hi)) { e->chunks_occluded++; continue; }
+        e->vis[kept++] = e->vis[i];
+    }
+    return kept;
+}
@@ -0,0 +1,353 @@
+// replay.c — session recording and deterministic replay.
+//
+// A recording is everything that moves the simulation, in tick order: each
+// tick's dt and input (keys, look angles, renderer) plus the camera position
+// physics produced, and every world edit between ticks whatever its source
+// (API, command server, sockets, edit ring, shm, replication). Edits come from
+// the change feed hooks, so nothing else needs to know recording exists.
+// Replaying applies the same edits and input through the same tick, with
+// process_input skipped and no frame pacing, so two builds can be
+// timed on the identical session; the recorded positions check determinism.
+//
+// File layout, little-endian, no padding:
+//   header  "M3RP" u32 version f32 x,y,z,yaw,pitch,vel_y i32 render_mode
+//   records u8 tag + payload:
+//     TICK   f32 dt u8 keys u8 render_mode f32 yaw,pitch f32 x,y,z (after physics)
+//     WORLD  i32 sx,sy,sz                          engine_create_world
+//     BLOCK  i32 x,y,z u16 id
+//     FILL   i32 x0,y0,z0,x1,y1,z1 u16 id          inclusive box of one id
+//     REGION i32 x0,y0,z0,dx,dy,dz u32 nruns, nruns x (u16 count, u16 id)
+//                                                  box contents, x fastest
+//     CAMERA f32 x,y,z,yaw,pitch                   engine_set_camera_pose
+// Starting a recording writes the current world as WORLD + REGION first.
+#include "engine_internal.h"
+#include <stdio.h>
+#include <math.h>
+
+#define REPLAY_MAGIC   0x5052334Du   // "M3RP"
+#define REPLAY_VERSION 1u
+#define REPLAY_HEADER  36
+#define REPLAY_EPSILON 1e-4f         // camera drift that counts as a divergence
+
+enum { REC_TICK = 1, REC_WORLD, REC_BLOCK, REC_FILL, REC_REGION, REC_CAMERA };
+
+struct Recorder {
+    FILE*     f;
+    uint32_t* runs;       // REGION scratch: (count, id) pairs packed in u32
+    size_t    runs_cap;
+    uint32_t  ticks, edits;
+    uint64_t  bytes;
+};
+
+struct Replayer {
+    uint8_t*  data;       // the whole log
+    size_t    len, at;
+    uint16_t* scratch;    // REGION decode buffer
+    size_t    scratch_cap;
+    Vector3   expect;     // camera position the log has after this tick's physics
+    uint32_t  ticks, ticks_total, edits, divergences;
+    float     max_error;
+};
+
+// ---------- recording ----------
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); return p + 4; }
+static uint8_t* put_i32(uint8_t* p, int32_t v)  { memcpy(p, &v, 4); return p + 4; }
+static uint8_t* put_f32(uint8_t* p, float v)    { memcpy(p, &v, 4); return p + 4; }
+static uint8_t* put_u16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); return p + 2; }
+
+static void rec_write(Recorder* r, const uint8_t* p, size_t n) {
+    fwrite(p, 1, n, r->f);
+    r->bytes += n;
+}
+
+// Grow the REGION scratch to hold run n. False when out of memory.
+static bool runs_reserve(Recorder* r, size_t n) {
+    if (n < r->runs_cap) return true;
+    size_t cap = r->runs_cap ? r->runs_cap*2 : 4096;
+    uint32_t* runs = (uint32_t*)realloc(r->runs, cap*sizeof(uint32_t));
+    if (!runs) return false;
+    r->runs = runs; r->runs_cap = cap;
+    return true;
+}
+
+// The box as (count, id) runs, x fastest; counts are capped at 65535. Runs are
+// gathered before anything is written, so out of memory (false) leaves no record.
+static bool rec_region(Recorder* r, const World* w, int x0,int y0,int z0, int x1,int y1,int z1) {
+    size_t n = 0;
+    uint16_t cur = 0;
+    uint32_t count = 0;
+    for (int z=z0; z<=z1; z++)
+    for (int y=y0; y<=y1; y++) {
+        const uint16_t* row = &w->v[idx3D(w, 0, y, z)];
+        for (int x=x0; x<=x1; x++) {
+            if (count && row[x] == cur && count < 0xFFFF) { count++; continue; }
+            if (count) {
+                if (!runs_reserve(r, n)) return false;
+                r->runs[n++] = count | (uint32_t)cur << 16;
+            }
+            cur = row[x]; count = 1;
+        }
+    }
+    if (!runs_reserve(r, n)) return false;
+    r->runs[n++] = count | (uint32_t)cur << 16;
+
+    uint8_t b[29], *p = b;
+    *p++ = REC_REGION;
+    p = put_i32(p, x0); p = put_i32(p, y0); p = put_i32(p, z0);
+    p = put_i32(p, x1-x0+1); p = put_i32(p, y1-y0+1); p = put_i32(p, z1-z0+1);
+    p = put_u32(p, (uint32_t)n);
+    rec_write(r, b, (size_t)(p - b));
+    for (size_t i=0;i<n;i++) {   // little-endian u32 = (u16 count, u16 id)
+        uint8_t q[4];
+        put_u32(q, r->runs[i]);
+        rec_write(r, q, 4);
+    }
+    return true;
+}
+
+void replay_record_change(Engine* e, int kind, int x0,int y0,int z0, int x1,int y1,int z1, uint16_t id) {
+    Recorder* r = e->rec;
+    uint8_t b[27], *p = b;
+    r->edits++;
+    if (kind == ENGINE_CHANGE_RESET) {
+        *p++ = REC_WORLD;
+        p = put_i32(p, x1+1); p = put_i32(p, y1+1); p = put_i32(p, z1+1);
+    } else if (kind == ENGINE_CHANGE_BLOCK) {
+        *p++ = REC_BLOCK;
+        p = put_i32(p, x0); p = put_i32(p, y0); p = put_i32(p, z0);
+        p = put_u16(p, id);
+    } else if (id != ENGINE_CHANGE_MIXED) {
+        *p++ = REC_FILL;
+        p = put_i32(p, x0); p = put_i32(p, y0); p = put_i32(p, z0);
+        p = put_i32(p, x1); p = put_i32(p, y1); p = put_i32(p, z1);
+        p = put_u16(p, id);
+    } else {   // already written: copy what landed
+        // out of memory: end the log here, at a record boundary, rather than leave a hole
+        if (!rec_region(r, &e->world, x0,y0,z0, x1,y1,z1)) engine_stop_recording(e);
+        return;
+    }
+    rec_write(r, b, (size_t)(p - b));
+}
+
+void replay_record_camera(Engine* e) {
+    uint8_t b[21], *p = b;
+    *p++ = REC_CAMERA;
+    p = put_f32(p, e->cam.position.x); p = put_f32(p, e->cam.position.y); p = put_f32(p, e->cam.position.z);
+    p = put_f32(p, e->yaw); p = put_f32(p, e->pitch);
+    rec_write(e->rec, b, (size_t)(p - b));
+}
+
+bool engine_start_recording(Engine* e, const char* path) {
+    if (!e || !path || e->rec || e->replay) return false;
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    Recorder* r = (Recorder*)calloc(1, sizeof(Recorder));
+    if (!r) { fclose(f); return false; }
+    r->f = f;
+    setvbuf(f, NULL, _IOFBF, 1<<20);
+
+    uint8_t b[REPLAY_HEADER], *p = b;
+    p = put_u32(p, REPLAY_MAGIC); p = put_u32(p, REPLAY_VERSION);
+    p = put_f32(p, e->cam.position.x); p = put_f32(p, e->cam.position.y); p = put_f32(p, e->cam.position.z);
+    p = put_f32(p, e->yaw); p = put_f32(p, e->pitch); p = put_f32(p, e->velY);
+    p = put_i32(p, e->render_mode);
+    rec_write(r, b, sizeof b);
+    e->rec = r;
+
+    const World* w = &e->world;
+    if (w->v) {   // the world as it is now, so the replay starts from the same state
+        replay_record_change(e, ENGINE_CHANGE_RESET, 0,0,0, w->sx-1,w->sy-1,w->sz-1, 0);
+        replay_record_change(e, ENGINE_CHANGE_BOX, 0,0,0, w->sx-1,w->sy-1,w->sz-1, ENGINE_CHANGE_MIXED);
+    }
+    return e->rec != NULL;   // stopped already when the world did not fit in memory
+}
+
+void engine_stop_recording(Engine* e) {
+    if (!e || !e->rec) return;
+    fclose(e->rec->f);
+    free(e->rec->runs);
+    free(e->rec);
+    e->rec = NULL;
+}
+
+// ---------- replay ----------
+
+static uint32_t get_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static int32_t  get_i32(const uint8_t* p) { int32_t v;  memcpy(&v, p, 4); return v; }
+static float    get_f32(const uint8_t* p) { float v;    memcpy(&v, p, 4); return v; }
+static uint16_t get_u16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+
+// Size of the record at p (tag included), 0 if it is unknown or runs past the end.
+static size_t record_size(const uint8_t* p, size_t avail) {
+    size_t n;
+    switch (p[0]) {
+        case REC_TICK:   n = 27; break;
+        case REC_WORLD:  n = 13; break;
+        case REC_BLOCK:  n = 15; break;
+        case REC_FILL:   n = 27; break;
+        case REC_CAMERA: n = 21; break;
+        case REC_REGION:
+            if (avail < 29) return 0;
+            n = 29 + (size_t)get_u32(p + 25)*4;
+            break;
+        default: return 0;
+    }
+    return n <= avail ? n : 0;
+}
+
+static void apply_region(Engine* e, Replayer* r, const uint8_t* p) {
+    int x0 = get_i32(p+1), y0 = get_i32(p+5), z0 = get_i32(p+9);
+    int dx = get_i32(p+13), dy = get_i32(p+17), dz = get_i32(p+21);
+    uint32_t nruns = get_u32(p+25);
+    if (dx <= 0 || dy <= 0 || dz <= 0) return;
+    size_t n = (size_t)dx*dy*dz, o = 0;
+    if (n > r->scratch_cap) {
+        free(r->scratch);
+        r->scratch = (uint16_t*)malloc(n*sizeof(uint16_t));
+        r->scratch_cap = r->scratch ? n : 0;
+        if (!r->scratch) return;
+    }
+    for (uint32_t i=0; i<nruns; i++) {
+        size_t count = get_u16(p + 29 + 4*i);
+        uint16_t id = get_u16(p + 31 + 4*i);
+        if (count > n - o) return;   // corrupt: more voxels than the box
+        for (size_t k=0;k<count;k++) r->scratch[o+k] = id;
+        o += count;
+    }
+    if (o == n) engine_write_region(e, x0,y0,z0, dx,dy,dz, r->scratch);
+}
+
+bool engine_start_replay(Engine* e, const char* path) {
+    if (!e || !path || e->rec || e->replay || e->net) return false;
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t* data = NULL;
+    size_t len = 0, cap = 0, got;
+    do {
+        if (cap - len < (1u<<16)) {
+            size_t grown_cap = cap ? cap*2 : 1u<<20;
+            uint8_t* grown = (uint8_t*)realloc(data, grown_cap);
+            if (!grown) { free(data); fclose(f); return false; }
+            data = grown; cap = grown_cap;
+        }
+        got = fread(data + len, 1, cap - len, f);
+        len += got;
+    } while (got);
+    fclose(f);
+    if (len < REPLAY_HEADER || get_u32(data) != REPLAY_MAGIC || get_u32(data+4) != REPLAY_VERSION) {
+        free(data);
+        return false;
+    }
+
+    // count ticks, and stop at the first damaged record (e.g. a log cut short by a crash)
+    Replayer* r = (Replayer*)calloc(1, sizeof(Replayer));
+    if (!r) { free(data); return false; }
+    size_t at = REPLAY_HEADER, n;
+    while (at < len && (n = record_size(data + at, len - at))) {
+        if (data[at] == REC_TICK) r->ticks_total++;
+        at += n;
+    }
+    r->data = data;
+    r->len = at;
+    r->at = REPLAY_HEADER;
+
+    e->cam.position = (Vector3){ get_f32(data+8), get_f32(data+12), get_f32(data+16) };
+    e->yaw = get_f32(data+20); e->pitch = get_f32(data+24);
+    e->velY = get_f32(data+28);
+    engine_set_render_mode(e, get_i32(data+32));
+    e->in.keys = 0;
+    e->replay = r;
+    if (!e->headless) SetTargetFPS(0);   // as fast as it will render
+    return true;
+}
+
+void engine_stop_replay(Engine* e) {
+    if (!e || !e->replay) return;
+    free(e->replay->data);
+    free(e->replay->scratch);
+    free(e->replay);
+    e->replay = NULL;
+    if (!e->headless) SetTargetFPS(e->tick_hz);
+}
+
+bool replay_begin_tick(Engine* e, float* dt) {
+    Replayer* r = e->replay;
+    while (r->at < r->len) {
+        const uint8_t* p = r->data + r->at;
+        r->at += record_size(p, r->len - r->at);   // validated when loaded
+        switch (p[0]) {
+            case REC_TICK:
+                *dt = get_f32(p+1);
+                e->in.keys = p[5];
+                if (p[6] != e->render_mode) engine_set_render_mode(e, p[6]);
+                e->yaw = get_f32(p+7); e->pitch = get_f32(p+11);
+                r->expect = (Vector3){ get_f32(p+15), get_f32(p+19), get_f32(p+23) };
+                r->ticks++;
+                return true;
+            case REC_WORLD:
+                engine_create_world(e, get_i32(p+1), get_i32(p+5), get_i32(p+9));
+                break;
+            case REC_BLOCK:
+                engine_set_block(e, get_i32(p+1), get_i32(p+5), get_i32(p+9), get_u16(p+13));
+                break;
+            case REC_FILL:
+                engine_fill_box(e, get_i32(p+1), get_i32(p+5), get_i32(p+9),
+                                   get_i32(p+13), get_i32(p+17), get_i32(p+21), get_u16(p+25));
+                break;
+            case REC_REGION:
+                apply_region(e, r, p);
+                break;
+            case REC_CAMERA:
+                engine_set_camera_pose(e, get_f32(p+1), get_f32(p+5), get_f32(p+9), get_f32(p+13), get_f32(p+17));
+                break;
+        }
+        if (p[0] != REC_CAMERA) r->edits++;
+    }
+    return false;   // end of the log
+}
+
+void replay_end_tick(Engine* e, float dt) {
+    if (e->rec) {
+        uint8_t b[27], *p = b;
+        *p++ = REC_TICK;
+        p = put_f32(p, dt);
+        *p++ = e->in.keys;
+        *p++ = (uint8_t)e->render_mode;
+        p = put_f32(p, e->yaw); p = put_f32(p, e->pitch);
+        p = put_f32(p, e->cam.position.x); p = put_f32(p, e->cam.position.y); p = put_f32(p, e->cam.position.z);
+        rec_write(e->rec, b, sizeof b);
+        e->rec->ticks++;
+    } else if (e->replay) {
+        // Same build, same log: bit-identical. Another compiler or flags may round
+        // differently; count it, then snap back so the rest of the run stays comparable.
+        Replayer* r = e->replay;
+        float err = Vector3Distance(e->cam.position, r->expect);
+        if (err > REPLAY_EPSILON) {
+            r->divergences++;
+            if (err > r->max_error) r->max_error = err;
+            e->cam.position = r->expect;
+        }
+    }
+}
+
+bool engine_get_recording_stats(Engine* e, EngineRecordingStats* out) {
+    if (!e || !out || (!e->rec && !e->replay)) return false;
+    memset(out, 0, sizeof(*out));
+    if (e->rec) {
+        out->recording = true;
+        out->ticks = e->rec->ticks;
+        out->edits = e->rec->edits;
+        out->bytes = e->rec->bytes;
+    } else {
+        Replayer* r = e->replay;
+        out->replaying   = true;
+        out->ticks       = r->ticks;
+        out->ticks_total = r->ticks_total;
+        out->edits       = r->edits;
+        out->bytes       = r->len;
+        out->divergences = r->divergences;
+        out->max_error   = r->max_error;
+    }
+    return true;
+}
@@ -0,0 +1,254 @@
+// shm.c — shared-memory transport for out-of-process controllers.
+//
+// One POSIX shared memory segment holds a command ring (controller -> engine),
+// an event ring (engine -> controller) and a read-only copy of the world, so a
+// controller in another process exchanges data without a pipe copying every
+// byte twice. Both rings are single-producer/single-consumer with free-running
+// u32 indices; the world view is kept current from the change feed (O(changes)
+// per tick) and guarded by a seqlock. On Linux the engine futex-wakes ev_head
+// after publishing events and cmd_tail after draining commands, so controllers
+// can sleep instead of spinning.
+//
+// Segment layout (little-endian, byte offsets):
+//     0  u32 magic 'MI3D', u32 version, u32 cmd_slots, u32 ev_slots
+//    16  u64 cmd_off, u64 ev_off, u64 view_off, u64 view_cap (voxels)
+//    64  u32 cmd_head   controller writes (own cache line)
+//   128  u32 cmd_tail   engine writes; futex word "space freed"
+//   192  u32 ev_head    engine writes; futex word "events published"
+//   256  u32 ev_tail    controller writes
+//   320  u32 view_seq   odd while the view is being updated
+//   324  i32 view_sx, view_sy, view_sz   (0 when the world exceeds view_cap)
+//   336  u64 tick, u32 ev_dropped
+//  cmd_off   ShmCmd[cmd_slots]      32 bytes each
+//  ev_off    EngineEvent[ev_slots]  32 bytes each
+//  view_off  u16[view_cap]          x fastest, then y, then z
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include "engine_internal.h"
+
+#ifndef _WIN32
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SHM_MAGIC      0x4433494Du   // "MI3D"
+#define SHM_VERSION    1
+#define SHM_CMD_SLOTS  65536
+#define SHM_EV_SLOTS   4096
+#define SHM_HEADER     4096
+#define SHM_NAME_MAX   64            // segment name, NUL included
+
+// Command record; op numbers match the binary frames of cmdserver.c.
+enum { SHM_OP_INIT = 1, SHM_OP_SET = 2, SHM_OP_FILL = 3, SHM_OP_COLUMN = 4, SHM_OP_CLEAR = 7 };
+typedef struct {
+    uint16_t op;
+    uint16_t id;
+    int32_t  a[6];       // init: sx,sy,sz | set: x,y,z | fill: x0,y0,z0,x1,y1,z1 | column: x,z,h
+    uint32_t _pad;
+} ShmCmd;
+
+typedef struct {
+    uint32_t magic, version, cmd_slots, ev_slots;
+    uint64_t cmd_off, ev_off, view_off, view_cap;
+    char     pad0[16];
+    _Atomic uint32_t cmd_head;  char pad1[60];
+    _Atomic uint32_t cmd_tail;  char pad2[60];
+    _Atomic uint32_t ev_head;   char pad3[60];
+    _Atomic uint32_t ev_tail;   char pad4[60];
+    _Atomic uint32_t view_seq;
+    int32_t  view_sx, view_sy, view_sz;
+    uint64_t tick;
+    uint32_t ev_dropped;
+} ShmHeader;
+
+_Static_assert(sizeof(ShmCmd) == 32, "ShmCmd layout");
+_Static_assert(sizeof(EngineEvent) == 32, "EngineEvent layout");
+_Static_assert(offsetof(ShmHeader, cmd_head) == 64 && offsetof(ShmHeader, ev_tail) == 256 &&
+               offsetof(ShmHeader, view_seq) == 320 && offsetof(ShmHeader, tick) == 336, "ShmHeader layout");
+
+struct ShmTransport {
+    char      name[SHM_NAME_MAX];
+    void*     base;
+    size_t    size;
+    ShmHeader* hdr;
+    ShmCmd*    cmds;
+    EngineEvent* evs;
+    uint16_t*  view;
+    uint64_t   change_cursor;   // our position in the change feed
+    bool       view_full;       // next sync copies the whole world
+    uint32_t   woken_ev_head;   // ev_head at the last futex wake
+};
+
+static void futex_wake(_Atomic uint32_t* word) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);   // shared: no FUTEX_PRIVATE
+#else
+    (void)word;   // controllers poll
+#endif
+}
+
+bool engine_start_shm(Engine* e, const char* name, int max_world_voxels) {
+    if (!e || !name || e->shm || max_world_voxels <= 0) return false;
+    if (strlen(name) >= SHM_NAME_MAX) return false;   // engine_stop_shm unlinks it by this name
+    size_t cmd_bytes = SHM_CMD_SLOTS*sizeof(ShmCmd), ev_bytes = SHM_EV_SLOTS*sizeof(EngineEvent);
+    size_t size = SHM_HEADER + cmd_bytes + ev_bytes + (size_t)max_world_voxels*sizeof(uint16_t);
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)size) != 0) { close(fd); shm_unlink(name); return false; }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) { shm_unlink(name); return false; }
+
+    ShmTransport* s = (ShmTransport*)calloc(1, sizeof(ShmTransport));
+    if (!s) { munmap(base, size); shm_unlink(name); return false; }
+    memcpy(s->name, name, strlen(name) + 1);
+    s->base = base; s->size = size;
+    s->hdr  = (ShmHeader*)base;
+    s->cmds = (ShmCmd*)((char*)base + SHM_HEADER);
+    s->evs  = (EngineEvent*)((char*)base + SHM_HEADER + cmd_bytes);
+    s->view = (uint16_t*)((char*)base + SHM_HEADER + cmd_bytes + ev_bytes);
+
+    ShmHeader* h = s->hdr;   // fresh segment: ftruncate zero-filled it
+    h->version   = SHM_VERSION;
+    h->cmd_slots = SHM_CMD_SLOTS; h->ev_slots = SHM_EV_SLOTS;
+    h->cmd_off   = SHM_HEADER;
+    h->ev_off    = SHM_HEADER + cmd_bytes;
+    h->view_off  = SHM_HEADER + cmd_bytes + ev_bytes;
+    h->view_cap  = (uint64_t)max_world_voxels;
+    atomic_store_explicit((_Atomic uint32_t*)&h->magic, SHM_MAGIC, memory_order_release);  // last: header complete
+
+    engine_set_change_feed(e, true);   // the view follows the feed
+    s->change_cursor = engine_change_cursor(e);
+    s->view_full = true;
+    e->shm = s;
+    return true;
+}
+
+void engine_stop_shm(Engine* e) {
+    if (!e || !e->shm) return;
+    ShmTransport* s = e->shm;
+    s->hdr->magic = 0;   // attached controllers see the engine is gone
+    munmap(s->base, s->size);
+    shm_unlink(s->name);
+    free(s);
+    e->shm = NULL;
+}
+
+void shm_apply(Engine* e) {
+    ShmTransport* s = e->shm;
+    if (!s) return;
+    ShmHeader* h = s->hdr;
+    uint32_t tail = atomic_load_explicit(&h->cmd_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&h->cmd_head, memory_order_acquire);
+    uint32_t n = head - tail;
+    if (n > SHM_CMD_SLOTS) n = 0;          // corrupt index from the controller: ignore
+    if (n > (uint32_t)e->edit_budget) n = (uint32_t)e->edit_budget;
+    for (uint32_t i=0;i<n;i++) {
+        const ShmCmd* c = &s->cmds[(tail + i) & (SHM_CMD_SLOTS-1)];
+        switch (c->op) {
+            case SHM_OP_INIT:   engine_create_world(e, c->a[0], c->a[1], c->a[2]); break;
+            case SHM_OP_SET:    engine_set_block(e, c->a[0], c->a[1], c->a[2], c->id); break;
+            case SHM_OP_FILL:   engine_fill_box(e, c->a[0], c->a[1], c->a[2], c->a[3], c->a[4], c->a[5], c->id); break;
+            case SHM_OP_COLUMN: if (c->a[2] > 0) engine_fill_box(e, c->a[0], 0, c->a[1], c->a[0], c->a[2]-1, c->a[1], c->id); break;
+            case SHM_OP_CLEAR:  engine_clear_world(e, c->id); break;
+            default: break;
+        }
+    }
+    if (n) {
+        atomic_store_explicit(&h->cmd_tail, tail + n, memory_order_release);
+        futex_wake(&h->cmd_tail);
+    }
+}
+
+void shm_event(Engine* e, const EngineEvent* ev) {
+    ShmHeader* h = e->shm->hdr;
+    uint32_t head = atomic_load_explicit(&h->ev_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&h->ev_tail, memory_order_acquire);
+    if (head - tail >= SHM_EV_SLOTS) { h->ev_dropped++; return; }   // controller not reading
+    e->shm->evs[head & (SHM_EV_SLOTS-1)] = *ev;
+    atomic_store_explicit(&h->ev_head, head + 1, memory_order_release);
+}
+
+// Copy an inclusive world box into the view (same dims, same layout). Clamped:
+// a record can predate a create_world that shrank the world.
+static void view_copy_box(ShmTransport* s, const World* w, int x0,int y0,int z0, int x1,int y1,int z1) {
+    x0 = x0 < 0 ? 0 : x0;  x1 = x1 >= w->sx ? w->sx-1 : x1;
+    y0 = y0 < 0 ? 0 : y0;  y1 = y1 >= w->sy ? w->sy-1 : y1;
+    z0 = z0 < 0 ? 0 : z0;  z1 = z1 >= w->sz ? w->sz-1 : z1;
+    if (x0 > x1) return;
+    for (int z=z0; z<=z1; z++)
+    for (int y=y0; y<=y1; y++) {
+        size_t i = (size_t)idx3D(w, x0, y, z);
+        memcpy(s->view + i, w->v + i, (size_t)(x1-x0+1)*sizeof(uint16_t));
+    }
+}
+
+void shm_publish(Engine* e) {
+    ShmTransport* s = e->shm;
+    if (!s) return;
+    ShmHeader* h = s->hdr;
+    const World* w = &e->world;
+    if (!e->changes) { engine_set_change_feed(e, true); s->view_full = true; }   // feed was turned off
+    uint64_t nvox = (uint64_t)w->sx*w->sy*w->sz;
+    bool fits = w->v && nvox <= h->view_cap;
+
+    // drain the change feed first: nothing to copy => no seqlock round trip
+    EngineChange buf[256];
+    int n = 0;
+    bool dirty = s->view_full;
+    if (fits && !dirty) {
+        n = engine_read_changes(e, &s->change_cursor, buf, 256);
+        if (n < 0) { dirty = true; s->view_full = true; n = 0; }
+    }
+    if (dirty || n > 0 || !fits) {
+        atomic_fetch_add_explicit(&h->view_seq, 1, memory_order_acq_rel);   // odd: writing
+        atomic_thread_fence(memory_order_release);
+        if (!fits) {
+            h->view_sx = h->view_sy = h->view_sz = 0;
+            s->view_full = true;                       // copy everything once it fits again
+            s->change_cursor = engine_change_cursor(e);
+        } else {
+            h->view_sx = w->sx; h->view_sy = w->sy; h->view_sz = w->sz;
+            for (;;) {
+                if (s->view_full) {
+                    memcpy(s->view, w->v, nvox*sizeof(uint16_t));
+                    s->view_full = false;
+                    s->change_cursor = engine_change_cursor(e);
+                    break;
+                }
+                for (int i=0;i<n;i++) {
+                    const EngineChange* c = &buf[i];
+                    if (c->kind == ENGINE_CHANGE_RESET) { s->view_full = true; break; }
+                    view_copy_box(s, w, c->x0, c->y0, c->z0, c->x1, c->y1, c->z1);
+                }
+                if (s->view_full) continue;
+                n = engine_read_changes(e, &s->change_cursor, buf, 256);
+                if (n < 0) { s->view_full = true; continue; }
+                if (n == 0) break;
+            }
+        }
+        atomic_fetch_add_explicit(&h->view_seq, 1, memory_order_release);  // even: stable
+    }
+
+    h->tick = e->ticks;
+    uint32_t ev_head = atomic_load_explicit(&h->ev_head, memory_order_relaxed);
+    if (ev_head != s->woken_ev_head) { s->woken_ev_head = ev_head; futex_wake(&h->ev_head); }  // only when something was published
+}
+
+#else  // _WIN32: no POSIX shared memory — use the C API or the extension module
+
+bool engine_start_shm(Engine* e, const char* name, int max_world_voxels) { (void)e; (void)name; (void)max_world_voxels; return false; }
+void engine_stop_shm(Engine* e) { (void)e; }
+void shm_apply(Engine* e) { (void)e; }
+void shm_event(Engine* e, const EngineEvent* ev) { (void)e; (void)ev; }
+void shm_publish(Engine* e) { (void)e; }
+
+#endif
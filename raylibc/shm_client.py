@@ -0,0 +1,177 @@
+"""Shared-memory controller: drive the engine from another process without a pipe.
+
+Attaches to the segment created by engine_start_shm (layout at the top of shm.c),
+pushes set/fill/column/clear records into the command ring, reads events from
+the event ring and reads blocks from the world view. Start the host first:
+
+    MINI3D_SHM=/mini3d ./mini3d_host &
+    python3 shm_client.py /mini3d
+
+The rings are single-producer/single-consumer: one controller per segment.
+Record bytes are written before the index that publishes them; CPython does not
+reorder those stores, which is enough on x86-64 and what this demo relies on.
+"""
+import ctypes as C, mmap, os, platform, struct, sys, time
+
+MAGIC = 0x4433494D
+OP_INIT, OP_SET, OP_FILL, OP_COLUMN, OP_CLEAR = 1, 2, 3, 4, 7
+CMD = struct.Struct("<HH6iI")                  # ShmCmd, 32 bytes
+EVENT = struct.Struct("<IIi5f")                # EngineEvent, 32 bytes
+EVENT_NAMES = {1: "key_down", 2: "key_up", 3: "mouse_down", 4: "mouse_up", 5: "player"}
+CMD_HEAD, CMD_TAIL, EV_HEAD, EV_TAIL, VIEW_SEQ = 64, 128, 192, 256, 320
+
+_SYS_FUTEX = {"x86_64": 202, "aarch64": 98}.get(platform.machine())
+_libc = C.CDLL(None, use_errno=True) if sys.platform.startswith("linux") else None
+
+class Timespec(C.Structure):
+    _fields_ = [("tv_sec", C.c_long), ("tv_nsec", C.c_long)]
+
+def open_segment(name):
+    path = "/dev/shm/" + name.lstrip("/")
+    if os.path.exists(path):
+        fd = os.open(path, os.O_RDWR)
+    else:   # macOS & co: no /dev/shm, go through shm_open
+        from multiprocessing import shared_memory
+        seg = shared_memory.SharedMemory(name.lstrip("/"))
+        fd = os.dup(seg._fd)
+        seg.close()
+    try:
+        return mmap.mmap(fd, 0)
+    finally:
+        os.close(fd)
+
+class ShmController:
+    def __init__(self, name="/mini3d"):
+        self.mm = open_segment(name)
+        (magic, version, self.cmd_slots, self.ev_slots,
+         self.cmd_off, self.ev_off, self.view_off, self.view_cap) = struct.unpack_from("<4I4Q", self.mm, 0)
+        if magic != MAGIC:
+            raise RuntimeError(f"{name} is not a mini3d segment (or the engine has stopped)")
+        self.u32 = memoryview(self.mm).cast("I")
+        self.cmd_head = self.u32[CMD_HEAD // 4]
+        self.ev_tail = self.u32[EV_TAIL // 4]
+        self.pending = []
+
+    # --- commands -------------------------------------------------------------
+    def init(self, sx, sy, sz):             self.pending.append(CMD.pack(OP_INIT, 0, sx, sy, sz, 0, 0, 0, 0))
+    def clear(self, block_id=0):            self.pending.append(CMD.pack(OP_CLEAR, block_id, 0, 0, 0, 0, 0, 0, 0))
+    def set_block(self, x, y, z, block_id): self.pending.append(CMD.pack(OP_SET, block_id, x, y, z, 0, 0, 0, 0))
+    def column(self, x, z, h, block_id):    self.pending.append(CMD.pack(OP_COLUMN, block_id, x, z, h, 0, 0, 0, 0))
+    def fill(self, x0, y0, z0, x1, y1, z1, block_id):
+        self.pending.append(CMD.pack(OP_FILL, block_id, x0, y0, z0, x1, y1, z1, 0))
+
+    def flush(self, timeout=5.0):
+        """Copy pending records into the ring, waiting for the engine when it is full."""
+        recs, i = self.pending, 0
+        self.pending = []
+        deadline = time.monotonic() + timeout
+        while i < len(recs):
+            tail = self.u32[CMD_TAIL // 4]
+            free = self.cmd_slots - ((self.cmd_head - tail) & 0xFFFFFFFF)
+            if free == 0:
+                if time.monotonic() > deadline:
+                    raise TimeoutError("engine is not draining the command ring")
+                self._wait(CMD_TAIL, tail, 0.05)
+                continue
+            slot = self.cmd_head & (self.cmd_slots - 1)
+            n = min(free, len(recs) - i, self.cmd_slots - slot)     # one contiguous copy, no wrap
+            at = self.cmd_off + slot*32
+            self.mm[at : at + n*32] = b"".join(recs[i : i + n])
+            self.cmd_head = (self.cmd_head + n) & 0xFFFFFFFF
+            self.u32[CMD_HEAD // 4] = self.cmd_head      # publish after the records
+            i += n
+
+    def pending_in_ring(self):
+        return (self.cmd_head - self.u32[CMD_TAIL // 4]) & 0xFFFFFFFF
+
+    # --- events ---------------------------------------------------------------
+    def poll_events(self):
+        head = self.u32[EV_HEAD // 4]
+        out = []
+        while self.ev_tail != head:
+            slot = self.ev_tail & (self.ev_slots - 1)
+            out.append(EVENT.unpack_from(self.mm, self.ev_off + slot*32))
+            self.ev_tail = (self.ev_tail + 1) & 0xFFFFFFFF
+        self.u32[EV_TAIL // 4] = self.ev_tail
+        return out
+
+    def wait_events(self, timeout=1.0):
+        """Sleep until the engine publishes an event (futex on Linux, polling elsewhere)."""
+        if self.u32[EV_HEAD // 4] == self.ev_tail:
+            self._wait(EV_HEAD, self.ev_tail, timeout)
+        return self.poll_events()
+
+    def _wait(self, offset, expected, timeout):
+        if _libc is None or _SYS_FUTEX is None:
+            time.sleep(min(timeout, 0.002))
+            return
+        word = C.c_uint32.from_buffer(self.mm, offset)
+        ts = Timespec(int(timeout), int((timeout % 1) * 1e9))
+        _libc.syscall(_SYS_FUTEX, C.byref(word), 0, C.c_uint32(expected), C.byref(ts), None, 0)   # FUTEX_WAIT
+        del word
+
+    # --- world view -----------------------------------------------------------
+    def _stable(self, read):
+        while True:
+            s0 = self.u32[VIEW_SEQ // 4]
+            if s0 & 1:
+                continue
+            value = read()
+            if self.u32[VIEW_SEQ // 4] == s0:
+                return value
+
+    def dims(self):
+        return self._stable(lambda: struct.unpack_from("<3i", self.mm, VIEW_SEQ + 4))
+
+    def get_block(self, x, y, z):
+        def read():
+            sx, sy, sz = struct.unpack_from("<3i", self.mm, VIEW_SEQ + 4)
+            if not (0 <= x < sx and 0 <= y < sy and 0 <= z < sz):
+                return 0
+            return struct.unpack_from("<H", self.mm, self.view_off + 2*(x + y*sx + z*sx*sy))[0]
+        return self._stable(read)
+
+    def read_view(self):
+        """Consistent copy of the whole world as bytes (u16 per voxel, x fastest)."""
+        def read():
+            sx, sy, sz = struct.unpack_from("<3i", self.mm, VIEW_SEQ + 4)
+            return (sx, sy, sz), self.mm[self.view_off : self.view_off + 2*sx*sy*sz]
+        return self._stable(read)
+
+    def close(self):
+        self.u32.release()
+        self.mm.close()
+
+def main():
+    name = sys.argv[1] if len(sys.argv) > 1 else "/mini3d"
+    c = ShmController(name)
+    SX, SY, SZ = 128, 48, 128
+    c.init(SX, SY, SZ)
+    c.fill(0, 0, 0, SX-1, 3, SZ-1, 5)
+    for z in range(SZ):
+        for x in range(SX):
+            c.column(x, z, 4 + (x ^ z) % 6, 3)
+    n = 200_000
+    for i in range(n):
+        c.set_block((i*37) % SX, 12 + i % 8, (i*91) % SZ, 1 + i % 8)
+    t0 = time.perf_counter()
+    c.flush()
+    while c.pending_in_ring():
+        c._wait(CMD_TAIL, c.u32[CMD_TAIL // 4], 0.05)
+    dt = time.perf_counter() - t0
+    print(f"{n + SX*SZ + 2} records applied in {dt*1000:.1f} ms ({(n + SX*SZ)/dt/1e6:.2f} M/s)")
+    time.sleep(0.1)   # let the next tick publish the view
+    dims, vox = c.read_view()
+    print("view", dims, "block at (0,0,0):", c.get_block(0, 0, 0), "solid voxels:",
+          sum(1 for v in memoryview(vox).cast("H") if v))
+    print("waiting for input events (Ctrl-C to stop)")
+    try:
+        while True:
+            for typ, frame, code, x, y, z, yaw, pitch in c.wait_events(1.0):
+                print(f"frame {frame}: {EVENT_NAMES.get(typ, typ)} code={code} pos=({x:.1f},{y:.1f},{z:.1f})")
+    except KeyboardInterrupt:
+        pass
+    c.close()
+
+if __name__ == "__main__":
+    main()
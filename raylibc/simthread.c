@@ -0,0 +1,244 @@
+// simthread.c — the simulation on its own thread, drawing on the window thread.
+//
+// engine_start_sim_thread moves everything engine_tick does except reading the
+// keyboard/mouse and drawing onto a thread that ticks at a fixed rate: edits from
+// every source, physics, servers, replication, recording. A tick runs under the
+// world lock and ends by publishing a RenderView (camera, renderer, other players)
+// into a triple buffer: the simulation always has a slot to write and the window
+// thread a slot to draw from, the third holds the newest finished view, and each
+// side swaps with it in one atomic exchange, so neither ever waits for the other.
+//
+// engine_tick, on the window thread, leaves its input in a mailbox for the next
+// tick, takes the newest view (turned by whatever mouse look the simulation has
+// not applied yet, so looking around stays at frame rate) and draws it. The
+// meshed renderer reads the world lock-free (chunk seqlocks) while ticks run;
+// the others take the world lock. GPU meshes freed off the window thread wait
+// here until it unloads them, since it owns the GL context. POSIX threads; not
+// available on Windows.
+#include "engine_internal.h"
+#include <math.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+
+#define VIEW_FRESH 4   // in SimThread.ready: that slot has not been taken yet
+
+typedef struct {
+    RenderView view;
+    double look_yaw, look_pitch;  // mouse look totals the tick had taken from the mailbox
+    float  tick_ms;
+} ViewSlot;
+
+struct SimThread {
+    pthread_t thread;
+    pthread_mutex_t world;        // held by each tick, engine_lock, and the non-meshed renderers
+    int hz;
+    atomic_bool quit;
+    atomic_bool ended;            // the replay being played ran out: ticks stopped
+
+    ViewSlot slots[3];
+    _Atomic int ready;            // slot with the newest view (| VIEW_FRESH until taken)
+    int back;                     // slot the simulation fills (sim thread only)
+    int front;                    // slot being drawn (window thread only)
+
+    // mailbox, counters and trash, under mail (never held while waiting for world)
+    pthread_mutex_t mail;
+    InputSample input;            // window input merged since the last tick took it
+    double look_yaw, look_pitch;  // all mouse look ever sampled
+    double taken_yaw, taken_pitch;// ... and how much of it ticks have taken
+    EngineSimStats st;
+    Mesh* trash;                  // GPU meshes to unload on the window thread
+    int   ntrash, trash_cap;
+};
+
+// Held keys are the latest; a jump press, renderer switches, look and events add up.
+static void input_merge(InputSample* m, const InputSample* s) {
+    m->keys = (uint8_t)(s->keys | (m->keys & INPUT_JUMP));
+    m->mode_steps += s->mode_steps;
+    m->dyaw += s->dyaw; m->dpitch += s->dpitch;
+    for (int i=0; i<s->nevents && m->nevents < INPUT_EVENTS_MAX; i++) m->events[m->nevents++] = s->events[i];
+}
+
+static void* sim_main(void* arg) {
+    Engine* e = (Engine*)arg;
+    SimThread* s = e->sim;
+    const double period = 1.0/s->hz;
+    double next = stats_now();
+    while (!atomic_load(&s->quit)) {
+        pthread_mutex_lock(&s->world);
+        double t0 = stats_now();
+        InputSample in;
+        pthread_mutex_lock(&s->mail);
+        in = s->input;
+        s->input.keys &= (uint8_t)~INPUT_JUMP;
+        s->input.mode_steps = 0; s->input.dyaw = s->input.dpitch = 0; s->input.nevents = 0;
+        s->taken_yaw = s->look_yaw; s->taken_pitch = s->look_pitch;
+        double yaw_total = s->taken_yaw, pitch_total = s->taken_pitch;
+        pthread_mutex_unlock(&s->mail);
+
+        float physics_ms;
+        if (!simulate_tick(e, (float)period, e->headless ? NULL : &in, &physics_ms)) {
+            atomic_store(&s->ended, true);
+            pthread_mutex_unlock(&s->world);
+            break;
+        }
+        ViewSlot* v = &s->slots[s->back];
+        view_capture(e, &v->view);
+        v->look_yaw = yaw_total; v->look_pitch = pitch_total;
+        double t1 = stats_now();
+        v->tick_ms = (float)((t1-t0)*1000.0);
+        s->back = atomic_exchange(&s->ready, s->back | VIEW_FRESH) & 3;
+        pthread_mutex_unlock(&s->world);
+
+        pthread_mutex_lock(&s->mail);
+        s->st.ticks++;
+        if (t0 > next + period) s->st.late_ticks++;
+        s->st.tick_ms = v->tick_ms;
+        if (v->tick_ms > s->st.tick_ms_max) s->st.tick_ms_max = v->tick_ms;
+        pthread_mutex_unlock(&s->mail);
+
+        next += period;   // fixed rate: a slow tick is caught up by the ones after it...
+        if (t1 - next > 0.25) next = t1;   // ... unless it stalled so long that racing would not help
+        stats_sleep_until(next);
+    }
+    return NULL;
+}
+
+// Window thread, mail held: unload what ticks freed. The chunk list kept for
+// frames that cannot read the world may still point at those meshes, so drop it.
+static void reap(Engine* e, SimThread* s) {
+    if (!s->ntrash) return;
+    for (int i=0; i<s->ntrash; i++) UnloadMesh(s->trash[i]);
+    s->ntrash = 0;
+    e->ndraws = 0;
+}
+
+bool simthread_begin_frame(Engine* e, float* tick_ms) {
+    SimThread* s = e->sim;
+    InputSample in;
+    if (!e->headless) input_sample(e, &in);
+    pthread_mutex_lock(&s->mail);
+    reap(e, s);
+    if (!e->headless) {
+        input_merge(&s->input, &in);
+        s->look_yaw += in.dyaw; s->look_pitch += in.dpitch;
+    }
+    double yaw_total = s->look_yaw, pitch_total = s->look_pitch;
+    s->st.frames++;
+    pthread_mutex_unlock(&s->mail);
+
+    if (atomic_load(&s->ready) & VIEW_FRESH) s->front = atomic_exchange(&s->ready, s->front) & 3;
+    const ViewSlot* v = &s->slots[s->front];
+    e->view = v->view;
+    float dyaw = (float)(yaw_total - v->look_yaw), dpitch = (float)(pitch_total - v->look_pitch);
+    if (dyaw != 0 || dpitch != 0) {   // look ahead of the simulation: turn the camera here
+        RenderView* rv = &e->view;
+        rv->yaw += dyaw;
+        rv->pitch = look_pitch(rv->pitch + dpitch);
+        float cp = cosf(rv->pitch);
+        Vector3 forward = { cp*sinf(rv->yaw), sinf(rv->pitch), -cp*cosf(rv->yaw) };
+        rv->cam.target = Vector3Add(rv->cam.position, forward);
+    }
+    *tick_ms = v->tick_ms;
+    return !atomic_load(&s->ended);
+}
+
+void simthread_lock(Engine* e) {
+    if (e->sim) pthread_mutex_lock(&e->sim->world);
+}
+
+void simthread_unlock(Engine* e) {
+    if (e->sim) pthread_mutex_unlock(&e->sim->world);
+}
+
+void simthread_stale_frame(Engine* e) {
+    SimThread* s = e->sim;
+    if (!s) return;
+    pthread_mutex_lock(&s->mail);
+    s->st.stale_frames++;
+    pthread_mutex_unlock(&s->mail);
+}
+
+bool simthread_defer_unload(Engine* e, const Mesh* m) {
+    SimThread* s = e->sim;
+    if (!s) return false;
+    pthread_mutex_lock(&s->mail);
+    if (s->ntrash == s->trash_cap) {
+        int cap = s->trash_cap ? s->trash_cap*2 : 64;
+        Mesh* t = (Mesh*)realloc(s->trash, (size_t)cap*sizeof(Mesh));
+        if (t) { s->trash = t; s->trash_cap = cap; }
+    }
+    if (s->ntrash < s->trash_cap) s->trash[s->ntrash++] = *m;   // out of memory: leak it rather than touch GL off its thread
+    pthread_mutex_unlock(&s->mail);
+    return true;
+}
+
+bool engine_start_sim_thread(Engine* e, int hz) {
+    if (!e || e->sim || hz <= 0) return false;
+    SimThread* s = (SimThread*)calloc(1, sizeof(SimThread));
+    if (!s) return false;
+    s->hz = hz;
+    s->st.hz = hz;
+    pthread_mutex_init(&s->world, NULL);
+    pthread_mutex_init(&s->mail, NULL);
+    view_capture(e, &s->slots[0].view);   // something to draw before the first tick
+    s->slots[1] = s->slots[2] = s->slots[0];
+    s->front = 0; s->back = 1;
+    atomic_store(&s->ready, 2);
+    e->view = s->slots[0].view;
+    e->sim = s;
+    if (pthread_create(&s->thread, NULL, sim_main, e) != 0) {
+        e->sim = NULL;
+        pthread_mutex_destroy(&s->world);
+        pthread_mutex_destroy(&s->mail);
+        free(s);
+        return false;
+    }
+    return true;
+}
+
+void engine_stop_sim_thread(Engine* e) {
+    if (!e || !e->sim) return;
+    SimThread* s = e->sim;
+    atomic_store(&s->quit, true);
+    pthread_join(s->thread, NULL);
+    reap(e, s);
+    free(s->trash);
+    pthread_mutex_destroy(&s->world);
+    pthread_mutex_destroy(&s->mail);
+    free(s);
+    e->sim = NULL;
+}
+
+void engine_lock(Engine* e) {
+    if (e && e->sim) pthread_mutex_lock(&e->sim->world);
+}
+
+void engine_unlock(Engine* e) {
+    if (e && e->sim) pthread_mutex_unlock(&e->sim->world);
+}
+
+bool engine_get_sim_stats(Engine* e, EngineSimStats* out) {
+    if (!e || !out || !e->sim) return false;
+    SimThread* s = e->sim;
+    pthread_mutex_lock(&s->mail);
+    *out = s->st;
+    s->st.tick_ms_max = 0;
+    pthread_mutex_unlock(&s->mail);
+    return true;
+}
+
+#else   // _WIN32: no simulation thread, engine_tick does everything
+
+bool simthread_begin_frame(Engine* e, float* tick_ms) { (void)e; *tick_ms = 0; return false; }
+void simthread_lock(Engine* e) { (void)e; }
+void simthread_unlock(Engine* e) { (void)e; }
+void simthread_stale_frame(Engine* e) { (void)e; }
+bool simthread_defer_unload(Engine* e, const Mesh* m) { (void)e; (void)m; return false; }
+bool engine_start_sim_thread(Engine* e, int hz) { (void)e; (void)hz; return false; }
+void engine_stop_sim_thread(Engine* e) { (void)e; }
+void engine_lock(Engine* e) { (void)e; }
+void engine_unlock(Engine* e) { (void)e; }
+bool engine_get_sim_stats(Engine* e, EngineSimStats* out) { (void)e; (void)out; return false; }
+
+#endif
@@ -0,0 +1,205 @@
+// snapshot.c — copy-on-write world snapshots.
+//
+// The world is one dense array, so a chunk cannot be shared by pointer. A snapshot
+// instead references a ChunkSnap per chunk: the version the chunk was at (its
+// seq), shared by every snapshot taken since its last edit, and by the chunk
+// itself while that version is current. Taking one copies no voxels. The next
+// write to the chunk first detaches it (chunks_write_begin): the old voxels are
+// copied out once, for all snapshots holding that version, and only when one
+// still does. Until then a snapshot reads the live voxels under the chunk seqlock
+// and falls back to the copy when the seq has moved on, so writers never wait for
+// readers and readers never see half an edit.
+#include "engine_internal.h"
+
+#define CHUNK_VOXELS (CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE)
+
+struct ChunkSnap {
+    atomic_int refs;              // the chunk while this version is current, plus each snapshot
+    atomic_int users;             // snapshot reads inside snap_read_chunk (snapshot_retire waits them out)
+    uint32_t   seq;               // chunk seq of this version
+    _Atomic(const uint16_t*) copy;// [CHUNK_VOXELS] x fastest, once the chunk moved on
+};
+
+struct EngineSnapshot {
+    World* w;
+    int sx, sy, sz;
+    int ncx, ncy, ncz;
+    ChunkSnap* chunks[];          // [ncx*ncy*ncz]
+};
+
+static const uint16_t kAirChunk[CHUNK_VOXELS];   // the copy when there was no memory for one
+
+static void snap_unref(ChunkSnap* s) {
+    if (atomic_fetch_sub(&s->refs, 1) != 1) return;
+    const uint16_t* copy = atomic_load_explicit(&s->copy, memory_order_relaxed);
+    if (copy != kAirChunk) free((void*)copy);
+    free(s);
+}
+
+// Writer side: chunk ci is about to change, so its current version is kept only
+// if a snapshot still holds it.
+static void chunk_detach(World* w, int ci) {
+    Chunk* c = &w->chunks[ci];
+    ChunkSnap* s = c->snap;
+    c->snap = NULL;
+    w->snapped--;
+    if (atomic_load(&s->refs) > 1) {
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+        int nx = w->sx-x0 < CHUNK_SIZE ? w->sx-x0 : CHUNK_SIZE;
+        int ny = w->sy-y0 < CHUNK_SIZE ? w->sy-y0 : CHUNK_SIZE;
+        int nz = w->sz-z0 < CHUNK_SIZE ? w->sz-z0 : CHUNK_SIZE;
+        uint16_t* copy = (uint16_t*)malloc(CHUNK_VOXELS*sizeof(uint16_t));
+        if (copy) {
+            for (int z=0; z<nz; z++)
+            for (int y=0; y<ny; y++)
+                memcpy(copy + y*CHUNK_SIZE + z*CHUNK_SIZE*CHUNK_SIZE, &w->v[idx3D(w, x0, y0+y, z0+z)], nx*sizeof(uint16_t));
+        }
+        atomic_store_explicit(&s->copy, copy ? copy : kAirChunk, memory_order_release);
+    }
+    snap_unref(s);
+}
+
+void snapshot_detach(Engine* e, int x0,int y0,int z0, int x1,int y1,int z1) {
+    World* w = &e->world;
+    if (!w->snapped) return;
+    int lo[3], hi[3];
+    chunk_range(w, x0,y0,z0, x1,y1,z1, lo, hi);
+    for (int cz=lo[2]; cz<=hi[2]; cz++)
+    for (int cy=lo[1]; cy<=hi[1]; cy++)
+    for (int cx=lo[0]; cx<=hi[0]; cx++) {
+        int ci = chunkIndex(w,cx,cy,cz);
+        if (w->chunks[ci].snap) chunk_detach(w, ci);
+    }
+    atomic_thread_fence(memory_order_release);   // copies before the seqs move on
+}
+
+void snapshot_detach_all(Engine* e) {
+    World* w = &e->world;
+    if (w->snapped) snapshot_detach(e, 0,0,0, w->sx-1,w->sy-1,w->sz-1);
+}
+
+// Before the engine itself is freed: detach every version, then wait out the
+// reads that loaded a NULL copy before it was published. Those may still be on
+// their way into the world; every later read finds the copy and never touches it.
+void snapshot_retire(Engine* e) {
+    World* w = &e->world;
+    int n = w->chunks ? w->ncx*w->ncy*w->ncz : 0;
+    for (int ci=0; ci<n && w->snapped; ci++) {
+        ChunkSnap* cs = w->chunks[ci].snap;
+        if (!cs) continue;
+        atomic_fetch_add(&cs->refs, 1);          // keep it to wait on past the detach
+        chunk_detach(w, ci);
+        atomic_thread_fence(memory_order_seq_cst);   // copy published before users is read
+        while (atomic_load(&cs->users)) stats_sleep_until(stats_now() + 0.0001);
+        snap_unref(cs);
+    }
+}
+
+EngineSnapshot* engine_snapshot_world(Engine* e) {
+    if (!e || !e->world.v) return NULL;
+    World* w = &e->world;
+    int n = w->ncx*w->ncy*w->ncz;
+    EngineSnapshot* s = (EngineSnapshot*)malloc(sizeof(EngineSnapshot) + (size_t)n*sizeof(ChunkSnap*));
+    if (!s) return NULL;
+    *s = (EngineSnapshot){ w, w->sx, w->sy, w->sz, w->ncx, w->ncy, w->ncz };
+    for (int i=0; i<n; i++) {
+        Chunk* c = &w->chunks[i];
+        if (!c->snap) {
+            ChunkSnap* cs = (ChunkSnap*)malloc(sizeof(ChunkSnap));
+            if (!cs) {
+                s->ncx = i; s->ncy = s->ncz = 1;   // release the ones taken so far
+                engine_release_snapshot(s);
+                return NULL;
+            }
+            atomic_init(&cs->refs, 1);
+            atomic_init(&cs->users, 0);
+            cs->seq = atomic_load_explicit(&c->seq, memory_order_relaxed);   // even: writers are serialized with us
+            atomic_init(&cs->copy, NULL);
+            c->snap = cs;
+            w->snapped++;
+        }
+        atomic_fetch_add(&c->snap->refs, 1);
+        s->chunks[i] = c->snap;
+    }
+    return s;
+}
+
+void engine_snapshot_size(const EngineSnapshot* s, int* sx, int* sy, int* sz) {
+    if (sx) *sx = s ? s->sx : 0;
+    if (sy) *sy = s ? s->sy : 0;
+    if (sz) *sz = s ? s->sz : 0;
+}
+
+// The voxels of version cs of chunk ci, from the world when it is still current:
+// copies the box [a,b) (chunk-local) into out, whose rows are dx and planes dx*dy
+// apart. Falls back to the copy the edit that moved the chunk on left behind.
+static void snap_read_chunk(const EngineSnapshot* s, int ci, const int a[3], const int b[3],
+                            uint16_t* out, int dx, int dy) {
+    ChunkSnap* cs = s->chunks[ci];
+    World* w = s->w;
+    int cx = ci % s->ncx, cy = (ci / s->ncx) % s->ncy, cz = ci / (s->ncx*s->ncy);
+    int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+    size_t n = (size_t)(b[0]-a[0])*sizeof(uint16_t);
+    atomic_fetch_add(&cs->users, 1);             // before the copy is checked: see snapshot_retire
+    const uint16_t* ver = atomic_load(&cs->copy);
+    if (!ver) {
+        if (world_read_enter(w)) {   // detached before any replacement, so the world is still ours
+            ver = atomic_load_explicit(&cs->copy, memory_order_acquire);
+            const Chunk* c = &w->chunks[ci];
+            if (!ver && chunk_read_begin(c) == cs->seq) {
+                for (int z=a[2]; z<b[2]; z++)
+                for (int y=a[1]; y<b[1]; y++)
+                    memcpy(out + (size_t)(y-a[1])*dx + (size_t)(z-a[2])*dx*dy,
+                           &w->v[idx3D(w, x0+a[0], y0+y, z0+z)], n);
+                if (!chunk_read_retry(c, cs->seq)) {
+                    world_read_leave(w);
+                    atomic_fetch_sub(&cs->users, 1);
+                    return;
+                }
+            }
+            if (!ver) {
+                (void)chunk_read_begin(c);   // acquire the seq the edit moved: its copy was published first
+                ver = atomic_load_explicit(&cs->copy, memory_order_acquire);
+            }
+            world_read_leave(w);
+        } else {
+            ver = atomic_load_explicit(&cs->copy, memory_order_acquire);
+        }
+    }
+    atomic_fetch_sub(&cs->users, 1);             // the copy outlives the engine; the world does not
+    for (int z=a[2]; z<b[2]; z++)
+    for (int y=a[1]; y<b[1]; y++)
+        memcpy(out + (size_t)(y-a[1])*dx + (size_t)(z-a[2])*dx*dy,
+               ver + a[0] + y*CHUNK_SIZE + z*CHUNK_SIZE*CHUNK_SIZE, n);
+}
+
+void engine_snapshot_read_region(const EngineSnapshot* s, int x0,int y0,int z0, int dx,int dy,int dz, uint16_t* out) {
+    if (!s || !out || dx<=0 || dy<=0 || dz<=0) return;
+    // the part inside the world, [a, b); the rest reads as air (far ends in 64 bits, as engine_read_region)
+    int64_t ex = (int64_t)x0+dx, ey = (int64_t)y0+dy, ez = (int64_t)z0+dz;
+    int xa = x0<0?0:x0, xb = ex > s->sx ? s->sx : (int)ex;
+    int ya = y0<0?0:y0, yb = ey > s->sy ? s->sy : (int)ey;
+    int za = z0<0?0:z0, zb = ez > s->sz ? s->sz : (int)ez;
+    if (xa > x0 || ya > y0 || za > z0 || xb < ex || yb < ey || zb < ez)
+        memset(out, 0, (size_t)dx*dy*dz*sizeof(uint16_t));
+    if (xa>=xb || ya>=yb || za>=zb) return;
+    for (int cz=za/CHUNK_SIZE; cz<=(zb-1)/CHUNK_SIZE; cz++)
+    for (int cy=ya/CHUNK_SIZE; cy<=(yb-1)/CHUNK_SIZE; cy++)
+    for (int cx=xa/CHUNK_SIZE; cx<=(xb-1)/CHUNK_SIZE; cx++) {
+        int o[3] = { cx*CHUNK_SIZE, cy*CHUNK_SIZE, cz*CHUNK_SIZE };
+        int a[3] = { (xa>o[0]?xa:o[0])-o[0], (ya>o[1]?ya:o[1])-o[1], (za>o[2]?za:o[2])-o[2] };
+        int b[3] = { (xb<o[0]+CHUNK_SIZE?xb:o[0]+CHUNK_SIZE)-o[0],
+                     (yb<o[1]+CHUNK_SIZE?yb:o[1]+CHUNK_SIZE)-o[1],
+                     (zb<o[2]+CHUNK_SIZE?zb:o[2]+CHUNK_SIZE)-o[2] };
+        uint16_t* dst = out + (size_t)(o[0]+a[0]-x0) + (size_t)(o[1]+a[1]-y0)*dx + (size_t)(o[2]+a[2]-z0)*dx*dy;
+        snap_read_chunk(s, cx + cy*s->ncx + cz*s->ncx*s->ncy, a, b, dst, dx, dy);
+    }
+}
+
+void engine_release_snapshot(EngineSnapshot* s) {
+    if (!s) return;
+    int n = s->ncx*s->ncy*s->ncz;
+    for (int i=0; i<n; i++) snap_unref(s->chunks[i]);
+    free(s);
+}
@@ -0,0 +1,866 @@
+// sockserver.c — multi-client socket server for the wire protocol.
+//
+// Several controllers (world generator, editor, metrics scraper) connect to one
+// engine over a Unix-domain socket and/or TCP and speak the same JSON lines /
+// binary frames as the command server. There is no thread at all, let alone one
+// per client: engine_tick polls the listening and client sockets without
+// blocking (epoll on Linux, poll elsewhere), reads what is available and parses
+// it into per-client queues, then applies the queues at the tick boundary in a
+// fixed order — round-robin over clients in connection order, APPLY_BATCH
+// commands at a time, each client's commands in the order it sent them — so the
+// result never depends on which socket the kernel happened to report first.
+// How much a tick applies is a count too: up to APPLY_PER_TICK commands per
+// client, whatever the clock says, so the same streams give the same world tick
+// for tick. The command budget (engine_set_command_budget) is only a safety
+// limit for an overloaded server, checked between rounds; a tick cut short by it
+// is the one case where timing decides, so raise it when comparing runs.
+//
+// Replies (ready, ack, error) go to the sender only. Events and change records
+// go to the clients that asked for them with
+//     {"op":"subscribe","events":["key","mouse","player","change","world"]}
+// (nothing by default). Output is buffered per client and written without
+// blocking; a client that lets more than OUT_MAX bytes pile up is dropped.
+//
+// "world" replicates the world itself as binary frames (0xFF, op, u32 length,
+// payload, little-endian — the framing of the inbound protocol):
+//     0x81 world    i32 sx, sy, sz; u64 tick           (start over: drop every chunk)
+//     0x82 chunk    i32 cx, cy, cz; (u16 count, u16 id) runs over the chunk's voxels
+//                   clipped to the world, x fastest, then y, then z
+//     0x83 tick     u64 tick; u32 n; n x (i32 x, y, z; u16 id)   block deltas
+//     0x84 unload   u32 n; n x (i32 cx, cy, cz)        chunks that left the interest
+//     0x85 entities u64 tick; u32 n; n x (u32 id; f32 x, y, z)   other clients' views
+//     0x86 ack      u32 seq; f32 x, y, z, vel_y      player state after input `seq`
+// Interest: a subscriber gets the whole world until it sends
+//     {"op":"view","pos":[x,y,z],"radius":r}
+// which narrows it to the chunk columns within r chunks of pos (horizontally),
+// sent nearest first. Columns further than r+1 are unloaded — one column of
+// hysteresis so walking along a border does not thrash. Every tick each
+// subscriber gets one `tick` frame with that tick's block writes in chunks it
+// holds, then chunks it is missing, nearest first, at most repl_budget bytes per
+// tick. Box writes mark held chunks stale, which puts them back in that queue
+// instead of listing every voxel. `entities` lists the clients that sent a view
+// within the subscriber's radius; it is resent when that list or a position in
+// it changes.
+//
+// A client that sends `input` (seq, keys, yaw, pitch, dt) is a player. The server
+// owns its position: each input is stepped with player_step when it is applied,
+// stale or repeated sequence numbers are ignored, and once per tick the client
+// gets `ack` with the state after the newest input (netclient.c predicts ahead of
+// it and reconciles). A player's position is also its view centre and entity.
+// Each input's dt is clamped to PLAYER_DT_MAX, and all of a player's inputs
+// together may not move it further than the server's own clock: every tick adds
+// its dt to the player's credit (banking at most INPUT_SLACK beyond it, for
+// network jitter), and an input is stepped with no more than what is left.
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include "engine_internal.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <math.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#define APPLY_BATCH      256           // commands per client per round-robin round
+#define APPLY_PER_TICK   1024          // commands per client per tick: this decides what a tick applies
+#define CLIENT_QUEUE_MAX 8192          // parsed commands per client before we stop reading it
+#define INPUT_SLACK      0.1f          // seconds of movement a player may bank beyond the current tick
+#define READ_MAX         (1u<<20)      // bytes read per client per tick
+#define OUT_MAX          (8u<<20)      // unsent bytes before a client counts as stuck
+#define OUT_SNAPSHOT_MAX (1u<<20)      // stop feeding snapshot chunks while this much is unsent
+#define FRAME_WORLD      0x81
+#define FRAME_CHUNK      0x82
+#define FRAME_TICK       0x83
+#define FRAME_UNLOAD     0x84
+#define FRAME_ENTITIES   0x85
+#define FRAME_ACK        0x86
+#define AOI_RADIUS_MAX   32            // view radius cap, chunks
+
+enum { HELD_NONE, HELD_CURRENT, HELD_STALE };   // SockClient.has[]
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL        // a vanished peer is an error, not SIGPIPE
+#else
+#define SEND_FLAGS 0
+#endif
+
+typedef struct {
+    int fd;
+    uint32_t subs;                     // WIRE_SUB_*
+    WireParser parser;
+    uint8_t* in;  size_t in_len, in_cap;
+    WireCmd* q;   int q_head, q_len;   // FIFO [CLIENT_QUEUE_MAX]
+    char* out;    size_t out_len, out_cap;
+    bool eof;                          // peer finished sending: apply the rest, then drop
+    bool dead;                         // drop now
+    uint32_t uid;                      // entity id other clients see
+    // world replication
+    bool need_world;                   // send a world frame + restart the snapshot
+    bool complete;                     // holds every chunk of its interest, all current
+    uint8_t* has;                      // [nchunks] HELD_*
+    // area of interest
+    bool has_pos;                      // sent a view: it is an entity
+    float pos[3];
+    int  radius;                       // chunks, 0 = the whole world
+    int  ccx, ccy, ccz;                // chunk containing pos
+    bool view_moved;                   // unload check pending
+    uint64_t ents_hash;                // of the last entities frame, 0 = none or empty
+    // networked player: the server's copy is authoritative
+    bool has_player;
+    PlayerState player;
+    uint32_t input_seq;                // newest input applied
+    float dt_credit;                   // seconds its inputs may still step this tick
+    bool need_ack;
+} SockClient;
+
+typedef struct {                       // encoded chunk frame, NULL = changed since
+    uint8_t* data;
+    int len;
+} ChunkFrame;
+
+struct SockServer {
+    int listen_fd, tcp_fd;             // -1 when not listening
+#ifdef __linux__
+    int ep;
+#endif
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    SockClient** clients;              // connection order
+    int nclients, cap;
+    bool feed;                         // someone subscribed to changes or the world
+    uint64_t change_cursor;
+    uint32_t next_uid;
+
+    // world replication
+    int repl_budget;                   // snapshot bytes per client per tick
+    ChunkFrame* frames;                // [nchunks] encode once, send to everyone
+    uint8_t* resend;                   // [nchunks] box-written this tick
+    int* boxed; int nboxed;            // ... the same chunks as a list
+    int nchunks;
+    bool world_reset;                  // world recreated / feed lost: everyone starts over
+    uint8_t* delta;                    // this tick's tick frame, every block write
+    size_t delta_len, delta_cap;
+    uint32_t ndelta;
+    int* delta_ci;                     // [ndelta] chunk of each write
+    uint8_t* scratch;                  // per-client frames
+    size_t scratch_cap;
+    int16_t (*ring)[2];                // column offsets within AOI_RADIUS_MAX, nearest first
+    int nring;
+    bool ents_moved;                   // a view changed or its client left
+
+    EngineNetStats stats;
+    double tick_t0;                    // sockserver_poll start
+};
+
+static void set_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static void client_send(SockServer* s, SockClient* c, const void* data, size_t n) {
+    if (c->dead) return;
+    if (c->out_len + n > OUT_MAX) { c->dead = true; return; }   // not reading its socket
+    if (c->out_len + n > c->out_cap) {
+        size_t cap = (c->out_len + n)*2;
+        char* grown = (char*)realloc(c->out, cap);
+        if (!grown) { c->dead = true; return; }   // out of memory: drop the client, not the server
+        c->out = grown; c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, data, n);
+    c->out_len += n;
+    s->stats.bytes_tick += (uint32_t)n;
+}
+
+static void client_flush(SockClient* c) {
+    size_t sent = 0;
+    while (sent < c->out_len && !c->dead) {
+        ssize_t w = send(c->fd, c->out + sent, c->out_len - sent, SEND_FLAGS);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->dead = true;
+            break;
+        }
+        sent += (size_t)w;
+    }
+    if (!sent) return;
+    memmove(c->out, c->out + sent, c->out_len - sent);
+    c->out_len -= sent;
+}
+
+static void client_free(SockServer* s, SockClient* c) {
+#ifdef __linux__
+    epoll_ctl(s->ep, EPOLL_CTL_DEL, c->fd, NULL);
+#else
+    (void)s;
+#endif
+    close(c->fd);
+    for (int i=0;i<c->q_len;i++) free(c->q[(c->q_head + i) % CLIENT_QUEUE_MAX].data);
+    free(c->q); free(c->in); free(c->out); free(c->has);
+    free(c);
+}
+
+static void accept_clients(SockServer* s, int listen_fd) {
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) { if (errno == EINTR) continue; break; }   // EAGAIN: backlog empty
+        set_nonblocking(fd);
+        int one = 1;
+        if (listen_fd == s->tcp_fd) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);   // small tick frames
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+        SockClient* c = (SockClient*)calloc(1, sizeof(SockClient));
+        if (c) c->q = (WireCmd*)calloc(CLIENT_QUEUE_MAX, sizeof(WireCmd));
+        if (c && c->q && s->nclients == s->cap) {
+            int cap = s->cap ? s->cap*2 : 8;
+            SockClient** grown = (SockClient**)realloc(s->clients, cap*sizeof(SockClient*));
+            if (grown) { s->clients = grown; s->cap = cap; }
+        }
+        if (!c || !c->q || s->nclients == s->cap) {   // out of memory: turn it away
+            if (c) free(c->q);
+            free(c);
+            close(fd);
+            break;
+        }
+        c->fd = fd;
+        c->uid = ++s->next_uid;
+        s->clients[s->nclients++] = c;
+#ifdef __linux__
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        epoll_ctl(s->ep, EPOLL_CTL_ADD, fd, &ev);
+#endif
+    }
+}
+
+// Queue every complete message buffered in c->in, as far as the queue has room.
+static void client_parse(SockServer* s, SockClient* c) {
+    size_t start = 0, used = 0;
+    WireCmd cmd;
+    int k;
+    while (!c->dead && c->q_len < CLIENT_QUEUE_MAX &&
+           (k = wire_next(&c->parser, c->in + start, c->in_len - start, &used, &cmd)) != WIRE_NEED_MORE) {
+        if (k == WIRE_CORRUPT) { c->dead = true; break; }
+        start += used;
+        if (k == WIRE_CMD) c->q[(c->q_head + c->q_len++) % CLIENT_QUEUE_MAX] = cmd;
+        else if (c->parser.err) {
+            char buf[256];
+            int n = snprintf(buf, sizeof buf, "{\"event\":\"error\",\"msg\":\"%s\"}\n", c->parser.err);
+            client_send(s, c, buf, (size_t)n);
+        }
+    }
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+}
+
+// Read what the socket has (up to READ_MAX) and queue every complete message.
+static void client_read(SockServer* s, SockClient* c) {
+    size_t got = 0;
+    while (!c->eof && !c->dead && got < READ_MAX && c->q_len < CLIENT_QUEUE_MAX) {
+        if (c->in_cap - c->in_len < 4096) {
+            size_t cap = c->in_cap ? c->in_cap*2 : 1<<16;
+            uint8_t* grown = (uint8_t*)realloc(c->in, cap);
+            if (!grown) { c->dead = true; break; }
+            c->in = grown; c->in_cap = cap;
+        }
+        ssize_t r = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->dead = true;
+            break;
+        }
+        if (r == 0) { c->eof = true; break; }
+        c->in_len += (size_t)r;
+        got += (size_t)r;
+        client_parse(s, c);
+    }
+}
+
+// New view centre and radius (chunks, 0 = whole world); also the client's entity position.
+static void client_move(SockServer* s, SockClient* c, const float pos[3], int radius) {
+    int r = radius < 0 ? 0 : radius > AOI_RADIUS_MAX ? AOI_RADIUS_MAX : radius;
+    int ccx = (int)floorf(pos[0]/CHUNK_SIZE), ccy = (int)floorf(pos[1]/CHUNK_SIZE), ccz = (int)floorf(pos[2]/CHUNK_SIZE);
+    if (!c->has_pos || r != c->radius || ccx != c->ccx || ccz != c->ccz) { c->view_moved = true; c->complete = false; }
+    if (!c->has_pos || memcmp(c->pos, pos, sizeof c->pos)) s->ents_moved = true;
+    memcpy(c->pos, pos, sizeof c->pos);
+    c->radius = r;
+    c->ccx = ccx; c->ccy = ccy; c->ccz = ccz;
+    c->has_pos = true;
+}
+
+static void apply_one(Engine* e, SockServer* s, SockClient* c, WireCmd* cmd) {
+    if (cmd->op == WIRE_OP_SUBSCRIBE) {
+        uint32_t was = c->subs;
+        c->subs = (uint32_t)cmd->a[0];
+        if ((c->subs & (WIRE_SUB_CHANGE | WIRE_SUB_WORLD)) && !s->feed) {
+            engine_set_change_feed(e, true);
+            s->change_cursor = engine_change_cursor(e);
+            s->feed = true;
+        }
+        if ((c->subs & WIRE_SUB_WORLD) && !(was & WIRE_SUB_WORLD)) c->need_world = true;
+        return;
+    }
+    if (cmd->op == WIRE_OP_VIEW) {
+        client_move(s, c, cmd->f, cmd->a[0]);
+        return;
+    }
+    if (cmd->op == WIRE_OP_INPUT) {
+        uint32_t seq = (uint32_t)cmd->a[0];
+        if (c->has_player && (int32_t)(seq - c->input_seq) <= 0) return;   // duplicate or out of date
+        if (!c->has_player) c->player = (PlayerState){ e->cam.position, 0 };   // spawn at the server camera
+        float dt = player_input_dt(cmd->f[2]);
+        if (dt > c->dt_credit) dt = c->dt_credit;   // faster than the server's clock: drop the excess
+        c->dt_credit -= dt;
+        player_step(e, &c->player, (uint8_t)cmd->a[1], cmd->f[0], cmd->f[1], dt);
+        c->has_player = c->need_ack = true;
+        c->input_seq = seq;
+        float pos[3] = { c->player.pos.x, c->player.pos.y, c->player.pos.z };
+        client_move(s, c, pos, c->radius);
+        return;
+    }
+    const char* reply = wire_apply(e, cmd);
+    if (reply) client_send(s, c, reply, strlen(reply));
+}
+
+void sockserver_poll(Engine* e, float dt) {
+    SockServer* s = e->sock;
+    if (!s) return;
+    s->tick_t0 = stats_now();
+    s->stats.bytes_tick = 0;
+
+    // 1. I/O: accept + read whatever is ready, never block. Bytes left over from a
+    // full queue are parsed first: the socket may have nothing more to report.
+    for (int i=0;i<s->nclients;i++)
+        if (s->clients[i]->in_len) client_parse(s, s->clients[i]);
+#ifdef __linux__
+    struct epoll_event evs[256];       // level-triggered: anything left over is reported next tick
+    int n = epoll_wait(s->ep, evs, 256, 0);
+    for (int i=0;i<n;i++) {
+        void* p = evs[i].data.ptr;
+        if (p == &s->listen_fd || p == &s->tcp_fd) accept_clients(s, *(int*)p);
+        else client_read(s, (SockClient*)p);
+    }
+#else
+    struct pollfd* pfd = (struct pollfd*)malloc((size_t)(s->nclients + 2)*sizeof(struct pollfd));
+    int nfds = pfd ? s->nclients + 2 : 0;   // out of memory: no I/O this tick, the sockets keep it
+    if (nfds) {
+        pfd[0] = (struct pollfd){ s->listen_fd, POLLIN, 0 };   // fd -1 is ignored by poll
+        pfd[1] = (struct pollfd){ s->tcp_fd, POLLIN, 0 };
+        for (int i=0;i<s->nclients;i++) pfd[i+2] = (struct pollfd){ s->clients[i]->fd, POLLIN, 0 };
+    }
+    if (nfds && poll(pfd, (nfds_t)nfds, 0) > 0) {
+        for (int i=2;i<nfds;i++) if (pfd[i].revents) client_read(s, s->clients[i-2]);
+        if (pfd[0].revents) accept_clients(s, s->listen_fd);
+        if (pfd[1].revents) accept_clients(s, s->tcp_fd);
+    }
+    free(pfd);
+#endif
+
+    // 2. apply at the tick boundary: round-robin in connection order, FIFO per client
+    for (int i=0;i<s->nclients;i++) {
+        SockClient* c = s->clients[i];
+        c->dt_credit += dt;
+        if (c->dt_credit > dt + INPUT_SLACK) c->dt_credit = dt + INPUT_SLACK;
+    }
+    double limit = stats_now() + e->cmd_budget_ms*0.001;   // safety only, see the top of the file
+    bool more = true;
+    for (int round=0; more && round < APPLY_PER_TICK/APPLY_BATCH; round++) {
+        if (round && stats_now() >= limit) break;
+        more = false;
+        for (int i=0;i<s->nclients;i++) {
+            SockClient* c = s->clients[i];
+            int take = c->q_len < APPLY_BATCH ? c->q_len : APPLY_BATCH;
+            for (int k=0;k<take;k++) apply_one(e, s, c, &c->q[(c->q_head + k) % CLIENT_QUEUE_MAX]);
+            c->q_head = (c->q_head + take) % CLIENT_QUEUE_MAX;
+            c->q_len -= take;
+            if (c->q_len) more = true;
+        }
+    }
+
+    // 3. flush replies, drop finished clients (order of the rest is kept)
+    int keep = 0;
+    for (int i=0;i<s->nclients;i++) {
+        SockClient* c = s->clients[i];
+        client_flush(c);
+        if (c->eof && !c->q_len) client_parse(s, c);   // the rest of what it sent, if any
+        if (c->dead || (c->eof && !c->q_len)) {
+            if (c->has_pos) s->ents_moved = true;
+            client_free(s, c);
+        }
+        else s->clients[keep++] = c;
+    }
+    s->nclients = keep;
+    s->stats.net_ms = (float)((stats_now() - s->tick_t0)*1000.0);
+}
+
+void sockserver_event(Engine* e, const EngineEvent* ev) {
+    SockServer* s = e->sock;
+    char buf[256];
+    uint32_t cls = wire_event_json(ev, buf, sizeof buf);
+    if (!cls) return;
+    size_t n = strlen(buf);
+    for (int i=0;i<s->nclients;i++)
+        if (s->clients[i]->subs & cls) client_send(s, s->clients[i], buf, n);
+}
+
+// ---- world replication ----
+
+static void put_frame_header(uint8_t* p, uint8_t op, uint32_t len) {
+    p[0] = 0xFF; p[1] = op;
+    memcpy(p + 2, &len, 4);   // little-endian hosts only, like the rest of the wire format
+}
+
+static void frames_free(SockServer* s) {
+    for (int i=0;i<s->nchunks;i++) free(s->frames[i].data);
+    free(s->frames); free(s->resend); free(s->boxed);
+    s->frames = NULL; s->resend = NULL; s->boxed = NULL; s->nchunks = s->nboxed = 0;
+}
+
+// False when out of memory: no frames, and the reset is tried again next tick.
+static bool frames_resize(SockServer* s, const World* w) {
+    frames_free(s);
+    int n = w->v ? w->ncx*w->ncy*w->ncz : 0;
+    s->frames = (ChunkFrame*)calloc(n ? n : 1, sizeof(ChunkFrame));
+    s->resend = (uint8_t*)calloc(n ? n : 1, 1);
+    s->boxed = (int*)malloc((n ? n : 1)*sizeof(int));
+    if (!s->frames || !s->resend || !s->boxed) { frames_free(s); return false; }
+    s->nchunks = n;
+    return true;
+}
+
+// Per-client frame buffer; NULL when out of memory.
+static uint8_t* scratch(SockServer* s, size_t n) {
+    if (n > s->scratch_cap) {
+        uint8_t* grown = (uint8_t*)realloc(s->scratch, n*2);
+        if (!grown) return NULL;
+        s->scratch = grown; s->scratch_cap = n*2;
+    }
+    return s->scratch;
+}
+
+static void chunk_changed(SockServer* s, int ci, bool box) {
+    if (ci < 0 || ci >= s->nchunks) return;
+    free(s->frames[ci].data);
+    s->frames[ci].data = NULL;
+    if (box && !s->resend[ci]) { s->resend[ci] = 1; s->boxed[s->nboxed++] = ci; }
+}
+
+// Chunk frame for chunk ci, encoded on first use after it changed. NULL when out of memory.
+static const ChunkFrame* chunk_frame(SockServer* s, const World* w, int ci) {
+    ChunkFrame* f = &s->frames[ci];
+    if (f->data) return f;
+    int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+    int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+    int x1 = x0+CHUNK_SIZE < w->sx ? x0+CHUNK_SIZE : w->sx;
+    int y1 = y0+CHUNK_SIZE < w->sy ? y0+CHUNK_SIZE : w->sy;
+    int z1 = z0+CHUNK_SIZE < w->sz ? z0+CHUNK_SIZE : w->sz;
+
+    uint8_t* buf = (uint8_t*)malloc(6 + 12 + 4*CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE);   // worst case: no runs
+    if (!buf) return NULL;
+    int32_t hdr[3] = { cx, cy, cz };
+    memcpy(buf + 6, hdr, 12);
+    int n = 18;
+    uint16_t run_id = 0, run_len = 0;
+    for (int z=z0; z<z1; z++)
+    for (int y=y0; y<y1; y++) {
+        const uint16_t* row = w->v + idx3D(w, 0, y, z);
+        for (int x=x0; x<x1; x++) {
+            if (run_len && (row[x] != run_id || run_len == 0xFFFF)) {
+                memcpy(buf + n, &run_len, 2); memcpy(buf + n + 2, &run_id, 2); n += 4;
+                run_len = 0;
+            }
+            run_id = row[x]; run_len++;
+        }
+    }
+    if (run_len) { memcpy(buf + n, &run_len, 2); memcpy(buf + n + 2, &run_id, 2); n += 4; }
+    put_frame_header(buf, FRAME_CHUNK, (uint32_t)(n - 6));
+    uint8_t* fit = (uint8_t*)realloc(buf, n);
+    f->data = fit ? fit : buf;
+    f->len = n;
+    return f;
+}
+
+static void delta_reset(SockServer* s, uint64_t tick) {
+    memcpy(s->delta + 6, &tick, 8);
+    s->delta_len = 18;
+    s->ndelta = 0;
+}
+
+static void delta_add(SockServer* s, int x, int y, int z, uint16_t id, int ci) {
+    if (s->delta_len + 14 > s->delta_cap) {
+        size_t cap = s->delta_cap*2;
+        uint8_t* d = (uint8_t*)realloc(s->delta, cap);
+        if (d) s->delta = d;
+        int* dci = d ? (int*)realloc(s->delta_ci, (cap/14)*sizeof(int)) : NULL;
+        if (!dci) { s->world_reset = true; return; }   // out of memory: resend every world instead
+        s->delta_ci = dci; s->delta_cap = cap;
+    }
+    int32_t p[3] = { x, y, z };
+    memcpy(s->delta + s->delta_len, p, 12);
+    memcpy(s->delta + s->delta_len + 12, &id, 2);
+    s->delta_len += 14;
+    s->delta_ci[s->ndelta++] = ci;
+}
+
+// Fold one change record into this tick's replication state.
+static void repl_record(SockServer* s, const World* w, const EngineChange* c) {
+    if (c->kind == ENGINE_CHANGE_RESET) { s->world_reset = true; return; }
+    if (s->world_reset || !s->nchunks) return;   // everything is resent anyway
+    if (c->kind == ENGINE_CHANGE_BLOCK) {
+        int ci = chunkIndex(w, c->x0/CHUNK_SIZE, c->y0/CHUNK_SIZE, c->z0/CHUNK_SIZE);
+        delta_add(s, c->x0, c->y0, c->z0, c->new_id, ci);
+        chunk_changed(s, ci, false);
+        return;
+    }
+    for (int cz=c->z0/CHUNK_SIZE; cz<=c->z1/CHUNK_SIZE && cz<w->ncz; cz++)
+    for (int cy=c->y0/CHUNK_SIZE; cy<=c->y1/CHUNK_SIZE && cy<w->ncy; cy++)
+    for (int cx=c->x0/CHUNK_SIZE; cx<=c->x1/CHUNK_SIZE && cx<w->ncx; cx++)
+        chunk_changed(s, chunkIndex(w, cx, cy, cz), true);
+}
+
+// Send chunk ci unless the client holds it current; false once this tick's budget is spent.
+static bool offer_chunk(SockServer* s, SockClient* c, const World* w, int ci, uint32_t start) {
+    if (c->has[ci] == HELD_CURRENT) return true;
+    if (s->stats.bytes_tick - start >= (uint32_t)s->repl_budget || c->out_len >= OUT_SNAPSHOT_MAX || c->dead) return false;
+    const ChunkFrame* f = chunk_frame(s, w, ci);
+    if (!f) return false;          // out of memory: streamed on a later tick
+    client_send(s, c, f->data, (size_t)f->len);
+    c->has[ci] = HELD_CURRENT;
+    s->stats.chunks_tick++;
+    return true;
+}
+
+// Chunks the client is missing or holds stale, nearest first, within repl_budget.
+static void stream_chunks(SockServer* s, SockClient* c, const World* w) {
+    uint32_t start = s->stats.bytes_tick;
+    if (!c->radius) {              // whole world: index order
+        for (int ci=0; ci<s->nchunks; ci++) if (!offer_chunk(s, c, w, ci, start)) return;
+        c->complete = true;
+        return;
+    }
+    int r2 = c->radius*c->radius;
+    int cy0 = c->ccy < 0 ? 0 : c->ccy >= w->ncy ? w->ncy-1 : c->ccy;
+    for (int i=0; i<s->nring; i++) {
+        int dx = s->ring[i][0], dz = s->ring[i][1];
+        if (dx*dx + dz*dz > r2) break;
+        int cx = c->ccx + dx, cz = c->ccz + dz;
+        if (cx < 0 || cz < 0 || cx >= w->ncx || cz >= w->ncz) continue;
+        for (int k=0; k<2*w->ncy; k++) {   // the camera's level first, then alternately below/above
+            int cy = cy0 + ((k & 1) ? -(k+1)/2 : k/2);
+            if (cy < 0 || cy >= w->ncy) continue;
+            if (!offer_chunk(s, c, w, chunkIndex(w, cx, cy, cz), start)) return;
+        }
+    }
+    c->complete = true;
+}
+
+// Unload frame for held columns more than radius+1 from the view.
+static void unload_outside(SockServer* s, SockClient* c, const World* w) {
+    if (!c->radius) { c->view_moved = false; return; }
+    int keep = (c->radius + 1)*(c->radius + 1);
+    uint8_t* buf = scratch(s, 10 + 12*(size_t)s->nchunks);
+    if (!buf) return;              // tried again next tick
+    c->view_moved = false;
+    uint32_t n = 0;
+    for (int ci=0; ci<s->nchunks; ci++) {
+        if (c->has[ci] == HELD_NONE) continue;
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        int dx = cx - c->ccx, dz = cz - c->ccz;
+        if (dx*dx + dz*dz <= keep) continue;
+        int32_t p[3] = { cx, cy, cz };
+        memcpy(buf + 10 + 12*n++, p, 12);
+        c->has[ci] = HELD_NONE;
+    }
+    if (!n) return;
+    put_frame_header(buf, FRAME_UNLOAD, 4 + 12*n);
+    memcpy(buf + 6, &n, 4);
+    client_send(s, c, buf, 10 + 12*(size_t)n);
+    s->stats.unloads_tick += n;
+}
+
+// This tick's block writes, keeping only those in chunks the client holds current.
+static void send_deltas(SockServer* s, SockClient* c) {
+    if (c->complete && !c->radius) { client_send(s, c, s->delta, s->delta_len); return; }   // holds it all
+    uint8_t* buf = scratch(s, s->delta_len);
+    if (!buf) { c->dead = true; return; }   // a missed tick frame would leave it out of sync
+    memcpy(buf + 6, s->delta + 6, 8);
+    uint32_t n = 0;
+    for (uint32_t k=0; k<s->ndelta; k++)
+        if (c->has[s->delta_ci[k]] == HELD_CURRENT) memcpy(buf + 18 + 14*n++, s->delta + 18 + 14*k, 14);
+    put_frame_header(buf, FRAME_TICK, 12 + 14*n);
+    memcpy(buf + 14, &n, 4);
+    client_send(s, c, buf, 18 + 14*(size_t)n);
+}
+
+// Every other client with a view inside this client's radius, when that list changed.
+static void send_entities(Engine* e, SockServer* s, SockClient* c) {
+    uint8_t* buf = scratch(s, 18 + 16*(size_t)s->nclients);
+    if (!buf) { c->dead = true; return; }   // its entity list would stay stale
+    float reach = (float)(c->radius*CHUNK_SIZE);
+    uint32_t n = 0;
+    for (int i=0;i<s->nclients;i++) {
+        const SockClient* o = s->clients[i];
+        if (o == c || !o->has_pos || o->dead) continue;
+        float dx = o->pos[0] - c->pos[0], dz = o->pos[2] - c->pos[2];
+        if (c->radius && (!c->has_pos || dx*dx + dz*dz > reach*reach)) continue;
+        memcpy(buf + 18 + 16*n, &o->uid, 4);
+        memcpy(buf + 22 + 16*n, o->pos, 12);
+        n++;
+    }
+    uint64_t h = 0;                // FNV-1a over the records: resend only what changed
+    for (size_t k=0; k<16*(size_t)n; k++) h = (h ^ buf[18 + k]) * 0x100000001b3ull;
+    if (h == c->ents_hash) return;
+    c->ents_hash = h;
+    uint64_t tick = e->ticks;
+    put_frame_header(buf, FRAME_ENTITIES, 12 + 16*n);
+    memcpy(buf + 6, &tick, 8);
+    memcpy(buf + 14, &n, 4);
+    client_send(s, c, buf, 18 + 16*(size_t)n);
+}
+
+static void repl_client(Engine* e, SockServer* s, SockClient* c) {
+    const World* w = &e->world;
+    if (!w->v) return;
+    if (c->need_world) {
+        uint8_t hdr[6 + 20];
+        int32_t dims[3] = { w->sx, w->sy, w->sz };
+        uint64_t tick = e->ticks;
+        put_frame_header(hdr, FRAME_WORLD, 20);
+        memcpy(hdr + 6, dims, 12); memcpy(hdr + 18, &tick, 8);
+        uint8_t* has = (uint8_t*)realloc(c->has, s->nchunks ? (size_t)s->nchunks : 1);
+        if (!has) { c->dead = true; return; }
+        c->has = has;
+        client_send(s, c, hdr, sizeof hdr);
+        memset(c->has, HELD_NONE, (size_t)s->nchunks);
+        c->need_world = c->complete = c->view_moved = false;
+    }
+    for (int i=0; i<s->nboxed; i++)
+        if (c->has[s->boxed[i]] == HELD_CURRENT) { c->has[s->boxed[i]] = HELD_STALE; c->complete = false; }
+    if (c->view_moved) unload_outside(s, c, w);
+    send_deltas(s, c);
+    if (s->ents_moved) send_entities(e, s, c);
+    if (!c->complete) stream_chunks(s, c, w);
+}
+
+static void replicate(Engine* e, SockServer* s, int nworld) {
+    if (s->world_reset) {
+        if (!frames_resize(s, &e->world)) return;
+        for (int i=0;i<s->nclients;i++) if (s->clients[i]->subs & WIRE_SUB_WORLD) s->clients[i]->need_world = true;
+        s->world_reset = false;
+        delta_reset(s, e->ticks);   // block writes before the reset are in the new snapshot
+    }
+    s->stats.deltas_tick = s->ndelta;
+    if (nworld) {
+        put_frame_header(s->delta, FRAME_TICK, (uint32_t)(s->delta_len - 6));
+        memcpy(s->delta + 14, &s->ndelta, 4);
+        for (int i=0;i<s->nclients;i++) {
+            SockClient* c = s->clients[i];
+            if (!(c->subs & WIRE_SUB_WORLD)) continue;
+            repl_client(e, s, c);
+            if (!c->complete) s->stats.snapshots_pending++;
+        }
+    }
+    for (int i=0; i<s->nboxed; i++) s->resend[s->boxed[i]] = 0;
+    s->nboxed = 0;
+    s->ents_moved = false;
+}
+
+void sockserver_publish(Engine* e) {
+    SockServer* s = e->sock;
+    if (!s) return;
+    double t0 = stats_now();
+    s->stats.chunks_tick = 0;
+    s->stats.unloads_tick = 0;
+    s->stats.snapshots_pending = 0;
+    int nchange = 0, nworld = 0;
+    for (int i=0;i<s->nclients;i++) {
+        nchange += (s->clients[i]->subs & WIRE_SUB_CHANGE) != 0;
+        nworld  += (s->clients[i]->subs & WIRE_SUB_WORLD) != 0;
+    }
+    s->stats.clients = s->nclients;
+    s->stats.world_clients = nworld;
+
+    if (s->feed) {
+        EngineChange recs[256];
+        char buf[256];
+        int n;
+        // Feed turned off since last tick: re-enable it and keep our cursor, which now reads
+        // as stale (-1 below), so clients hear about the edits made while it was off.
+        if (!e->changes) engine_set_change_feed(e, true);
+        if (!s->frames) s->world_reset = true;
+        delta_reset(s, e->ticks);
+        while ((n = engine_read_changes(e, &s->change_cursor, recs, 256)) != 0) {
+            if (n < 0) {   // fell behind the ring or the feed was off: change subscribers re-read, world subscribers start over
+                static const char kLost[] = "{\"event\":\"changes_lost\"}\n";
+                for (int i=0;i<s->nclients;i++)
+                    if (s->clients[i]->subs & WIRE_SUB_CHANGE) client_send(s, s->clients[i], kLost, sizeof kLost - 1);
+                s->change_cursor = engine_change_cursor(e);
+                s->world_reset = true;
+                break;
+            }
+            for (int r=0;r<n;r++) {
+                if (nworld) repl_record(s, &e->world, &recs[r]);
+                if (!nchange) continue;
+                size_t len = (size_t)wire_change_json(&recs[r], buf, sizeof buf);
+                for (int i=0;i<s->nclients;i++)
+                    if (s->clients[i]->subs & WIRE_SUB_CHANGE) client_send(s, s->clients[i], buf, len);
+            }
+        }
+        if (!nworld) {             // cached frames would miss the changes we just skipped
+            if (s->nchunks) frames_free(s);
+        } else {
+            replicate(e, s, nworld);
+        }
+    }
+    for (int i=0;i<s->nclients;i++) {
+        SockClient* c = s->clients[i];
+        if (c->need_ack) {
+            uint8_t f[6 + 20];
+            float st[4] = { c->player.pos.x, c->player.pos.y, c->player.pos.z, c->player.vel_y };
+            put_frame_header(f, FRAME_ACK, 20);
+            memcpy(f + 6, &c->input_seq, 4); memcpy(f + 10, st, 16);
+            client_send(s, c, f, sizeof f);
+            c->need_ack = false;
+        }
+        client_flush(c);
+    }
+
+    s->stats.net_ms += (float)((stats_now() - t0)*1000.0);
+    s->stats.bytes_total += s->stats.bytes_tick;
+}
+
+// ---- setup ----
+
+static int ring_cmp(const void* a, const void* b) {
+    const int16_t* p = (const int16_t*)a; const int16_t* q = (const int16_t*)b;
+    int d = (p[0]*p[0] + p[1]*p[1]) - (q[0]*q[0] + q[1]*q[1]);
+    return d ? d : p[1] != q[1] ? p[1] - q[1] : p[0] - q[0];   // ties in a fixed order
+}
+
+static SockServer* server_get(Engine* e) {
+    if (e->sock) return e->sock;
+    SockServer* s = (SockServer*)calloc(1, sizeof(SockServer));
+    if (!s) return NULL;
+    s->listen_fd = s->tcp_fd = -1;
+    s->repl_budget = 64*1024;
+    const int R = AOI_RADIUS_MAX;
+    s->ring = (int16_t(*)[2])malloc((size_t)(2*R+1)*(2*R+1)*sizeof *s->ring);
+    s->delta_cap = 4096;           // tick frame header + 291 writes, grown by delta_add
+    s->delta = (uint8_t*)malloc(s->delta_cap);
+    s->delta_ci = (int*)malloc((s->delta_cap/14)*sizeof(int));
+    if (!s->ring || !s->delta || !s->delta_ci) {
+        free(s->ring); free(s->delta); free(s->delta_ci); free(s);
+        return NULL;
+    }
+    for (int dz=-R; dz<=R; dz++)
+    for (int dx=-R; dx<=R; dx++)
+        if (dx*dx + dz*dz <= R*R) { s->ring[s->nring][0] = (int16_t)dx; s->ring[s->nring][1] = (int16_t)dz; s->nring++; }
+    qsort(s->ring, (size_t)s->nring, sizeof *s->ring, ring_cmp);
+#ifdef __linux__
+    s->ep = epoll_create1(0);
+    if (s->ep < 0) { free(s->ring); free(s->delta); free(s->delta_ci); free(s); return NULL; }
+#endif
+    e->sock = s;
+    return s;
+}
+
+static bool server_listen(SockServer* s, int fd, int* slot) {
+    set_nonblocking(fd);
+#ifdef __linux__
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = slot };   // &listen_fd / &tcp_fd
+    if (epoll_ctl(s->ep, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+#endif
+    *slot = fd;
+    return true;
+}
+
+bool engine_start_socket_server(Engine* e, const char* path) {
+    if (!e || !path || (e->sock && e->sock->listen_fd >= 0)) return false;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof addr.sun_path) return false;
+    strcpy(addr.sun_path, path);
+
+    SockServer* s = server_get(e);
+    if (!s) return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    unlink(path);   // stale socket from a previous run
+    if (bind(fd, (struct sockaddr*)&addr, sizeof addr) != 0 || listen(fd, 64) != 0 ||
+        !server_listen(s, fd, &s->listen_fd)) {
+        close(fd); unlink(path);
+        return false;
+    }
+    strcpy(s->path, path);
+    return true;
+}
+
+bool engine_start_tcp_server(Engine* e, const char* host, int port) {
+    if (!e || port <= 0 || port > 65535 || (e->sock && e->sock->tcp_fd >= 0)) return false;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host ? host : "127.0.0.1", &addr.sin_addr) != 1) return false;
+
+    SockServer* s = server_get(e);
+    if (!s) return false;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof addr) != 0 || listen(fd, 256) != 0 ||
+        !server_listen(s, fd, &s->tcp_fd)) {
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+void engine_stop_socket_server(Engine* e) {
+    if (!e || !e->sock) return;
+    SockServer* s = e->sock;
+    for (int i=0;i<s->nclients;i++) client_free(s, s->clients[i]);
+    free(s->clients);
+#ifdef __linux__
+    close(s->ep);
+#endif
+    if (s->listen_fd >= 0) { close(s->listen_fd); unlink(s->path); }
+    if (s->tcp_fd >= 0) close(s->tcp_fd);
+    frames_free(s);
+    free(s->delta); free(s->delta_ci); free(s->scratch); free(s->ring);
+    free(s);
+    e->sock = NULL;
+}
+
+void engine_set_replication_budget(Engine* e, int bytes_per_tick) {
+    SockServer* s = e ? server_get(e) : NULL;
+    if (s) s->repl_budget = bytes_per_tick > 0 ? bytes_per_tick : 1;
+}
+
+bool engine_get_net_stats(Engine* e, EngineNetStats* out) {
+    if (!e || !out || !e->sock) return false;
+    *out = e->sock->stats;
+    return true;
+}
+
+#else  // _WIN32: no AF_UNIX / epoll here yet — drive the engine through the C API instead
+
+void sockserver_poll(Engine* e, float dt) { (void)e; (void)dt; }
+void sockserver_event(Engine* e, const EngineEvent* ev) { (void)e; (void)ev; }
+void sockserver_publish(Engine* e) { (void)e; }
+bool engine_start_socket_server(Engine* e, const char* path) { (void)e; (void)path; return false; }
+bool engine_start_tcp_server(Engine* e, const char* host, int port) { (void)e; (void)host; (void)port; return false; }
+void engine_stop_socket_server(Engine* e) { (void)e; }
+void engine_set_replication_budget(Engine* e, int bytes_per_tick) { (void)e; (void)bytes_per_tick; }
+bool engine_get_net_stats(Engine* e, EngineNetStats* out) { (void)e; (void)out; return false; }
+
+#endif
@@ -0,0 +1,523 @@
+// softrast.c — CPU rasterizer: chunk meshes into an in-memory RGBA8 + depth target.
+//
+// ENGINE_RENDER_SOFTWARE draws the same culled, LOD-selected chunk meshes as the
+// meshed renderer without a GPU, so a headless engine (build machines) exercises
+// meshing and culling, produces images to diff against golden files, and reports
+// timings. A frame runs in two parallel phases on a small worker pool:
+//   1. setup: each worker takes a fixed slice of the visible chunks (in draw
+//      order), transforms triangles to clip space, clips them against the near
+//      plane and a guard band, culls back faces, snaps vertices to 1/16 pixel and
+//      bins each triangle into the 64x64 pixel tiles its bounding box touches;
+//   2. raster: workers pull tiles off a counter, clear them and rasterize their
+//      bins in slice order with integer edge functions (top-left fill rule), four
+//      pixels per step with SSE2 where available, depth-tested on NDC z.
+// A tile always sees its triangles in the same order, so the image does not depend
+// on the number of workers. Faces are flat-shaded from the mesh vertex colours
+// (the meshed renderer does not texture either); nothing but chunks is drawn.
+#include "engine_internal.h"
+#include <math.h>
+#include <stdio.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFT_SSE2 1
+#endif
+
+#define SOFT_TILE        64
+#define SOFT_SUB         16           // sub-pixel positions per pixel (4 bits)
+#define SOFT_GUARD       4.0f         // guard band, in NDC half-extents: keeps edge math in 32 bits
+#define SOFT_MAX_DIM     4096
+#define SOFT_MAX_THREADS 8
+#define SOFT_CLEAR       0xFFF5F5F5u  // RAYWHITE, RGBA8 in memory order
+
+typedef struct {
+    int32_t  x[3], y[3];      // 1/16 pixel, clockwise on screen (front faces)
+    int32_t  minx, miny, maxx, maxy;   // covered pixel range, inclusive, inside the target
+    float    fx, fy, z;       // vertex 0 in pixels and its NDC depth...
+    float    dzdx, dzdy;      // ... and the depth gradient per pixel
+    uint32_t rgba;
+} SoftTri;
+
+typedef struct { int* idx; int n, cap; } SoftList;
+typedef struct { struct SoftRaster* s; int id; } SoftWorker;
+
+typedef struct {              // one worker's setup output
+    SoftTri* tris;
+    int      ntris, cap;
+    SoftList* bins;           // [tile count] indices into tris, in submission order
+    int      chunks, triangles;
+} SoftBin;
+
+struct SoftRaster {
+    int w, h, tiles_x, tiles_y;
+    uint32_t* color;          // [w*h] RGBA8, top row first
+    float*    depth;          // [w*h] NDC z, cleared to 1 (the far plane)
+    uint64_t  frames;
+    int       nthreads;       // workers running, this thread included
+    int       nbins;
+    SoftBin*  bins;           // [nbins] (>= nthreads: some threads may not have started)
+
+    // the frame being drawn
+    const Engine* e;
+    Matrix    vp;
+    const Mesh** meshes;      // [nvis] mesh for each e->vis entry, NULL = nothing to draw
+    int       nvis, meshes_cap;
+    _Atomic int next_tile;
+
+#ifndef _WIN32
+    pthread_t* threads;       // [nthreads-1]; this thread is worker 0
+    SoftWorker* workers;      // [nthreads-1] thread arguments
+    pthread_mutex_t mu;
+    pthread_cond_t  go, done;
+    void    (*job)(struct SoftRaster*, int);
+    unsigned  gen;
+    int       busy;
+    bool      quit;
+#endif
+
+    Texture2D tex;            // windowed: the frame on screen
+    bool      tex_loaded;
+};
+
+// ---------- setup ----------
+
+// Out of memory drops the triangle from this tile only; the frame goes on.
+static void bin_push(SoftList* l, int v) {
+    if (l->n == l->cap) {
+        int cap = l->cap ? l->cap*2 : 64;
+        int* idx = (int*)realloc(l->idx, (size_t)cap*sizeof(int));
+        if (!idx) return;
+        l->idx = idx; l->cap = cap;
+    }
+    l->idx[l->n++] = v;
+}
+
+// Project a clip-space triangle (w > 0 after clipping), cull it if it faces away,
+// snap it and bin it.
+static void emit_tri(SoftRaster* s, SoftBin* b, const Vector4 v[3], uint32_t rgba) {
+    int32_t X[3], Y[3];
+    float fx[3], fy[3], z[3];
+    for (int i=0;i<3;i++) {
+        float iw = 1.0f/v[i].w;
+        X[i] = (int32_t)lrintf((v[i].x*iw*0.5f + 0.5f) * s->w * SOFT_SUB);
+        Y[i] = (int32_t)lrintf((0.5f - v[i].y*iw*0.5f) * s->h * SOFT_SUB);
+        fx[i] = (float)X[i]/SOFT_SUB; fy[i] = (float)Y[i]/SOFT_SUB;
+        z[i] = v[i].z*iw;
+    }
+    // counter-clockwise in NDC (raylib's front faces) is clockwise on the y-down screen
+    int64_t area = (int64_t)(X[1]-X[0])*(Y[2]-Y[0]) - (int64_t)(Y[1]-Y[0])*(X[2]-X[0]);
+    if (area <= 0) return;
+
+    int32_t lx = X[0], hx = X[0], ly = Y[0], hy = Y[0];
+    for (int i=1;i<3;i++) {
+        if (X[i] < lx) lx = X[i];
+        if (X[i] > hx) hx = X[i];
+        if (Y[i] < ly) ly = Y[i];
+        if (Y[i] > hy) hy = Y[i];
+    }
+    // pixel centres (px*16+8) inside the box
+    int minx = (lx + SOFT_SUB/2 - 1) >> 4, maxx = (hx - SOFT_SUB/2) >> 4;
+    int miny = (ly + SOFT_SUB/2 - 1) >> 4, maxy = (hy - SOFT_SUB/2) >> 4;
+    if (minx < 0) minx = 0;
+    if (miny < 0) miny = 0;
+    if (maxx > s->w-1) maxx = s->w-1;
+    if (maxy > s->h-1) maxy = s->h-1;
+    if (minx > maxx || miny > maxy) return;
+
+    if (b->ntris == b->cap) {
+        int cap = b->cap ? b->cap*2 : 4096;
+        SoftTri* tris = (SoftTri*)realloc(b->tris, (size_t)cap*sizeof(SoftTri));
+        if (!tris) return;        // out of memory: the triangle is left out of this frame
+        b->tris = tris; b->cap = cap;
+    }
+    SoftTri* t = &b->tris[b->ntris];
+    for (int i=0;i<3;i++) { t->x[i] = X[i]; t->y[i] = Y[i]; }
+    t->minx = minx; t->maxx = maxx; t->miny = miny; t->maxy = maxy;
+    double dx1 = fx[1]-fx[0], dy1 = fy[1]-fy[0], dx2 = fx[2]-fx[0], dy2 = fy[2]-fy[0];
+    double dz1 = z[1]-z[0], dz2 = z[2]-z[0], den = dx1*dy2 - dx2*dy1;
+    t->fx = fx[0]; t->fy = fy[0]; t->z = z[0];
+    t->dzdx = (float)((dz1*dy2 - dz2*dy1)/den);
+    t->dzdy = (float)((dx1*dz2 - dx2*dz1)/den);
+    t->rgba = rgba;
+    for (int ty=miny/SOFT_TILE; ty<=maxy/SOFT_TILE; ty++)
+        for (int tx=minx/SOFT_TILE; tx<=maxx/SOFT_TILE; tx++)
+            bin_push(&b->bins[ty*s->tiles_x + tx], b->ntris);
+    b->ntris++;
+}
+
+// Signed distance of clip-space v to plane p: near (z >= -w), then the guard band.
+static float plane_dist(const Vector4* v, int p) {
+    switch (p) {
+        case 0:  return v->z + v->w;
+        case 1:  return SOFT_GUARD*v->w - v->x;
+        case 2:  return SOFT_GUARD*v->w + v->x;
+        case 3:  return SOFT_GUARD*v->w - v->y;
+        default: return SOFT_GUARD*v->w + v->y;
+    }
+}
+
+static void submit_tri(SoftRaster* s, SoftBin* b, const Vector4 v[3], uint32_t rgba) {
+    unsigned out[3] = { 0, 0, 0 };
+    for (int i=0;i<3;i++)
+        for (int p=0;p<5;p++) if (plane_dist(&v[i], p) < 0) out[i] |= 1u<<p;
+    if (out[0] & out[1] & out[2]) return;   // all outside one plane
+    if (!(out[0] | out[1] | out[2])) { emit_tri(s, b, v, rgba); return; }
+
+    // Sutherland-Hodgman against the planes crossed, then a fan
+    Vector4 poly[2][8];
+    int n = 3, cur = 0;
+    for (int i=0;i<3;i++) poly[0][i] = v[i];
+    unsigned crossed = out[0] | out[1] | out[2];
+    for (int p=0; p<5 && n>=3; p++) {
+        if (!(crossed & (1u<<p))) continue;
+        Vector4* in = poly[cur]; Vector4* o = poly[cur^1];
+        int m = 0;
+        for (int i=0;i<n;i++) {
+            const Vector4 *a = &in[i], *c = &in[(i+1)%n];
+            float da = plane_dist(a, p), dc = plane_dist(c, p);
+            if (da >= 0) o[m++] = *a;
+            if ((da >= 0) != (dc >= 0)) {
+                float t = da/(da - dc);
+                o[m++] = (Vector4){ a->x + (c->x-a->x)*t, a->y + (c->y-a->y)*t,
+                                    a->z + (c->z-a->z)*t, a->w + (c->w-a->w)*t };
+            }
+        }
+        n = m; cur ^= 1;
+    }
+    for (int i=1; i+1<n; i++) {
+        Vector4 t[3] = { poly[cur][0], poly[cur][i], poly[cur][i+1] };
+        emit_tri(s, b, t, rgba);
+    }
+}
+
+static void setup_job(SoftRaster* s, int worker) {
+    SoftBin* b = &s->bins[worker];
+    const World* w = &s->e->world;
+    const Matrix* m = &s->vp;
+    b->ntris = 0; b->chunks = 0; b->triangles = 0;
+    for (int i=0; i<s->tiles_x*s->tiles_y; i++) b->bins[i].n = 0;
+    int i0 = (int)((int64_t)s->nvis*worker/s->nthreads), i1 = (int)((int64_t)s->nvis*(worker+1)/s->nthreads);
+    for (int i=i0; i<i1; i++) {
+        const Mesh* mesh = s->meshes[i];
+        if (!mesh) continue;
+        int ci = s->e->vis[i].ci;
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        float ox = cx*CHUNK_SIZE-0.5f, oy = cy*CHUNK_SIZE-0.5f, oz = cz*CHUNK_SIZE-0.5f;
+        b->chunks++;
+        b->triangles += mesh->triangleCount;
+        for (int k=0; k+2<mesh->vertexCount; k+=3) {
+            Vector4 c[3];
+            for (int j=0;j<3;j++) {
+                const float* p = &mesh->vertices[(k+j)*3];
+                float x = p[0]+ox, y = p[1]+oy, z = p[2]+oz;
+                c[j] = (Vector4){ m->m0*x + m->m4*y + m->m8*z  + m->m12,
+                                  m->m1*x + m->m5*y + m->m9*z  + m->m13,
+                                  m->m2*x + m->m6*y + m->m10*z + m->m14,
+                                  m->m3*x + m->m7*y + m->m11*z + m->m15 };
+            }
+            uint32_t rgba;
+            memcpy(&rgba, &mesh->colors[k*4], 4);   // flat: one colour per face
+            submit_tri(s, b, c, rgba);
+        }
+    }
+}
+
+// ---------- raster ----------
+
+// Rasterize t over pixels [x0,x1) x [y0,y1) (its box clipped to one tile).
+static void raster_tri(SoftRaster* s, const SoftTri* t, int x0, int y0, int x1, int y1) {
+    int32_t e[3], sx[3], sy[3];
+    for (int k=0;k<3;k++) {
+        int a = k, c = (k+1)%3;
+        int64_t A = (int64_t)t->y[a] - t->y[c], B = (int64_t)t->x[c] - t->x[a];
+        int64_t E = B*((int64_t)y0*SOFT_SUB + SOFT_SUB/2 - t->y[a]) + A*((int64_t)x0*SOFT_SUB + SOFT_SUB/2 - t->x[a]);
+        if (!(A > 0 || (A == 0 && B > 0))) E -= 1;          // top-left rule: other edges own no pixel centres
+        int64_t stx = A*SOFT_SUB, sty = B*SOFT_SUB;
+        int64_t rx = stx*(x1-1-x0), ry = sty*(y1-1-y0);
+        int64_t lo = E + (rx < 0 ? rx : 0) + (ry < 0 ? ry : 0);
+        int64_t hi = E + (rx > 0 ? rx : 0) + (ry > 0 ? ry : 0);
+        if (hi < 0) return;                                  // the rect is outside this edge
+        if (lo >= 0) { E = 0; stx = 0; sty = 0; }            // ... or inside: skip the test
+        e[k] = (int32_t)E; sx[k] = (int32_t)stx; sy[k] = (int32_t)sty;   // |E| < 2^31 inside the guard band
+    }
+    float zrow = t->z + t->dzdx*(x0 + 0.5f - t->fx) + t->dzdy*(y0 + 0.5f - t->fy);
+#ifdef SOFT_SSE2
+    __m128i off[3], step[3];
+    for (int k=0;k<3;k++) {
+        off[k]  = _mm_setr_epi32(0, sx[k], 2*sx[k], 3*sx[k]);
+        step[k] = _mm_set1_epi32(4*sx[k]);
+    }
+    const __m128  zoff = _mm_setr_ps(0, t->dzdx, 2*t->dzdx, 3*t->dzdx);
+    const __m128i col  = _mm_set1_epi32((int)t->rgba), neg1 = _mm_set1_epi32(-1);
+#endif
+    for (int y=y0; y<y1; y++) {
+        uint32_t* crow = s->color + (size_t)y*s->w;
+        float*    drow = s->depth + (size_t)y*s->w;
+        int x = x0;
+#ifdef SOFT_SSE2
+        __m128i w0 = _mm_add_epi32(_mm_set1_epi32(e[0]), off[0]);
+        __m128i w1 = _mm_add_epi32(_mm_set1_epi32(e[1]), off[1]);
+        __m128i w2 = _mm_add_epi32(_mm_set1_epi32(e[2]), off[2]);
+        for (; x+4 <= x1; x+=4) {
+            __m128i in = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(w0, w1), w2), neg1);   // all three >= 0
+            w0 = _mm_add_epi32(w0, step[0]); w1 = _mm_add_epi32(w1, step[1]); w2 = _mm_add_epi32(w2, step[2]);
+            if (!_mm_movemask_epi8(in)) continue;
+            __m128 z = _mm_add_ps(_mm_set1_ps(zrow + t->dzdx*(float)(x-x0)), zoff);
+            __m128 d = _mm_loadu_ps(drow + x);
+            __m128i m = _mm_and_si128(in, _mm_castps_si128(_mm_cmplt_ps(z, d)));
+            if (!_mm_movemask_epi8(m)) continue;
+            __m128 mf = _mm_castsi128_ps(m);
+            _mm_storeu_ps(drow + x, _mm_or_ps(_mm_and_ps(mf, z), _mm_andnot_ps(mf, d)));
+            __m128i c = _mm_loadu_si128((const __m128i*)(crow + x));
+            _mm_storeu_si128((__m128i*)(crow + x), _mm_or_si128(_mm_and_si128(m, col), _mm_andnot_si128(m, c)));
+        }
+#endif
+        for (; x<x1; x++) {
+            int32_t dx = x - x0;
+            if ((e[0] + dx*sx[0]) < 0 || (e[1] + dx*sx[1]) < 0 || (e[2] + dx*sx[2]) < 0) continue;
+            float z = zrow + t->dzdx*(float)dx;
+            if (z < drow[x]) { drow[x] = z; crow[x] = t->rgba; }
+        }
+        for (int k=0;k<3;k++) e[k] += sy[k];
+        zrow += t->dzdy;
+    }
+}
+
+static void raster_job(SoftRaster* s, int worker) {
+    (void)worker;
+    int ntiles = s->tiles_x*s->tiles_y;
+    for (;;) {
+        int tile = atomic_fetch_add(&s->next_tile, 1);
+        if (tile >= ntiles) break;
+        int x0 = (tile % s->tiles_x)*SOFT_TILE, y0 = (tile / s->tiles_x)*SOFT_TILE;
+        int x1 = x0+SOFT_TILE < s->w ? x0+SOFT_TILE : s->w;
+        int y1 = y0+SOFT_TILE < s->h ? y0+SOFT_TILE : s->h;
+        for (int y=y0; y<y1; y++)
+            for (int x=x0; x<x1; x++) { s->color[(size_t)y*s->w + x] = SOFT_CLEAR; s->depth[(size_t)y*s->w + x] = 1.0f; }
+        for (int b=0; b<s->nthreads; b++) {
+            const SoftBin* bin = &s->bins[b];
+            const SoftList* l = &bin->bins[tile];
+            for (int i=0;i<l->n;i++) {
+                const SoftTri* t = &bin->tris[l->idx[i]];
+                raster_tri(s, t, t->minx > x0 ? t->minx : x0, t->miny > y0 ? t->miny : y0,
+                                 t->maxx+1 < x1 ? t->maxx+1 : x1, t->maxy+1 < y1 ? t->maxy+1 : y1);
+            }
+        }
+    }
+}
+
+// ---------- worker pool ----------
+
+#ifndef _WIN32
+static void* worker_main(void* arg) {
+    SoftRaster* s = ((SoftWorker*)arg)->s;
+    int id = ((SoftWorker*)arg)->id;
+    unsigned seen = 0;
+    pthread_mutex_lock(&s->mu);
+    for (;;) {
+        while (s->gen == seen && !s->quit) pthread_cond_wait(&s->go, &s->mu);
+        if (s->quit) break;
+        seen = s->gen;
+        void (*job)(SoftRaster*, int) = s->job;
+        pthread_mutex_unlock(&s->mu);
+        job(s, id);
+        pthread_mutex_lock(&s->mu);
+        if (--s->busy == 0) pthread_cond_signal(&s->done);
+    }
+    pthread_mutex_unlock(&s->mu);
+    return NULL;
+}
+#endif
+
+// Run job on every worker (this thread is worker 0) and wait for all of them.
+static void run_job(SoftRaster* s, void (*job)(SoftRaster*, int)) {
+#ifndef _WIN32
+    if (s->nthreads > 1) {
+        pthread_mutex_lock(&s->mu);
+        s->job = job;
+        s->busy = s->nthreads - 1;
+        s->gen++;
+        pthread_cond_broadcast(&s->go);
+        pthread_mutex_unlock(&s->mu);
+        job(s, 0);
+        pthread_mutex_lock(&s->mu);
+        while (s->busy) pthread_cond_wait(&s->done, &s->mu);
+        pthread_mutex_unlock(&s->mu);
+        return;
+    }
+#endif
+    job(s, 0);
+}
+
+static int default_threads(void) {
+#ifndef _WIN32
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : n > SOFT_MAX_THREADS ? SOFT_MAX_THREADS : (int)n;
+#else
+    return 1;
+#endif
+}
+
+static void soft_destroy(SoftRaster* s) {
+#ifndef _WIN32
+    if (s->threads) {
+        pthread_mutex_lock(&s->mu);
+        s->quit = true;
+        pthread_cond_broadcast(&s->go);
+        pthread_mutex_unlock(&s->mu);
+        for (int i=0; i<s->nthreads-1; i++) pthread_join(s->threads[i], NULL);
+        pthread_mutex_destroy(&s->mu);
+        pthread_cond_destroy(&s->go);
+        pthread_cond_destroy(&s->done);
+        free(s->threads);
+        free(s->workers);
+    }
+#endif
+    if (s->bins) {
+        for (int b=0; b<s->nbins; b++) {
+            if (s->bins[b].bins)
+                for (int i=0; i<s->tiles_x*s->tiles_y; i++) free(s->bins[b].bins[i].idx);
+            free(s->bins[b].bins);
+            free(s->bins[b].tris);
+        }
+        free(s->bins);
+    }
+    if (s->tex_loaded) UnloadTexture(s->tex);
+    free(s->meshes);
+    free(s->color);
+    free(s->depth);
+    free(s);
+}
+
+static SoftRaster* soft_create(int w, int h, int nthreads) {
+    SoftRaster* s = (SoftRaster*)calloc(1, sizeof(SoftRaster));
+    if (!s) return NULL;
+    s->w = w; s->h = h;
+    s->tiles_x = (w + SOFT_TILE-1)/SOFT_TILE;
+    s->tiles_y = (h + SOFT_TILE-1)/SOFT_TILE;
+    s->nthreads = nthreads;
+    s->color = (uint32_t*)malloc((size_t)w*h*sizeof(uint32_t));
+    s->depth = (float*)malloc((size_t)w*h*sizeof(float));
+    s->bins = (SoftBin*)calloc((size_t)nthreads, sizeof(SoftBin));
+    if (!s->color || !s->depth || !s->bins) { soft_destroy(s); return NULL; }
+    s->nbins = nthreads;
+    for (int b=0; b<nthreads; b++) {
+        s->bins[b].bins = (SoftList*)calloc((size_t)s->tiles_x*s->tiles_y, sizeof(SoftList));
+        if (!s->bins[b].bins) { soft_destroy(s); return NULL; }
+    }
+#ifndef _WIN32
+    if (nthreads > 1) {
+        s->threads = (pthread_t*)calloc((size_t)nthreads-1, sizeof(pthread_t));
+        s->workers = (SoftWorker*)calloc((size_t)nthreads-1, sizeof(SoftWorker));
+        if (!s->threads || !s->workers) {   // out of memory: run on this thread alone
+            free(s->threads); free(s->workers);
+            s->threads = NULL; s->workers = NULL;
+            s->nthreads = 1;
+            return s;
+        }
+        pthread_mutex_init(&s->mu, NULL);
+        pthread_cond_init(&s->go, NULL);
+        pthread_cond_init(&s->done, NULL);
+        for (int i=0; i<nthreads-1; i++) {
+            SoftWorker* wk = &s->workers[i];
+            wk->s = s; wk->id = i+1;
+            if (pthread_create(&s->threads[i], NULL, worker_main, wk) != 0) {
+                s->nthreads = i+1;   // run with the workers that did start
+                break;
+            }
+        }
+    }
+#endif
+    return s;
+}
+
+// ---------- engine hooks ----------
+
+void softrast_draw(Engine* e) {
+    if (!e->soft && !engine_set_software_target(e, 0, 0, 0)) return;
+    SoftRaster* s = e->soft;
+    e->chunks_drawn = 0; e->tris_drawn = 0;
+
+    // cull + (re)mesh on this thread, nearest first within the budget, as draw_chunks does
+    int nvis = e->world.chunks && e->atlas.tile_count ? collect_visible_chunks(e) : 0;
+    if (nvis > s->meshes_cap) {
+        const Mesh** meshes = (const Mesh**)realloc(s->meshes, (size_t)nvis*sizeof(const Mesh*));
+        if (!meshes) return;       // out of memory: nothing drawn this frame
+        s->meshes = meshes; s->meshes_cap = nvis;
+    }
+    int budget = e->mesh_budget;
+    for (int i=0;i<nvis;i++) s->meshes[i] = chunk_draw_mesh(e, &e->vis[i], &budget);
+
+    s->e = e;
+    s->vp = camera_view_proj(e);
+    s->nvis = nvis;
+    run_job(s, setup_job);
+    atomic_store(&s->next_tile, 0);
+    run_job(s, raster_job);
+    s->frames++;
+    for (int b=0; b<s->nthreads; b++) {
+        e->chunks_drawn += s->bins[b].chunks;
+        e->tris_drawn   += s->bins[b].triangles;
+    }
+    e->cur.draw_calls += e->chunks_drawn;
+
+    if (e->headless) return;
+    if (!s->tex_loaded) {
+        Image img = { s->color, s->w, s->h, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        s->tex = LoadTextureFromImage(img);
+        s->tex_loaded = true;
+    } else {
+        UpdateTexture(s->tex, s->color);
+    }
+    DrawTexturePro(s->tex, (Rectangle){ 0, 0, (float)s->w, (float)s->h },
+                   (Rectangle){ 0, 0, (float)e->screen_w, (float)e->screen_h }, (Vector2){ 0, 0 }, 0, WHITE);
+}
+
+void softrast_free(Engine* e) {
+    if (!e->soft) return;
+    soft_destroy(e->soft);
+    e->soft = NULL;
+}
+
+bool engine_set_software_target(Engine* e, int width, int height, int threads) {
+    if (!e) return false;
+    if (width <= 0 || height <= 0) {   // the window, or 640x360 headless
+        width  = e->screen_w > 0 ? e->screen_w : 640;
+        height = e->screen_h > 0 ? e->screen_h : 360;
+    }
+    if (width > SOFT_MAX_DIM || height > SOFT_MAX_DIM) return false;
+    if (threads <= 0) threads = default_threads();
+    if (threads > SOFT_MAX_THREADS) threads = SOFT_MAX_THREADS;
+    softrast_free(e);
+    e->soft = soft_create(width, height, threads);
+    if (!e->soft) return false;
+    if (e->headless) { e->screen_w = width; e->screen_h = height; }   // culling uses the target's aspect
+    return true;
+}
+
+const uint8_t* engine_get_software_frame(Engine* e, int* width, int* height) {
+    if (!e || !e->soft || !e->soft->frames) return NULL;
+    if (width) *width = e->soft->w;
+    if (height) *height = e->soft->h;
+    return (const uint8_t*)e->soft->color;
+}
+
+bool engine_save_software_frame(Engine* e, const char* path) {
+    int w, h;
+    const uint8_t* px = engine_get_software_frame(e, &w, &h);
+    if (!px || !path) return false;
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    uint8_t* row = (uint8_t*)malloc((size_t)w*3);
+    if (!row) { fclose(f); return false; }
+    for (int y=0; y<h; y++) {
+        for (int x=0; x<w; x++) memcpy(row + x*3, px + ((size_t)y*w + x)*4, 3);
+        fwrite(row, 1, (size_t)w*3, f);
+    }
+    free(row);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,103 @@
+// stats.c — frame profiling: monotonic timer, per-frame stats ring, memory report.
+#define _POSIX_C_SOURCE 200809L
+#include "engine_internal.h"
+
+#ifdef _WIN32
+// declared by hand: <windows.h> clashes with raylib names (Rectangle, DrawText, ...)
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(long long* count);
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(long long* freq);
+__declspec(dllimport) void __stdcall Sleep(unsigned long ms);
+#else
+#include <time.h>
+#endif
+
+double stats_now(void) {
+#ifdef _WIN32
+    static long long freq = 0;
+    long long c;
+    if (!freq) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (double)c / (double)freq;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+#endif
+}
+
+void stats_sleep_until(double t) {
+    double d = t - stats_now();
+    if (d <= 0) return;
+#ifdef _WIN32
+    Sleep((unsigned long)(d*1000.0));
+#else
+    struct timespec ts = { (time_t)d, (long)((d - (double)(time_t)d)*1e9) };
+    while (nanosleep(&ts, &ts) != 0) {}   // EINTR: sleep the rest
+#endif
+}
+
+void stats_end_frame(Engine* e) {
+    EngineFrameStats* s = &e->cur;
+    s->frame           = e->stats_frames;
+    s->triangles       = e->tris_drawn;
+    s->chunks_drawn    = e->chunks_drawn;
+    s->chunks_occluded = e->chunks_occluded;
+    if (e->stats_ring) e->stats_ring[e->stats_frames % STATS_RING] = *s;
+    e->stats_frames++;
+    memset(s, 0, sizeof(*s));
+}
+
+bool engine_get_stats(Engine* e, EngineFrameStats* out) {
+    if (!e || !out || !e->stats_ring || !e->stats_frames) return false;
+    *out = e->stats_ring[(e->stats_frames-1) % STATS_RING];
+    return true;
+}
+
+int engine_get_stats_history(Engine* e, EngineFrameStats* out, int max) {
+    if (!e || !out || max <= 0 || !e->stats_ring) return 0;
+    uint64_t have = e->stats_frames < STATS_RING ? e->stats_frames : STATS_RING;
+    int n = (uint64_t)max < have ? max : (int)have;
+    uint64_t first = e->stats_frames - (uint64_t)n;
+    for (int i=0;i<n;i++) out[i] = e->stats_ring[(first + i) % STATS_RING];
+    return n;
+}
+
+static int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+bool engine_get_frame_percentiles(Engine* e, float* p50, float* p95, float* p99) {
+    if (!e || !e->stats_ring || !e->stats_frames) return false;
+    int n = e->stats_frames < STATS_RING ? (int)e->stats_frames : STATS_RING;
+    float v[STATS_RING];
+    for (int i=0;i<n;i++) v[i] = e->stats_ring[i].frame_ms;
+    qsort(v, n, sizeof(float), cmp_float);
+    // nearest-rank
+    if (p50) *p50 = v[(n-1)*50/100];
+    if (p95) *p95 = v[(n-1)*95/100];
+    if (p99) *p99 = v[(n-1)*99/100];
+    return true;
+}
+
+void engine_get_memory_stats(Engine* e, EngineMemoryStats* out) {
+    if (!e || !out) return;
+    memset(out, 0, sizeof(*out));
+    const World* w = &e->world;
+    int n = w->ncx*w->ncy*w->ncz;
+    out->world_bytes = (uint64_t)w->sx*w->sy*w->sz*sizeof(uint16_t);
+    if (w->chunks) {
+        out->chunk_bytes = (uint64_t)n*(sizeof(Chunk) + sizeof(VisChunk));
+        if (e->vg_stamp) out->chunk_bytes += (uint64_t)n*(sizeof(uint32_t) + 2);
+        for (int i=0;i<n;i++) {
+            const Chunk* c = &w->chunks[i];
+            for (int l=0;l<LOD_LEVELS;l++)
+                out->mesh_bytes += (uint64_t)c->mesh[l].vertexCount*(3*sizeof(float) + 4);
+            out->instance_bytes += (uint64_t)c->inst_count*sizeof(float16) + (uint64_t)c->inst_nruns*sizeof(InstRun);
+        }
+    }
+    if (e->occ_depth) out->chunk_bytes += OCC_W*OCC_H*sizeof(float);
+    if (e->occ_corner) out->chunk_bytes += (OCC_W+1)*(OCC_H+1)*sizeof(float);
+    out->instance_bytes += (uint64_t)e->inst_stage_cap*sizeof(float16);
+    out->stats_bytes = e->stats_ring ? STATS_RING*sizeof(EngineFrameStats) : 0;
+}
@@ -1,4 +1,4 @@
-import ctypes as C, time, os, sys
+import ctypes as C, os, sys
 
 # load the shared lib (adjust name per-OS)
 if sys.platform == "darwin":
@@ -26,6 +26,27 @@ lib.engine_fill_box.argtypes = [C.c_void_p, C.c_int,C.c_int,C.c_int, C.c_int,C.c
 lib.engine_tick.argtypes = [C.c_void_p, C.c_float]
 lib.engine_tick.restype  = C.c_bool
 
+# per-frame stats (mirror of EngineFrameStats in engine.h)
+class FrameStats(C.Structure):
+    _fields_ = [("frame", C.c_uint64)] + \
+               [(n, C.c_float) for n in ("input_ms", "physics_ms", "cull_ms", "mesh_ms",
+                                          "upload_ms", "draw_ms", "present_ms", "frame_ms")] + \
+               [(n, C.c_int32) for n in ("draw_calls", "triangles", "chunks_visible",
+                                          "chunks_drawn", "chunks_occluded", "chunks_meshed")]
+lib.engine_get_stats_history.argtypes = [C.c_void_p, C.POINTER(FrameStats), C.c_int]
+lib.engine_get_stats_history.restype  = C.c_int
+
+# outbound events (mirror of EngineEvent in engine.h)
+EV_KEY_DOWN, EV_KEY_UP, EV_MOUSE_DOWN, EV_MOUSE_UP, EV_PLAYER = 1, 2, 3, 4, 5
+class Event(C.Structure):
+    _fields_ = [("type", C.c_uint32), ("frame", C.c_uint32), ("code", C.c_int32)] + \
+               [(n, C.c_float) for n in ("x", "y", "z", "yaw", "pitch")]
+lib.engine_poll_events.argtypes = [C.c_void_p, C.POINTER(Event), C.c_int]
+lib.engine_poll_events.restype  = C.c_int
+
+RunCallback = C.CFUNCTYPE(C.c_bool, C.c_void_p)
+lib.engine_run.argtypes = [C.c_void_p, RunCallback, C.c_float]
+
 # create engine
 e = lib.engine_create(1280, 720, b"Mini3D - Python drives C", 60)
 
@@ -46,13 +67,34 @@ lib.engine_fill_box(e, 10,1,10, 10,5,10, 5) # stone pillar
 lib.engine_fill_box(e, 20,1,20, 22,3,22, 3) # dirt lump
 lib.engine_fill_box(e, 30,1,15, 30,8,15, 7) # snow post
 
-# run loop: let C do input & rendering; Python just calls tick
-prev = time.perf_counter()
-while True:
-    now = time.perf_counter()
-    dt = now - prev
-    prev = now
-    if not lib.engine_tick(e, C.c_float(dt)):
-        break
+# run loop: C owns the frame loop (engine_run); Python only wakes up 20x a second
+# to drain events, so interpreter overhead never lands on frame pacing
+events = (Event * 64)()
+player = [0.0, 0.0, 0.0]
+
+@RunCallback
+def on_tick(engine):
+    while True:
+        n = lib.engine_poll_events(engine, events, 64)
+        for i in range(n):
+            ev = events[i]
+            if ev.type == EV_PLAYER:
+                player[:] = (ev.x, ev.y, ev.z)
+            elif ev.type == EV_KEY_DOWN and ev.code == ord('P'):
+                print("player at (%.1f, %.1f, %.1f)" % tuple(player))
+            elif ev.type == EV_MOUSE_DOWN:
+                print(f"click button {ev.code} at ({ev.x:.0f}, {ev.y:.0f})")
+        if n < 64:
+            return True   # keep running
+
+lib.engine_run(e, on_tick, 20.0)
+
+# one FFI call pulls the last 1024 frames; summarize per stage
+hist = (FrameStats * 1024)()
+n = lib.engine_get_stats_history(e, hist, 1024)
+if n:
+    for stage in ("input_ms", "physics_ms", "cull_ms", "mesh_ms", "upload_ms", "draw_ms", "frame_ms"):
+        v = sorted(getattr(hist[i], stage) for i in range(n))
+        print(f"{stage:>10}: p50 {v[n//2]:.2f}  p95 {v[int(n*0.95)]:.2f}  p99 {v[int(n*0.99)]:.2f}")
 
 lib.engine_destroy(e)
@@ -0,0 +1,127 @@
+// visgraph.c — cave culling: chunk face connectivity + BFS from the camera chunk.
+//
+// For every chunk we flood-fill its air and record which pairs of faces are
+// joined by a connected air region (conn[]). Each frame a BFS starts at the
+// camera chunk and only steps from face A into a neighbour through face B when
+// the current chunk connects A and B, never back towards the camera, and only
+// into chunks inside the frustum. Chunks behind solid ground or in sealed caves
+// are never reached, so they are never meshed or drawn.
+#include "engine_internal.h"
+#include <math.h>
+
+static const int kDir[6][3] = {
+    { 1,0,0}, {-1,0,0}, {0, 1,0}, {0,-1,0}, {0,0, 1}, {0,0,-1}
+};
+
+// Flood-fill the air of chunk ci and rebuild its conn[] table.
+static void chunk_build_conn(World* w, int ci) {
+    Chunk* c = &w->chunks[ci];
+    int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+    int x0 = cx*CHUNK_SIZE, y0 = cy*CHUNK_SIZE, z0 = cz*CHUNK_SIZE;
+    int nx = w->sx - x0 < CHUNK_SIZE ? w->sx - x0 : CHUNK_SIZE;
+    int ny = w->sy - y0 < CHUNK_SIZE ? w->sy - y0 : CHUNK_SIZE;
+    int nz = w->sz - z0 < CHUNK_SIZE ? w->sz - z0 : CHUNK_SIZE;
+
+    static uint8_t seen[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    static uint16_t stack[CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE];
+    memset(c->conn, 0, sizeof(c->conn));
+
+    // solid voxels count as seen, so the fill only walks air
+    int air = 0;
+    for (int z=0; z<nz; z++)
+    for (int y=0; y<ny; y++)
+    for (int x=0; x<nx; x++) {
+        int li = x + y*CHUNK_SIZE + z*CHUNK_SIZE*CHUNK_SIZE;
+        seen[li] = w->v[idx3D(w, x0+x, y0+y, z0+z)] != 0;
+        air += !seen[li];
+    }
+    if (!air) return;
+    if (air == nx*ny*nz) { memset(c->conn, 0x3F, sizeof(c->conn)); return; }
+
+    for (int z=0; z<nz; z++)
+    for (int y=0; y<ny; y++)
+    for (int x=0; x<nx; x++) {
+        int start = x + y*CHUNK_SIZE + z*CHUNK_SIZE*CHUNK_SIZE;
+        if (seen[start]) continue;
+        uint8_t faces = 0;
+        int sp = 0;
+        stack[sp++] = (uint16_t)start; seen[start] = 1;
+        while (sp) {
+            int li = stack[--sp];
+            int lx = li % CHUNK_SIZE, ly = (li / CHUNK_SIZE) % CHUNK_SIZE, lz = li / (CHUNK_SIZE*CHUNK_SIZE);
+            if (lx == nx-1) faces |= 1u<<FACE_PX;
+            if (lx == 0)    faces |= 1u<<FACE_NX;
+            if (ly == ny-1) faces |= 1u<<FACE_PY;
+            if (ly == 0)    faces |= 1u<<FACE_NY;
+            if (lz == nz-1) faces |= 1u<<FACE_PZ;
+            if (lz == 0)    faces |= 1u<<FACE_NZ;
+            for (int d=0; d<6; d++) {
+                int ax = lx+kDir[d][0], ay = ly+kDir[d][1], az = lz+kDir[d][2];
+                if (ax<0 || ay<0 || az<0 || ax>=nx || ay>=ny || az>=nz) continue;
+                int ni = ax + ay*CHUNK_SIZE + az*CHUNK_SIZE*CHUNK_SIZE;
+                if (seen[ni]) continue;
+                seen[ni] = 1;
+                stack[sp++] = (uint16_t)ni;
+            }
+        }
+        for (int a=0; a<6; a++) if (faces & (1u<<a)) c->conn[a] |= faces;
+    }
+}
+
+void visgraph_free(Engine* e) {
+    free(e->vg_stamp); e->vg_stamp = NULL;
+    free(e->vg_from);  e->vg_from = NULL;
+    free(e->vg_dirs);  e->vg_dirs = NULL;
+}
+
+int visgraph_collect(Engine* e, const Vector4 planes[6]) {
+    World* w = &e->world;
+    // camera chunk (voxel centres are integers, chunk c covers [cS-0.5, cS+S-0.5))
+    int ccx = (int)floorf((e->view.cam.position.x + 0.5f) / CHUNK_SIZE);
+    int ccy = (int)floorf((e->view.cam.position.y + 0.5f) / CHUNK_SIZE);
+    int ccz = (int)floorf((e->view.cam.position.z + 0.5f) / CHUNK_SIZE);
+    if (ccx<0 || ccy<0 || ccz<0 || ccx>=w->ncx || ccy>=w->ncy || ccz>=w->ncz) return -1;
+
+    int n = w->ncx*w->ncy*w->ncz;
+    if (!e->vg_stamp) {
+        e->vg_stamp = (uint32_t*)calloc(n, sizeof(uint32_t));
+        e->vg_from  = (uint8_t*)malloc(n);
+        e->vg_dirs  = (uint8_t*)malloc(n);
+        e->vg_frame = 0;
+        if (!e->vg_stamp || !e->vg_from || !e->vg_dirs) { visgraph_free(e); return -1; }   // per-chunk scan instead
+    }
+    if (++e->vg_frame == 0) { memset(e->vg_stamp, 0, n*sizeof(uint32_t)); e->vg_frame = 1; }
+
+    // e->vis doubles as the BFS queue: a chunk is appended once it passes the view test
+    int nvis = 0;
+    if (!chunk_view_test(e, planes, ccx,ccy,ccz, &e->vis[0])) return 0;
+    int start = e->vis[nvis++].ci;
+    e->vg_stamp[start] = e->vg_frame;
+    e->vg_from[start] = 6;             // no entry face: every exit is open
+    e->vg_dirs[start] = 0;
+
+    for (int head = 0; head < nvis; head++) {
+        int ci = e->vis[head].ci;
+        int cx = ci % w->ncx, cy = (ci / w->ncx) % w->ncy, cz = ci / (w->ncx*w->ncy);
+        Chunk* c = &w->chunks[ci];
+        if (c->stale & CHUNK_VISGRAPH_BIT) {
+            c->stale &= (uint8_t)~CHUNK_VISGRAPH_BIT;   // first: an edit landing while it reads marks it again
+            chunk_build_conn(w, ci);
+        }
+        uint8_t from = e->vg_from[ci], dirs = e->vg_dirs[ci];
+        for (int d=0; d<6; d++) {
+            if (dirs & (1u<<(d^1))) continue;                           // never head back
+            if (from != 6 && !(c->conn[from] & (1u<<d))) continue;      // no air path from -> d
+            int nx = cx+kDir[d][0], ny = cy+kDir[d][1], nz = cz+kDir[d][2];
+            if (nx<0 || ny<0 || nz<0 || nx>=w->ncx || ny>=w->ncy || nz>=w->ncz) continue;
+            int ni = chunkIndex(w, nx,ny,nz);
+            if (e->vg_stamp[ni] == e->vg_frame) continue;
+            e->vg_stamp[ni] = e->vg_frame;
+            if (!chunk_view_test(e, planes, nx,ny,nz, &e->vis[nvis])) continue;
+            e->vg_from[ni] = (uint8_t)(d^1);
+            e->vg_dirs[ni] = (uint8_t)(dirs | (1u<<d));
+            nvis++;
+        }
+    }
+    return nvis;
+}